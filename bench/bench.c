@@ -0,0 +1,291 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "bench.h"
+
+#include <libchula-qa/libchula-qa.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_REPETITIONS 5
+#define DEFAULT_SITES       5
+#define QUICK_DIVISOR       100
+
+volatile uint64_t bench_sink = 0;
+
+static chula_mem_mgr_t            mgr;
+static chula_mem_policy_profile_t profile;
+
+typedef struct {
+    bool          json;
+    bool          quick;
+    unsigned int  repetitions;
+    const char   *filter;
+    double        budget;      /**< Allocations per operation allowed. Negative: no budget. */
+    unsigned int  sites;       /**< Allocation sites reported per benchmark. Zero: none. */
+} options_t;
+
+typedef struct {
+    uint64_t iterations;
+    double   ns_per_op;
+    double   bytes_per_sec;
+    double   allocs_per_op;
+    double   alloc_bytes_per_op;
+    bool     over_budget;
+} result_t;
+
+
+static uint64_t
+now_ns (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void
+report_sites (bench_t *bench, options_t *opts, uint64_t iterations)
+{
+    chula_buffer_t buf = CHULA_BUF_INIT;
+
+    chula_mem_mgr_freeze (&mgr);
+
+    chula_buffer_add_va (&buf, "%s: allocation sites over %llu operations\n",
+                         bench->name, (unsigned long long) iterations);
+    chula_mem_policy_profile_repr (&profile, opts->sites, &buf);
+
+    fprintf (opts->json ? stderr : stdout, "%s", buf.buf);
+    chula_buffer_mrproper (&buf);
+
+    chula_mem_mgr_thaw (&mgr);
+}
+
+static ret_t
+measure (bench_t *bench, options_t *opts, result_t *result)
+{
+    ret_t    ret;
+    uint64_t start;
+    uint64_t elapsed;
+    uint64_t best   = UINT64_MAX;
+    uint32_t allocs = 0;
+    uint64_t bytes  = 0;
+
+    result->iterations = bench->iterations;
+    if (opts->quick) {
+        result->iterations = (bench->iterations / QUICK_DIVISOR) + 1;
+    }
+
+    if (bench->setup != NULL) {
+        ret = bench->setup (bench, result->iterations);
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    /* Warm up: caches, branch predictors and buffer sizes */
+    ret = bench->run (bench, (result->iterations / 10) + 1);
+    if (unlikely (ret != ret_ok)) goto out;
+
+    /* Best of N repetitions. Allocations of the first one only: the
+     * sites are tracked (slowly) during that repetition as well.
+     */
+    for (unsigned int r=0; r < opts->repetitions; r++) {
+        profile.track_sites = ((r == 0) && (opts->sites > 0));
+        chula_mem_policy_profile_reset (&profile);
+
+        start = now_ns();
+        ret = bench->run (bench, result->iterations);
+        elapsed = now_ns() - start;
+
+        if (unlikely (ret != ret_ok)) goto out;
+
+        if (elapsed < best) {
+            best = elapsed;
+        }
+        if (r == 0) {
+            allocs = profile.counter.n_malloc + profile.counter.n_realloc;
+            bytes  = profile.counter.n_bytes;
+
+            if (profile.track_sites) {
+                report_sites (bench, opts, result->iterations);
+            }
+        }
+    }
+
+    profile.track_sites = false;
+
+    if (best == 0) {
+        best = 1;
+    }
+
+    result->ns_per_op     = (double)best / result->iterations;
+    result->bytes_per_sec = ((double)bench->bytes * result->iterations * 1e9) / best;
+    result->allocs_per_op = (double)allocs / result->iterations;
+    result->alloc_bytes_per_op = (double)bytes / result->iterations;
+    result->over_budget   = ((opts->budget >= 0) && (result->allocs_per_op > opts->budget));
+
+out:
+    if (bench->teardown != NULL) {
+        bench->teardown (bench, result->iterations);
+    }
+
+    return ret;
+}
+
+static void
+report (bench_t *bench, options_t *opts, result_t *result, bool first)
+{
+    if (opts->json) {
+        printf ("%s\n    {\"name\": \"%s\", \"group\": \"%s\", \"iterations\": %llu, "
+                "\"bytes_per_op\": %llu, \"ns_per_op\": %.3f, \"bytes_per_sec\": %.0f, "
+                "\"allocs_per_op\": %.3f, \"alloc_bytes_per_op\": %.1f, \"over_budget\": %s}",
+                first ? "" : ",",
+                bench->name, bench->group,
+                (unsigned long long) result->iterations,
+                (unsigned long long) bench->bytes,
+                result->ns_per_op, result->bytes_per_sec, result->allocs_per_op,
+                result->alloc_bytes_per_op, result->over_budget ? "true" : "false");
+        return;
+    }
+
+    printf ("%-6s %-22s %10llu %12.2f %12.2f %10.3f %12.1f%s\n",
+            bench->group, bench->name,
+            (unsigned long long) result->iterations,
+            result->ns_per_op,
+            result->bytes_per_sec / (1024.0 * 1024.0),
+            result->allocs_per_op,
+            result->alloc_bytes_per_op,
+            result->over_budget ? "  OVER BUDGET" : "");
+}
+
+static int
+run_all (bench_t *benchs, options_t *opts, bool *first)
+{
+    ret_t    ret;
+    int      re = 0;
+    result_t result;
+
+    for (bench_t *b = benchs; b->name != NULL; b++) {
+        if ((opts->filter != NULL) && (strstr (b->name, opts->filter) == NULL)) {
+            continue;
+        }
+
+        ret = measure (b, opts, &result);
+        if (unlikely (ret != ret_ok)) {
+            fprintf (stderr, "%s: failed (ret=%d)\n", b->name, ret);
+            re += 1;
+            continue;
+        }
+
+        report (b, opts, &result, *first);
+        *first = false;
+
+        if (result.over_budget) {
+            fprintf (stderr, "%s: %.3f allocs/op over the budget of %.3f\n",
+                     b->name, result.allocs_per_op, opts->budget);
+            re += 1;
+        }
+    }
+
+    return re;
+}
+
+static void
+usage (const char *prog)
+{
+    printf ("Usage: %s [options]\n\n"
+            "  --json          Machine-readable output\n"
+            "  --quick         1/%d of the iterations, single repetition\n"
+            "  --reps=N        Repetitions of each benchmark (default %d)\n"
+            "  --filter=TEXT   Only benchmarks whose name contains TEXT\n"
+            "  --budget=N      Fail when a benchmark makes over N allocs/op\n"
+            "  --sites[=N]     Report the top N allocation sites (default %d)\n"
+            "  --help          This help\n",
+            prog, QUICK_DIVISOR, DEFAULT_REPETITIONS, DEFAULT_SITES);
+}
+
+int
+main (int argc, char *argv[])
+{
+    int       re    = 0;
+    bool      first = true;
+    options_t opts  = {.json = false, .quick = false, .repetitions = DEFAULT_REPETITIONS, .filter = NULL,
+                       .budget = -1, .sites = 0};
+
+    for (int i=1; i < argc; i++) {
+        if (! strcmp (argv[i], "--json")) {
+            opts.json = true;
+        } else if (! strcmp (argv[i], "--quick")) {
+            opts.quick       = true;
+            opts.repetitions = 1;
+        } else if (! strncmp (argv[i], "--reps=", 7)) {
+            opts.repetitions = atoi (argv[i] + 7);
+            if (opts.repetitions < 1) opts.repetitions = 1;
+        } else if (! strncmp (argv[i], "--filter=", 9)) {
+            opts.filter = argv[i] + 9;
+        } else if (! strncmp (argv[i], "--budget=", 9)) {
+            opts.budget = strtod (argv[i] + 9, NULL);
+        } else if (! strcmp (argv[i], "--sites")) {
+            opts.sites = DEFAULT_SITES;
+        } else if (! strncmp (argv[i], "--sites=", 8)) {
+            opts.sites = atoi (argv[i] + 8);
+        } else {
+            usage (argv[0]);
+            return strcmp (argv[i], "--help") ? 1 : 0;
+        }
+    }
+
+    /* Count every allocation from now on */
+    chula_mem_mgr_init (&mgr);
+    chula_mem_policy_profile_init (&profile, false);
+    chula_mem_mgr_set_policy (&mgr, MEM_POLICY(&profile));
+
+    if (opts.json) {
+        printf ("{\n  \"library\": \"libhpack\",\n  \"quick\": %s,\n  \"repetitions\": %u,\n  \"benchmarks\": [",
+                opts.quick ? "true" : "false", opts.repetitions);
+    } else {
+        printf ("%-6s %-22s %10s %12s %12s %10s %12s\n",
+                "group", "benchmark", "iterations", "ns/op", "MB/s", "allocs/op", "alloc B/op");
+    }
+
+    re += run_all (bench_micro, &opts, &first);
+    re += run_all (bench_macro, &opts, &first);
+
+    if (opts.json) {
+        printf ("\n  ]\n}\n");
+    }
+
+    /* The profile policy stays in place: the system policy is only
+     * meaningful on Darwin.
+     */
+    return re;
+}
@@ -0,0 +1,77 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file      bench.h
+ * @brief     Benchmark harness for libhpack.
+ *
+ * Every benchmark runs a fixed number of operations, so two runs of the
+ * same build do the same work. The harness times the run, counts the
+ * allocations through the libchula-qa memory manager and reports ns/op,
+ * bytes/sec and allocations/op.
+ *
+ * @date      October, 2026
+ */
+
+#ifndef LIBHPACK_BENCH_H
+#define LIBHPACK_BENCH_H
+
+#include <libhpack/libhpack.h>
+
+/**
+ * Benchmark being run. @a setup and @a teardown are not timed.
+ */
+typedef struct bench bench_t;
+
+typedef ret_t (*bench_func_t) (bench_t *bench, uint64_t iterations);
+
+struct bench {
+    const char   *name;        /**< Unique name, as reported. */
+    const char   *group;       /**< "micro" or "macro". */
+    uint64_t      iterations;  /**< Operations of a full run. */
+    bench_func_t  setup;       /**< Optional: builds the inputs. */
+    bench_func_t  run;         /**< Runs @a iterations operations. */
+    bench_func_t  teardown;    /**< Optional: frees the inputs. */
+    uint64_t      bytes;       /**< Octets processed by each operation. Set by @a setup. */
+    void         *data;        /**< Private data of the benchmark. */
+};
+
+#define BENCH(g,n,i,s,r,t) \
+    {.name = n, .group = g, .iterations = i, .setup = s, .run = r, .teardown = t, .bytes = 0, .data = NULL}
+
+extern bench_t bench_micro[];
+extern bench_t bench_macro[];
+
+/* Keeps the compiler from optimizing away the benchmarked code */
+extern volatile uint64_t bench_sink;
+
+#endif /* LIBHPACK_BENCH_H */
@@ -0,0 +1,396 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file      decode_scaling.c
+ * @brief     Scaling of the decode service with the number of workers.
+ *
+ * Every connection gets a sequence of request Header Blocks from its own
+ * encoder, so each block depends on the decoding context left by the
+ * previous one. All the blocks are submitted to the decode service,
+ * interleaving the connections, once per number of workers. Decoding
+ * starts with fresh parsers each time.
+ *
+ * @date      October, 2026
+ */
+
+#include <libhpack/libhpack.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_CONNECTIONS 64
+#define DEFAULT_BLOCKS      256
+#define MAX_WORKER_COUNTS   16
+
+#define FIELD(n,v) {n, v}
+
+static const char *request_fields[][2] = {
+    FIELD (":method",          "GET"),
+    FIELD (":scheme",          "https"),
+    FIELD (":authority",       "www.example.com"),
+    FIELD ("user-agent",       "Mozilla/5.0 (X11; Linux x86_64; rv:29.0) Gecko/20100101 Firefox/29.0"),
+    FIELD ("accept",           "text/css,*/*;q=0.1"),
+    FIELD ("accept-language",  "en-US,en;q=0.5"),
+    FIELD ("accept-encoding",  "gzip, deflate"),
+    FIELD ("referer",          "https://www.example.com/index.html"),
+    FIELD ("cookie",           "session=8f14e45fceea167a5a36dedd4bea2543; theme=dark"),
+    FIELD (NULL, NULL)
+};
+
+typedef struct {
+    hpack_header_store_t   store;   /**< First: emit() casts it back to the connection. */
+    hpack_header_parser_t *parser;
+    hpack_decode_lane_t    lane;
+    chula_buffer_t        *blocks;
+    hpack_decode_job_t    *jobs;
+    uint64_t               fields;
+    uint32_t               errors;
+    uint32_t              *done;
+} conn_t;
+
+typedef struct {
+    unsigned int connections;
+    unsigned int blocks;
+    unsigned int num_counts;
+    unsigned int counts[MAX_WORKER_COUNTS];
+    bool         json;
+} options_t;
+
+
+static uint64_t
+now_ns (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Fields are counted, not kept */
+static ret_t
+conn_emit (hpack_header_store_t *store,
+           hpack_header_field_t *field)
+{
+    UNUSED(field);
+
+    ((conn_t *) store)->fields++;
+    return ret_ok;
+}
+
+static void
+conn_decoded (hpack_decode_job_t *job)
+{
+    conn_t *conn = job->data;
+
+    if ((job->ret != ret_ok) || (job->consumed != job->block->len)) {
+        conn->errors++;
+    }
+
+    __atomic_add_fetch (conn->done, 1, __ATOMIC_RELEASE);
+}
+
+static ret_t
+conn_render (conn_t *conn, options_t *opts, unsigned int num)
+{
+    ret_t                  ret;
+    hpack_header_encoder_t enc;
+    chula_buffer_t         name  = CHULA_BUF_INIT;
+    chula_buffer_t         value = CHULA_BUF_INIT;
+    chula_buffer_t         path  = CHULA_BUF_INIT_FAKE(":path");
+
+    conn->blocks = calloc (opts->blocks, sizeof(chula_buffer_t));
+    conn->jobs   = calloc (opts->blocks, sizeof(hpack_decode_job_t));
+    if (unlikely ((conn->blocks == NULL) || (conn->jobs == NULL))) return ret_nomem;
+
+    hpack_header_encoder_init (&enc);
+
+    for (unsigned int b=0; b < opts->blocks; b++) {
+        hpack_header_encoder_clean (&enc);
+
+        for (unsigned int f=0; request_fields[f][0] != NULL; f++) {
+            chula_buffer_clean (&name);
+            chula_buffer_clean (&value);
+            chula_buffer_add (&name,  request_fields[f][0], strlen (request_fields[f][0]));
+            chula_buffer_add (&value, request_fields[f][1], strlen (request_fields[f][1]));
+
+            ret = hpack_header_encoder_add (&enc, &name, &value);
+            if (unlikely (ret != ret_ok)) goto out;
+        }
+
+        /* A different resource each time */
+        chula_buffer_clean (&value);
+        chula_buffer_add_va (&value, "/conn/%u/assets/%u.css", num, b);
+
+        ret = hpack_header_encoder_add (&enc, &path, &value);
+        if (unlikely (ret != ret_ok)) goto out;
+
+        chula_buffer_init (&conn->blocks[b]);
+        ret = hpack_header_encoder_render (&enc, &conn->blocks[b]);
+        if (unlikely (ret != ret_ok)) goto out;
+
+        conn->jobs[b].block = &conn->blocks[b];
+        conn->jobs[b].func  = conn_decoded;
+        conn->jobs[b].data  = conn;
+    }
+
+    ret = ret_ok;
+
+out:
+    hpack_header_encoder_mrproper (&enc);
+    chula_buffer_mrproper (&name);
+    chula_buffer_mrproper (&value);
+    return ret;
+}
+
+static void
+conn_mrproper (conn_t *conn, options_t *opts)
+{
+    if (conn->blocks != NULL) {
+        for (unsigned int b=0; b < opts->blocks; b++) {
+            chula_buffer_mrproper (&conn->blocks[b]);
+        }
+    }
+
+    free (conn->blocks);
+    free (conn->jobs);
+}
+
+static ret_t
+run (conn_t *conns, options_t *opts, unsigned int workers, uint64_t *ns, uint64_t *fields, uint32_t *errors)
+{
+    ret_t                  ret;
+    hpack_decode_service_t service;
+    uint32_t               done  = 0;
+    uint32_t               total = opts->connections * opts->blocks;
+    uint64_t               start;
+
+    ret = hpack_decode_service_init (&service, workers, opts->connections);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    for (unsigned int c=0; c < opts->connections; c++) {
+        conn_t *conn = &conns[c];
+
+        conn->fields = 0;
+        conn->errors = 0;
+        conn->done   = &done;
+
+        hpack_header_store_init (&conn->store);
+        conn->store.emit = conn_emit;
+
+        hpack_header_parser_new (&conn->parser);
+        hpack_header_parser_reg_store (conn->parser, &conn->store);
+
+        hpack_decode_service_add_lane (&service, &conn->lane, conn->parser);
+    }
+
+    start = now_ns();
+
+    for (unsigned int b=0; b < opts->blocks; b++) {
+        for (unsigned int c=0; c < opts->connections; c++) {
+            hpack_decode_service_submit (&service, &conns[c].lane, &conns[c].jobs[b]);
+        }
+    }
+
+    while (__atomic_load_n (&done, __ATOMIC_ACQUIRE) < total) {
+        sched_yield();
+    }
+
+    *ns     = now_ns() - start;
+    *fields = 0;
+    *errors = 0;
+
+    for (unsigned int c=0; c < opts->connections; c++) {
+        conn_t *conn = &conns[c];
+
+        *fields += conn->fields;
+        *errors += conn->errors;
+
+        while (hpack_decode_service_remove_lane (&service, &conn->lane) == ret_eagain) {
+            sched_yield();
+        }
+
+        hpack_header_parser_mrproper (&conn->parser);
+        hpack_header_store_mrproper (&conn->store);
+    }
+
+    hpack_decode_service_mrproper (&service);
+    return ret_ok;
+}
+
+static ret_t
+parse_counts (options_t *opts, const char *list)
+{
+    char *end;
+
+    opts->num_counts = 0;
+
+    while (*list != '\0') {
+        unsigned long count = strtoul (list, &end, 10);
+
+        if ((end == list) || (count < 1) || (opts->num_counts >= MAX_WORKER_COUNTS)) {
+            return ret_error;
+        }
+
+        opts->counts[opts->num_counts++] = (unsigned int) count;
+
+        list = (*end == ',') ? end + 1 : end;
+    }
+
+    return (opts->num_counts > 0) ? ret_ok : ret_error;
+}
+
+/* 1, 2, 4.. up to the number of CPUs */
+static void
+default_counts (options_t *opts)
+{
+    long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+
+    if (cpus < 1) cpus = 1;
+
+    opts->num_counts = 0;
+    for (long n=1; (n < cpus) && (opts->num_counts < MAX_WORKER_COUNTS - 1); n *= 2) {
+        opts->counts[opts->num_counts++] = n;
+    }
+    opts->counts[opts->num_counts++] = cpus;
+}
+
+static void
+usage (const char *prog)
+{
+    printf ("Usage: %s [options]\n\n"
+            "  --connections=N      Connections decoded in parallel (default %d)\n"
+            "  --blocks=N           Header Blocks per connection (default %d)\n"
+            "  --workers=W[,W]      Numbers of workers to compare (default 1, 2, 4..\n"
+            "                       up to the number of CPUs)\n"
+            "  --json               Machine-readable output\n"
+            "  --help               This help\n",
+            prog, DEFAULT_CONNECTIONS, DEFAULT_BLOCKS);
+}
+
+int
+main (int argc, char *argv[])
+{
+    ret_t      ret;
+    conn_t    *conns;
+    uint64_t   ns;
+    uint64_t   fields;
+    uint32_t   errors;
+    double     base  = 0;
+    int        re    = 0;
+    options_t  opts  = {.connections = DEFAULT_CONNECTIONS, .blocks = DEFAULT_BLOCKS,
+                        .num_counts = 0, .json = false};
+
+    for (int i=1; i < argc; i++) {
+        if (! strncmp (argv[i], "--connections=", 14)) {
+            opts.connections = atoi (argv[i] + 14);
+            if (opts.connections < 1) opts.connections = 1;
+        } else if (! strncmp (argv[i], "--blocks=", 9)) {
+            opts.blocks = atoi (argv[i] + 9);
+            if (opts.blocks < 1) opts.blocks = 1;
+        } else if (! strncmp (argv[i], "--workers=", 10)) {
+            if (parse_counts (&opts, argv[i] + 10) != ret_ok) {
+                fprintf (stderr, "Invalid list of workers: %s\n", argv[i] + 10);
+                return 1;
+            }
+        } else if (! strcmp (argv[i], "--json")) {
+            opts.json = true;
+        } else {
+            usage (argv[0]);
+            return strcmp (argv[i], "--help") ? 1 : 0;
+        }
+    }
+
+    if (opts.num_counts == 0) {
+        default_counts (&opts);
+    }
+
+    conns = calloc (opts.connections, sizeof(conn_t));
+    if (unlikely (conns == NULL)) return 1;
+
+    for (unsigned int c=0; c < opts.connections; c++) {
+        ret = conn_render (&conns[c], &opts, c);
+        if (unlikely (ret != ret_ok)) {
+            fprintf (stderr, "Encoding failed (ret=%d)\n", ret);
+            return 1;
+        }
+    }
+
+    if (opts.json) {
+        printf ("{\n  \"connections\": %u,\n  \"blocks\": %u,\n  \"runs\": [",
+                opts.connections, opts.blocks);
+    } else {
+        printf ("%u connections, %u Header Blocks each\n\n", opts.connections, opts.blocks);
+        printf ("%7s %12s %12s %12s %8s %7s\n",
+                "workers", "ms", "blocks/s", "ns/header", "speedup", "errors");
+    }
+
+    for (unsigned int w=0; w < opts.num_counts; w++) {
+        double blocks_s;
+
+        ret = run (conns, &opts, opts.counts[w], &ns, &fields, &errors);
+        if (ret != ret_ok) {
+            fprintf (stderr, "Decoding failed (ret=%d)\n", ret);
+            return 1;
+        }
+
+        blocks_s = (double) opts.connections * opts.blocks * 1e9 / ns;
+        if (w == 0) base = blocks_s;
+
+        if (opts.json) {
+            printf ("%s\n    {\"workers\": %u, \"ns\": %llu, \"blocks_per_s\": %.0f, "
+                    "\"ns_per_header\": %.1f, \"speedup\": %.2f, \"errors\": %u}",
+                    (w == 0) ? "" : ",", opts.counts[w], (unsigned long long) ns, blocks_s,
+                    fields ? (double) ns / fields : 0, blocks_s / base, errors);
+        } else {
+            printf ("%7u %12.2f %12.0f %12.1f %7.2fx %7u\n",
+                    opts.counts[w], ns / 1e6, blocks_s,
+                    fields ? (double) ns / fields : 0, blocks_s / base, errors);
+        }
+
+        re += errors;
+    }
+
+    if (opts.json) {
+        printf ("\n  ]\n}\n");
+    }
+
+    for (unsigned int c=0; c < opts.connections; c++) {
+        conn_mrproper (&conns[c], &opts);
+    }
+    free (conns);
+
+    return (re > 0) ? 1 : 0;
+}
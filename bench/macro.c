@@ -0,0 +1,534 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "bench.h"
+
+#define FIELD(n,v) {n, v}
+
+static const char *request_fields[][2] = {
+    FIELD (":method",          "GET"),
+    FIELD (":scheme",          "https"),
+    FIELD (":authority",       "www.example.com"),
+    FIELD (":path",            "/assets/css/main.css?v=20140512"),
+    FIELD ("user-agent",       "Mozilla/5.0 (X11; Linux x86_64; rv:29.0) Gecko/20100101 Firefox/29.0"),
+    FIELD ("accept",           "text/css,*/*;q=0.1"),
+    FIELD ("accept-language",  "en-US,en;q=0.5"),
+    FIELD ("accept-encoding",  "gzip, deflate"),
+    FIELD ("referer",          "https://www.example.com/index.html"),
+    FIELD ("cookie",           "session=8f14e45fceea167a5a36dedd4bea2543; theme=dark; _ga=GA1.2.1820358715.1399923340"),
+    FIELD ("cache-control",    "max-age=0"),
+    FIELD (NULL, NULL)
+};
+
+static const char *response_fields[][2] = {
+    FIELD (":status",          "200"),
+    FIELD ("date",             "Mon, 12 May 2014 20:13:21 GMT"),
+    FIELD ("server",           "nginx/1.6.0"),
+    FIELD ("content-type",     "text/css; charset=utf-8"),
+    FIELD ("content-length",   "18733"),
+    FIELD ("last-modified",    "Sun, 11 May 2014 09:41:02 GMT"),
+    FIELD ("etag",             "\"536f4a6e-492d\""),
+    FIELD ("cache-control",    "public, max-age=31536000"),
+    FIELD ("expires",          "Tue, 12 May 2015 20:13:21 GMT"),
+    FIELD ("vary",             "Accept-Encoding"),
+    FIELD ("content-encoding", "gzip"),
+    FIELD (NULL, NULL)
+};
+
+/* Draft-07, Appendix C.4: Request Examples with Huffman */
+static const struct {
+    const char   *raw;
+    unsigned int  len;
+} draft_requests[] = {
+    {"\x82\x87\x86\x44\x8c\xf1\xe3\xc2\xe5\xf2\x3a\x6b\xa0\xab\x90\xf4\xff", 17},
+    {"\x5c\x86\xa8\xeb\x10\x64\x9c\xbf", 8},
+    {"\x30\x85\x8c\x8b\x84\x40\x88\x25\xa8\x49\xe9\x5b\xa9\x7d\x7f\x89\x25\xa8\x49\xe9\x5b\xb8\xe8\xb4\xbf", 25},
+};
+
+#define NUM_DRAFT_REQUESTS (sizeof(draft_requests) / sizeof(draft_requests[0]))
+
+typedef struct {
+    const char           *(*set)[2];
+    chula_list_t           fields;
+    chula_buffer_t         wire;
+    hpack_header_store_t   store;
+    hpack_header_parser_t *parser;
+} set_data_t;
+
+
+static ret_t
+set_new (bench_t *bench, const char *set[][2])
+{
+    set_data_t *d;
+
+    d = malloc (sizeof(set_data_t));
+    if (unlikely (d == NULL)) return ret_nomem;
+
+    d->set    = set;
+    d->parser = NULL;
+
+    chula_buffer_init (&d->wire);
+    hpack_header_store_init (&d->store);
+
+    bench->data = d;
+    return ret_ok;
+}
+
+static ret_t
+set_encode (set_data_t *d, chula_buffer_t *output)
+{
+    ret_t                  ret;
+    hpack_header_field_t   field;
+    hpack_header_encoder_t enc;
+
+    hpack_header_encoder_init (&enc);
+    hpack_header_field_init (&field);
+
+    for (unsigned int i=0; d->set[i][0] != NULL; i++) {
+        chula_buffer_t name;
+        chula_buffer_t value;
+
+        chula_buffer_fake (&name,  d->set[i][0], strlen (d->set[i][0]));
+        chula_buffer_fake (&value, d->set[i][1], strlen (d->set[i][1]));
+
+        hpack_header_field_borrow (&field, &name, &value);
+
+        ret = hpack_header_encoder_add_field (&enc, &field);
+        if (unlikely (ret != ret_ok)) goto out;
+    }
+
+    ret = hpack_header_encoder_render (&enc, output);
+
+out:
+    hpack_header_field_mrproper (&field);
+    hpack_header_encoder_mrproper (&enc);
+    return ret;
+}
+
+static ret_t
+set_teardown (bench_t *bench, uint64_t iterations)
+{
+    set_data_t *d = bench->data;
+
+    UNUSED(iterations);
+
+    if (d->parser != NULL) {
+        hpack_header_parser_mrproper (&d->parser);
+    }
+
+    hpack_header_store_mrproper (&d->store);
+    chula_buffer_mrproper (&d->wire);
+
+    free (d);
+    return ret_ok;
+}
+
+
+/* Encoding
+ */
+
+static ret_t
+encode_setup (bench_t *bench, const char *set[][2])
+{
+    ret_t ret;
+
+    ret = set_new (bench, set);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    bench->bytes = 0;
+    for (unsigned int i=0; set[i][0] != NULL; i++) {
+        bench->bytes += strlen (set[i][0]) + strlen (set[i][1]);
+    }
+
+    return ret_ok;
+}
+
+static ret_t
+encode_request_setup (bench_t *bench, uint64_t iterations)
+{
+    UNUSED(iterations);
+    return encode_setup (bench, request_fields);
+}
+
+static ret_t
+encode_response_setup (bench_t *bench, uint64_t iterations)
+{
+    UNUSED(iterations);
+    return encode_setup (bench, response_fields);
+}
+
+static ret_t
+encode_run (bench_t *bench, uint64_t iterations)
+{
+    ret_t       ret;
+    set_data_t *d = bench->data;
+
+    for (uint64_t n=0; n < iterations; n++) {
+        chula_buffer_clean (&d->wire);
+
+        ret = set_encode (d, &d->wire);
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    bench_sink += d->wire.len;
+    return ret_ok;
+}
+
+
+/* Decoding
+ */
+
+static ret_t
+decode_setup (bench_t *bench, const char *set[][2])
+{
+    ret_t       ret;
+    set_data_t *d;
+
+    ret = set_new (bench, set);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    d = bench->data;
+
+    ret = set_encode (d, &d->wire);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    ret = hpack_header_parser_new (&d->parser);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    hpack_header_parser_reg_store (d->parser, &d->store);
+
+    bench->bytes = d->wire.len;
+    return ret_ok;
+}
+
+static ret_t
+decode_request_setup (bench_t *bench, uint64_t iterations)
+{
+    UNUSED(iterations);
+    return decode_setup (bench, request_fields);
+}
+
+static ret_t
+decode_response_setup (bench_t *bench, uint64_t iterations)
+{
+    UNUSED(iterations);
+    return decode_setup (bench, response_fields);
+}
+
+static ret_t
+decode_run (bench_t *bench, uint64_t iterations)
+{
+    ret_t         ret;
+    unsigned int  consumed;
+    set_data_t   *d = bench->data;
+
+    /* Literals without indexing: the decoding context does not change
+     * from one Header Block to the next one.
+     */
+    for (uint64_t n=0; n < iterations; n++) {
+        hpack_header_store_mrproper (&d->store);
+        hpack_header_store_init (&d->store);
+
+        ret = hpack_header_parser_all (d->parser, &d->wire, 0, &consumed);
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    bench_sink += consumed;
+    return ret_ok;
+}
+
+/* Steady state: a store that consumes the fields without keeping
+ * them. Decoding a Header Block must not allocate at all.
+ */
+static ret_t
+steady_emit (hpack_header_store_t *store,
+             hpack_header_field_t *field)
+{
+    UNUSED(store);
+
+    bench_sink += field->name.len + field->value.len;
+    return ret_ok;
+}
+
+static ret_t
+decode_steady_setup (bench_t *bench, const char *set[][2])
+{
+    ret_t ret;
+
+    ret = decode_setup (bench, set);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    ((set_data_t *)bench->data)->store.emit = steady_emit;
+    return ret_ok;
+}
+
+static ret_t
+decode_request_steady_setup (bench_t *bench, uint64_t iterations)
+{
+    UNUSED(iterations);
+    return decode_steady_setup (bench, request_fields);
+}
+
+static ret_t
+decode_response_steady_setup (bench_t *bench, uint64_t iterations)
+{
+    UNUSED(iterations);
+    return decode_steady_setup (bench, response_fields);
+}
+
+static ret_t
+decode_steady_run (bench_t *bench, uint64_t iterations)
+{
+    ret_t         ret;
+    unsigned int  consumed;
+    set_data_t   *d = bench->data;
+
+    for (uint64_t n=0; n < iterations; n++) {
+        ret = hpack_header_parser_all (d->parser, &d->wire, 0, &consumed);
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    return ret_ok;
+}
+
+static ret_t
+decode_draft_setup (bench_t *bench, uint64_t iterations)
+{
+    ret_t ret;
+
+    UNUSED(iterations);
+
+    ret = set_new (bench, NULL);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    bench->bytes = 0;
+    for (unsigned int i=0; i < NUM_DRAFT_REQUESTS; i++) {
+        bench->bytes += draft_requests[i].len;
+    }
+
+    return ret_ok;
+}
+
+static ret_t
+decode_draft_run (bench_t *bench, uint64_t iterations)
+{
+    ret_t           ret;
+    chula_buffer_t  raw;
+    unsigned int    consumed;
+    set_data_t     *d = bench->data;
+
+    /* A new connection on every operation: the three requests share
+     * the Header Table and the Reference Set.
+     */
+    for (uint64_t n=0; n < iterations; n++) {
+        ret = hpack_header_parser_new (&d->parser);
+        if (unlikely (ret != ret_ok)) return ret;
+
+        hpack_header_parser_reg_store (d->parser, &d->store);
+
+        for (unsigned int i=0; i < NUM_DRAFT_REQUESTS; i++) {
+            hpack_header_store_mrproper (&d->store);
+            hpack_header_store_init (&d->store);
+
+            chula_buffer_fake (&raw, draft_requests[i].raw, draft_requests[i].len);
+
+            ret = hpack_header_parser_all (d->parser, &raw, 0, &consumed);
+            if (unlikely (ret != ret_ok)) return ret;
+        }
+
+        hpack_header_parser_mrproper (&d->parser);
+        d->parser = NULL;
+    }
+
+    return ret_ok;
+}
+
+
+/* Many streams: responses of a number of connections rendered in one
+ * event loop iteration, each into its own buffer or in a single batch.
+ */
+
+#define STREAMS_CONNS  8
+#define STREAMS_NUM   32
+
+typedef struct {
+    hpack_header_encoder_t       enc[STREAMS_CONNS];
+    hpack_header_store_t         fields[STREAMS_NUM];
+    chula_buffer_t               wire[STREAMS_NUM];
+    hpack_header_encoder_batch_t batch[STREAMS_NUM];
+    chula_buffer_t               arena;
+} streams_data_t;
+
+static ret_t
+streams_setup (bench_t *bench, uint64_t iterations)
+{
+    streams_data_t *d;
+
+    UNUSED(iterations);
+
+    d = malloc (sizeof(streams_data_t));
+    if (unlikely (d == NULL)) return ret_nomem;
+
+    for (unsigned int c=0; c < STREAMS_CONNS; c++) {
+        hpack_header_encoder_init (&d->enc[c]);
+    }
+
+    for (unsigned int s=0; s < STREAMS_NUM; s++) {
+        hpack_header_store_init (&d->fields[s]);
+        chula_buffer_init (&d->wire[s]);
+
+        d->batch[s].enc    = &d->enc[s % STREAMS_CONNS];
+        d->batch[s].fields = &d->fields[s];
+    }
+
+    chula_buffer_init (&d->arena);
+
+    bench->bytes = 0;
+    for (unsigned int i=0; response_fields[i][0] != NULL; i++) {
+        bench->bytes += strlen (response_fields[i][0]) + strlen (response_fields[i][1]);
+    }
+    bench->bytes *= STREAMS_NUM;
+
+    bench->data = d;
+    return ret_ok;
+}
+
+static ret_t
+streams_teardown (bench_t *bench, uint64_t iterations)
+{
+    streams_data_t *d = bench->data;
+
+    UNUSED(iterations);
+
+    for (unsigned int c=0; c < STREAMS_CONNS; c++) {
+        hpack_header_encoder_mrproper (&d->enc[c]);
+    }
+
+    for (unsigned int s=0; s < STREAMS_NUM; s++) {
+        hpack_header_store_mrproper (&d->fields[s]);
+        chula_buffer_mrproper (&d->wire[s]);
+    }
+
+    chula_buffer_mrproper (&d->arena);
+
+    free (d);
+    return ret_ok;
+}
+
+static ret_t
+streams_add (hpack_header_store_t *store)
+{
+    ret_t                ret = ret_ok;
+    hpack_header_field_t field;
+
+    hpack_header_field_init (&field);
+
+    for (unsigned int i=0; response_fields[i][0] != NULL; i++) {
+        chula_buffer_t name;
+        chula_buffer_t value;
+
+        chula_buffer_fake (&name,  response_fields[i][0], strlen (response_fields[i][0]));
+        chula_buffer_fake (&value, response_fields[i][1], strlen (response_fields[i][1]));
+
+        hpack_header_field_borrow (&field, &name, &value);
+
+        ret = hpack_header_store_add (store, &field);
+        if (unlikely (ret != ret_ok)) break;
+    }
+
+    hpack_header_field_mrproper (&field);
+    return ret;
+}
+
+static ret_t
+streams_run (bench_t *bench, uint64_t iterations)
+{
+    ret_t           ret;
+    streams_data_t *d = bench->data;
+
+    for (uint64_t n=0; n < iterations; n++) {
+        for (unsigned int s=0; s < STREAMS_NUM; s++) {
+            hpack_header_encoder_t *enc = &d->enc[s % STREAMS_CONNS];
+
+            hpack_header_encoder_clean (enc);
+
+            ret = streams_add (&enc->store);
+            if (unlikely (ret != ret_ok)) return ret;
+
+            chula_buffer_clean (&d->wire[s]);
+
+            ret = hpack_header_encoder_render (enc, &d->wire[s]);
+            if (unlikely (ret != ret_ok)) return ret;
+        }
+    }
+
+    bench_sink += d->wire[0].len;
+    return ret_ok;
+}
+
+static ret_t
+streams_batch_run (bench_t *bench, uint64_t iterations)
+{
+    ret_t           ret;
+    streams_data_t *d = bench->data;
+
+    for (uint64_t n=0; n < iterations; n++) {
+        for (unsigned int s=0; s < STREAMS_NUM; s++) {
+            hpack_header_store_clean (&d->fields[s]);
+
+            ret = streams_add (&d->fields[s]);
+            if (unlikely (ret != ret_ok)) return ret;
+        }
+
+        chula_buffer_clean (&d->arena);
+
+        ret = hpack_header_encoder_render_batch (d->batch, STREAMS_NUM, &d->arena);
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    bench_sink += d->arena.len;
+    return ret_ok;
+}
+
+
+bench_t bench_macro[] = {
+    BENCH ("macro", "encode_request",         200000, encode_request_setup,         encode_run,        set_teardown),
+    BENCH ("macro", "encode_response",        200000, encode_response_setup,        encode_run,        set_teardown),
+    BENCH ("macro", "decode_request",         200000, decode_request_setup,         decode_run,        set_teardown),
+    BENCH ("macro", "decode_response",        200000, decode_response_setup,        decode_run,        set_teardown),
+    BENCH ("macro", "decode_request_steady",  200000, decode_request_steady_setup,  decode_steady_run, set_teardown),
+    BENCH ("macro", "decode_response_steady", 200000, decode_response_steady_setup, decode_steady_run, set_teardown),
+    BENCH ("macro", "decode_draft_c4",        100000, decode_draft_setup,           decode_draft_run,  set_teardown),
+    BENCH ("macro", "encode_streams",           5000, streams_setup,                streams_run,       streams_teardown),
+    BENCH ("macro", "encode_streams_batch",     5000, streams_setup,                streams_batch_run, streams_teardown),
+    BENCH (NULL, NULL, 0, NULL, NULL, NULL)
+};
@@ -0,0 +1,524 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "bench.h"
+
+#define HEADER_VALUE "Mozilla/5.0 (X11; Linux x86_64; rv:29.0) Gecko/20100101 Firefox/29.0"
+
+
+/* Huffman
+ */
+
+typedef struct {
+    chula_buffer_t plain;
+    chula_buffer_t encoded;
+    chula_buffer_t out;
+} huffman_data_t;
+
+static ret_t
+huffman_setup (bench_t *bench, uint64_t iterations)
+{
+    huffman_data_t *d;
+
+    UNUSED(iterations);
+
+    d = malloc (sizeof(huffman_data_t));
+    if (unlikely (d == NULL)) return ret_nomem;
+
+    chula_buffer_init (&d->plain);
+    chula_buffer_init (&d->encoded);
+    chula_buffer_init (&d->out);
+
+    chula_buffer_add_str (&d->plain, HEADER_VALUE);
+    hpack_huffman_encode (&d->plain, &d->encoded);
+
+    bench->data = d;
+    return ret_ok;
+}
+
+static ret_t
+huffman_teardown (bench_t *bench, uint64_t iterations)
+{
+    huffman_data_t *d = bench->data;
+
+    UNUSED(iterations);
+
+    chula_buffer_mrproper (&d->plain);
+    chula_buffer_mrproper (&d->encoded);
+    chula_buffer_mrproper (&d->out);
+
+    free (d);
+    return ret_ok;
+}
+
+static ret_t
+huffman_encode_setup (bench_t *bench, uint64_t iterations)
+{
+    ret_t ret;
+
+    ret = huffman_setup (bench, iterations);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    bench->bytes = ((huffman_data_t *)bench->data)->plain.len;
+    return ret_ok;
+}
+
+static ret_t
+huffman_encode_run (bench_t *bench, uint64_t iterations)
+{
+    ret_t           ret;
+    huffman_data_t *d = bench->data;
+
+    for (uint64_t n=0; n < iterations; n++) {
+        chula_buffer_clean (&d->out);
+
+        ret = hpack_huffman_encode (&d->plain, &d->out);
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    bench_sink += d->out.len;
+    return ret_ok;
+}
+
+static ret_t
+huffman_decode_setup (bench_t *bench, uint64_t iterations)
+{
+    ret_t ret;
+
+    ret = huffman_setup (bench, iterations);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    bench->bytes = ((huffman_data_t *)bench->data)->encoded.len;
+    return ret_ok;
+}
+
+static ret_t
+huffman_decode_run (bench_t *bench, uint64_t iterations)
+{
+    ret_t           ret;
+    huffman_data_t *d = bench->data;
+
+    for (uint64_t n=0; n < iterations; n++) {
+        hpack_huffman_decode_context_t context = HUFFMAN_DEC_CTX_INIT;
+
+        chula_buffer_clean (&d->out);
+
+        ret = hpack_huffman_decode (&d->encoded, &d->out, &context);
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    bench_sink += d->out.len;
+    return ret_ok;
+}
+
+
+/* Integer
+ */
+
+static const struct {
+    int          prefix;
+    unsigned int value;
+} integers[] = {
+    {7, 10}, {7, 126}, {5, 1337}, {4, 4096}, {6, 65535}, {7, 1 << 20}, {8, 42}, {7, 300}
+};
+
+#define NUM_INTEGERS    (sizeof(integers) / sizeof(integers[0]))
+#define INTEGER_MEM_LEN 16
+
+typedef struct {
+    unsigned char mem[NUM_INTEGERS][INTEGER_MEM_LEN];
+    unsigned char len[NUM_INTEGERS];
+} integer_data_t;
+
+static ret_t
+integer_setup (bench_t *bench, uint64_t iterations)
+{
+    ret_t           ret;
+    integer_data_t *d;
+
+    UNUSED(iterations);
+
+    d = calloc (1, sizeof(integer_data_t));
+    if (unlikely (d == NULL)) return ret_nomem;
+
+    bench->bytes = 0;
+
+    for (unsigned int i=0; i < NUM_INTEGERS; i++) {
+        d->len[i] = INTEGER_MEM_LEN;
+
+        ret = hpack_integer_encode (integers[i].prefix, integers[i].value, d->mem[i], &d->len[i]);
+        if (unlikely (ret != ret_ok)) {
+            free (d);
+            return ret;
+        }
+
+        bench->bytes += d->len[i];
+    }
+
+    bench->data = d;
+    return ret_ok;
+}
+
+static ret_t
+integer_teardown (bench_t *bench, uint64_t iterations)
+{
+    UNUSED(iterations);
+
+    free (bench->data);
+    return ret_ok;
+}
+
+static ret_t
+integer_encode_run (bench_t *bench, uint64_t iterations)
+{
+    ret_t         ret;
+    unsigned char mem[INTEGER_MEM_LEN];
+    unsigned char len;
+
+    UNUSED(bench);
+
+    for (uint64_t n=0; n < iterations; n++) {
+        for (unsigned int i=0; i < NUM_INTEGERS; i++) {
+            len    = sizeof(mem);
+            mem[0] = 0;
+
+            ret = hpack_integer_encode (integers[i].prefix, integers[i].value, mem, &len);
+            if (unlikely (ret != ret_ok)) return ret;
+
+            bench_sink += len;
+        }
+    }
+
+    return ret_ok;
+}
+
+static ret_t
+integer_decode_run (bench_t *bench, uint64_t iterations)
+{
+    ret_t           ret;
+    unsigned int    value;
+    unsigned int    consumed;
+    integer_data_t *d = bench->data;
+
+    for (uint64_t n=0; n < iterations; n++) {
+        for (unsigned int i=0; i < NUM_INTEGERS; i++) {
+            ret = hpack_integer_decode (integers[i].prefix, d->mem[i], d->len[i], &value, &consumed);
+            if (unlikely (ret != ret_ok)) return ret;
+
+            bench_sink += value;
+        }
+    }
+
+    return ret_ok;
+}
+
+
+/* Header Table
+ */
+
+static const char *table_fields[][2] = {
+    {"user-agent",      HEADER_VALUE},
+    {"accept",          "text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8"},
+    {"accept-language", "en-US,en;q=0.5"},
+    {"cookie",          "session=8f14e45fceea167a5a36dedd4bea2543; theme=dark"},
+    {"referer",         "https://www.example.com/index.html"},
+    {"x-request-id",    "4f1c5a7e-2b9d-4c61-9f0e-8d3a6b2c1e07"},
+    {"cache-control",   "no-cache"},
+    {"custom-key",      "custom-value"},
+};
+
+#define NUM_TABLE_FIELDS (sizeof(table_fields) / sizeof(table_fields[0]))
+
+typedef struct {
+    hpack_header_table_t table;
+    hpack_header_field_t fields[NUM_TABLE_FIELDS];
+    hpack_header_field_t out;
+} table_data_t;
+
+static ret_t
+table_setup (bench_t *bench, uint64_t iterations)
+{
+    table_data_t *d;
+    hpack_set_t   evicted;
+
+    UNUSED(iterations);
+
+    d = malloc (sizeof(table_data_t));
+    if (unlikely (d == NULL)) return ret_nomem;
+
+    hpack_header_table_init (&d->table);
+    hpack_header_field_init (&d->out);
+
+    bench->bytes = 0;
+
+    for (unsigned int i=0; i < NUM_TABLE_FIELDS; i++) {
+        hpack_header_field_init (&d->fields[i]);
+        chula_buffer_add (&d->fields[i].name,  table_fields[i][0], strlen (table_fields[i][0]));
+        chula_buffer_add (&d->fields[i].value, table_fields[i][1], strlen (table_fields[i][1]));
+
+        hpack_header_table_add (&d->table, &d->fields[i], evicted);
+        bench->bytes += d->fields[i].name.len + d->fields[i].value.len;
+    }
+
+    bench->bytes /= NUM_TABLE_FIELDS;
+    bench->data   = d;
+    return ret_ok;
+}
+
+static ret_t
+table_teardown (bench_t *bench, uint64_t iterations)
+{
+    table_data_t *d = bench->data;
+
+    UNUSED(iterations);
+
+    for (unsigned int i=0; i < NUM_TABLE_FIELDS; i++) {
+        hpack_header_field_mrproper (&d->fields[i]);
+    }
+
+    hpack_header_field_mrproper (&d->out);
+    hpack_header_table_mrproper (&d->table);
+
+    free (d);
+    return ret_ok;
+}
+
+static ret_t
+table_add_evict_run (bench_t *bench, uint64_t iterations)
+{
+    ret_t         ret;
+    hpack_set_t   evicted;
+    table_data_t *d = bench->data;
+
+    /* A 512 octets table: most additions evict an entry */
+    hpack_header_table_set_max (&d->table, 512, evicted);
+
+    for (uint64_t n=0; n < iterations; n++) {
+        ret = hpack_header_table_add (&d->table, &d->fields[n % NUM_TABLE_FIELDS], evicted);
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    hpack_header_table_set_max (&d->table, SETTINGS_HEADER_TABLE_SIZE, evicted);
+
+    bench_sink += d->table.num_headers;
+    return ret_ok;
+}
+
+static ret_t
+table_get_run (bench_t *bench, uint64_t iterations)
+{
+    ret_t         ret;
+    bool          is_static;
+    table_data_t *d     = bench->data;
+    uint16_t      total = d->table.num_headers + STATIC_ENTRIES;
+
+    for (uint64_t n=0; n < iterations; n++) {
+        hpack_header_field_clean (&d->out);
+
+        ret = hpack_header_table_get (&d->table, 1 + (n % total), false, &d->out, &is_static);
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    bench_sink += d->out.value.len;
+    return ret_ok;
+}
+
+
+/* Bitmap Set
+ */
+
+static ret_t
+set_iter_setup (bench_t *bench, uint64_t iterations)
+{
+    hpack_set_t *set;
+
+    UNUSED(iterations);
+
+    set = malloc (sizeof(hpack_set_t));
+    if (unlikely (set == NULL)) return ret_nomem;
+
+    /* A third of the entries, like a busy reference set */
+    hpack_set_init (*set, false);
+    for (unsigned int i=0; i < HPACK_MAX_HEADER_TABLE_ENTRIES; i += 3) {
+        hpack_set_add (*set, i);
+    }
+
+    bench->bytes = HPACK_SET_BYTES_NEEDED;
+    bench->data  = set;
+    return ret_ok;
+}
+
+static ret_t
+set_iter_teardown (bench_t *bench, uint64_t iterations)
+{
+    UNUSED(iterations);
+
+    free (bench->data);
+    return ret_ok;
+}
+
+static ret_t
+set_iter_run (bench_t *bench, uint64_t iterations)
+{
+    int16_t               idx;
+    hpack_set_iterator_t  iter;
+    hpack_set_t          *set = bench->data;
+
+    for (uint64_t n=0; n < iterations; n++) {
+        hpack_set_iter_init (&iter, *set);
+
+        while ((idx = hpack_set_iter_next (&iter)) != -1) {
+            bench_sink += idx;
+        }
+    }
+
+    return ret_ok;
+}
+
+
+/* Encoder fields
+ */
+
+typedef struct {
+    hpack_header_encoder_t enc;
+    chula_buffer_t         names[NUM_TABLE_FIELDS];
+    chula_buffer_t         values[NUM_TABLE_FIELDS];
+} fields_data_t;
+
+static ret_t
+fields_setup (bench_t *bench, uint64_t iterations)
+{
+    fields_data_t *d;
+
+    UNUSED(iterations);
+
+    d = malloc (sizeof(fields_data_t));
+    if (unlikely (d == NULL)) return ret_nomem;
+
+    hpack_header_encoder_init (&d->enc);
+
+    bench->bytes = 0;
+
+    for (unsigned int i=0; i < NUM_TABLE_FIELDS; i++) {
+        chula_buffer_init (&d->names[i]);
+        chula_buffer_init (&d->values[i]);
+
+        bench->bytes += strlen (table_fields[i][0]) + strlen (table_fields[i][1]);
+    }
+
+    bench->data = d;
+    return ret_ok;
+}
+
+static ret_t
+fields_teardown (bench_t *bench, uint64_t iterations)
+{
+    fields_data_t *d = bench->data;
+
+    UNUSED(iterations);
+
+    for (unsigned int i=0; i < NUM_TABLE_FIELDS; i++) {
+        chula_buffer_mrproper (&d->names[i]);
+        chula_buffer_mrproper (&d->values[i]);
+    }
+
+    hpack_header_encoder_mrproper (&d->enc);
+
+    free (d);
+    return ret_ok;
+}
+
+/* Steady state: once cleaned, the encoder reuses the memory of the
+ * previous fields. Adding a field must not allocate.
+ */
+static ret_t
+encoder_add_run (bench_t *bench, uint64_t iterations)
+{
+    ret_t          ret;
+    chula_buffer_t name;
+    chula_buffer_t value;
+    fields_data_t *d = bench->data;
+
+    for (uint64_t n=0; n < iterations; n++) {
+        hpack_header_encoder_clean (&d->enc);
+
+        for (unsigned int i=0; i < NUM_TABLE_FIELDS; i++) {
+            chula_buffer_fake (&name,  table_fields[i][0], strlen (table_fields[i][0]));
+            chula_buffer_fake (&value, table_fields[i][1], strlen (table_fields[i][1]));
+
+            ret = hpack_header_encoder_add (&d->enc, &name, &value);
+            if (unlikely (ret != ret_ok)) return ret;
+        }
+    }
+
+    return ret_ok;
+}
+
+/* The caller builds each field in the buffers it got back from the
+ * previous adoption.
+ */
+static ret_t
+encoder_adopt_run (bench_t *bench, uint64_t iterations)
+{
+    ret_t          ret;
+    fields_data_t *d = bench->data;
+
+    for (uint64_t n=0; n < iterations; n++) {
+        hpack_header_encoder_clean (&d->enc);
+
+        for (unsigned int i=0; i < NUM_TABLE_FIELDS; i++) {
+            chula_buffer_clean (&d->names[i]);
+            chula_buffer_clean (&d->values[i]);
+            chula_buffer_add (&d->names[i],  table_fields[i][0], strlen (table_fields[i][0]));
+            chula_buffer_add (&d->values[i], table_fields[i][1], strlen (table_fields[i][1]));
+
+            ret = hpack_header_encoder_adopt (&d->enc, &d->names[i], &d->values[i]);
+            if (unlikely (ret != ret_ok)) return ret;
+        }
+    }
+
+    return ret_ok;
+}
+
+
+bench_t bench_micro[] = {
+    BENCH ("micro", "huffman_encode",   1000000, huffman_encode_setup, huffman_encode_run,  huffman_teardown),
+    BENCH ("micro", "huffman_decode",   1000000, huffman_decode_setup, huffman_decode_run,  huffman_teardown),
+    BENCH ("micro", "integer_encode",   2000000, integer_setup,        integer_encode_run,  integer_teardown),
+    BENCH ("micro", "integer_decode",   2000000, integer_setup,        integer_decode_run,  integer_teardown),
+    BENCH ("micro", "table_add_evict",  2000000, table_setup,          table_add_evict_run, table_teardown),
+    BENCH ("micro", "table_get",        2000000, table_setup,          table_get_run,       table_teardown),
+    BENCH ("micro", "set_iter",         2000000, set_iter_setup,       set_iter_run,        set_iter_teardown),
+    BENCH ("micro", "encoder_add_steady",   500000, fields_setup,      encoder_add_run,     fields_teardown),
+    BENCH ("micro", "encoder_adopt_steady", 500000, fields_setup,      encoder_adopt_run,   fields_teardown),
+    BENCH (NULL, NULL, 0, NULL, NULL, NULL)
+};
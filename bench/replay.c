@@ -0,0 +1,651 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file      replay.c
+ * @brief     Replays a corpus of header lists through the encoder and the parser.
+ *
+ * The corpus is a text file with one header field per line, "name: value",
+ * and an empty line after each header list. Lines starting with '#' are
+ * comments. The header lists are spread over a number of connections, each
+ * one with its own encoder and parser, and the whole corpus is replayed
+ * once per table size and indexing policy so different configurations see
+ * identical traffic.
+ *
+ * @date      October, 2026
+ */
+
+#include <libhpack/libhpack.h>
+#include <libchula-qa/libchula-qa.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#define DEFAULT_CONNECTIONS 16
+#define MAX_TABLE_SIZES     16
+#define MAX_POLICIES        8
+
+
+/* Corpus
+ */
+
+typedef struct {
+    uint32_t name_off;
+    uint32_t name_len;
+    uint32_t value_off;
+    uint32_t value_len;
+} corpus_field_t;
+
+typedef struct {
+    uint32_t first;
+    uint32_t num;
+} corpus_list_t;
+
+typedef struct {
+    chula_buffer_t  data;
+    corpus_field_t *fields;
+    uint32_t        num_fields;
+    corpus_list_t  *lists;
+    uint32_t        num_lists;
+    uint64_t        octets;
+} corpus_t;
+
+
+/* Replay
+ */
+
+typedef struct {
+    hpack_header_store_t    store;     /**< First: emit() casts it back to the connection. */
+    hpack_header_encoder_t  enc;
+    hpack_header_parser_t  *parser;
+    corpus_t               *corpus;
+    chula_list_t           *expected;  /**< Next field to decode, in the order the encoder rendered them. */
+    uint32_t                next;
+    uint32_t                mismatches;
+} conn_t;
+
+typedef struct {
+    char                          name[32];
+    hpack_header_encoder_policy_t func;
+    uint32_t                      arg;
+} policy_t;
+
+typedef struct {
+    unsigned int  connections;
+    unsigned int  repeat;
+    unsigned int  num_sizes;
+    uint16_t      sizes[MAX_TABLE_SIZES];
+    unsigned int  num_policies;
+    policy_t      policies[MAX_POLICIES];
+    bool          reorder;
+    bool          differential;
+    bool          json;
+} options_t;
+
+typedef struct {
+    uint16_t      table_size;
+    policy_t     *policy;
+    hpack_stats_t enc_stats;
+    hpack_stats_t dec_stats;
+    uint64_t      enc_ns;
+    uint64_t      dec_ns;
+    int64_t       peak_bytes;
+    uint32_t      errors;
+} result_t;
+
+static chula_mem_mgr_t            mgr;
+static chula_mem_policy_profile_t profile;
+
+
+static uint64_t
+now_ns (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void
+corpus_init (corpus_t *corpus)
+{
+    chula_buffer_init (&corpus->data);
+
+    corpus->fields     = NULL;
+    corpus->num_fields = 0;
+    corpus->lists      = NULL;
+    corpus->num_lists  = 0;
+    corpus->octets     = 0;
+}
+
+static void
+corpus_mrproper (corpus_t *corpus)
+{
+    chula_buffer_mrproper (&corpus->data);
+    free (corpus->fields);
+    free (corpus->lists);
+}
+
+static ret_t
+corpus_close_list (corpus_t *corpus, uint32_t first)
+{
+    corpus_list_t *lists;
+
+    if (corpus->num_fields == first) {
+        return ret_ok;
+    }
+
+    lists = realloc (corpus->lists, (corpus->num_lists + 1) * sizeof(corpus_list_t));
+    if (unlikely (lists == NULL)) return ret_nomem;
+
+    corpus->lists = lists;
+    corpus->lists[corpus->num_lists].first = first;
+    corpus->lists[corpus->num_lists].num   = corpus->num_fields - first;
+    corpus->num_lists++;
+
+    return ret_ok;
+}
+
+static ret_t
+corpus_add_field (corpus_t *corpus, char *line, size_t len)
+{
+    char           *sep;
+    char           *value;
+    corpus_field_t *fields;
+    corpus_field_t *f;
+
+    /* The name of pseudo-headers starts with a colon */
+    sep = memchr (line + 1, ':', len - 1);
+    if (sep == NULL) {
+        return ret_error;
+    }
+
+    value = sep + 1;
+    while ((value < line + len) && (*value == ' ')) {
+        value++;
+    }
+
+    fields = realloc (corpus->fields, (corpus->num_fields + 1) * sizeof(corpus_field_t));
+    if (unlikely (fields == NULL)) return ret_nomem;
+    corpus->fields = fields;
+
+    f = &corpus->fields[corpus->num_fields++];
+
+    /* HTTP/2 field names are lowercase */
+    for (char *p = line; p < sep; p++) {
+        *p = tolower (*p);
+    }
+
+    f->name_off  = corpus->data.len;
+    f->name_len  = sep - line;
+    chula_buffer_add_RET (&corpus->data, line, f->name_len);
+
+    f->value_off = corpus->data.len;
+    f->value_len = (line + len) - value;
+    chula_buffer_add_RET (&corpus->data, value, f->value_len);
+
+    corpus->octets += f->name_len + f->value_len;
+    return ret_ok;
+}
+
+static ret_t
+corpus_load (corpus_t *corpus, const char *path)
+{
+    ret_t     ret    = ret_ok;
+    FILE     *file;
+    char      line[16384];
+    uint32_t  first  = corpus->num_fields;
+    uint32_t  lineno = 0;
+
+    file = fopen (path, "r");
+    if (file == NULL) {
+        fprintf (stderr, "Could not open %s\n", path);
+        return ret_error;
+    }
+
+    while (fgets (line, sizeof(line), file) != NULL) {
+        size_t len = strlen (line);
+
+        lineno++;
+        while ((len > 0) && ((line[len-1] == '\n') || (line[len-1] == '\r'))) {
+            line[--len] = '\0';
+        }
+
+        if (line[0] == '#') {
+            continue;
+        }
+
+        if (len == 0) {
+            ret = corpus_close_list (corpus, first);
+            if (unlikely (ret != ret_ok)) break;
+
+            first = corpus->num_fields;
+            continue;
+        }
+
+        ret = corpus_add_field (corpus, line, len);
+        if (unlikely (ret != ret_ok)) {
+            fprintf (stderr, "%s:%u: not a header field\n", path, lineno);
+            break;
+        }
+    }
+
+    if (ret == ret_ok) {
+        ret = corpus_close_list (corpus, first);
+    }
+
+    fclose (file);
+    return ret;
+}
+
+static ret_t
+conn_emit (hpack_header_store_t *store,
+           hpack_header_field_t *field)
+{
+    conn_t               *conn = (conn_t *) store;
+    hpack_header_field_t *f;
+
+    if (conn->expected == &conn->enc.store.headers) {
+        conn->mismatches++;
+        return ret_ok;
+    }
+
+    /* Fields come out as the encoder rendered them */
+    f = HPACK_HEADER_FIELD (list_entry (conn->expected, hpack_header_store_entry_t, entry));
+
+    conn->expected = conn->expected->next;
+    conn->next++;
+
+    if ((field->name.len != f->name.len) ||
+        (field->value.len != f->value.len) ||
+        (memcmp (field->name.buf, f->name.buf, f->name.len) != 0) ||
+        (memcmp (field->value.buf, f->value.buf, f->value.len) != 0))
+    {
+        conn->mismatches++;
+    }
+
+    return ret_ok;
+}
+
+static ret_t
+conn_init (conn_t *conn, corpus_t *corpus, options_t *opts, uint16_t table_size, policy_t *policy, result_t *result)
+{
+    ret_t       ret;
+    hpack_set_t evicted;
+
+    hpack_header_store_init (&conn->store);
+    conn->store.emit = conn_emit;
+
+    conn->corpus     = corpus;
+    conn->expected   = NULL;
+    conn->next       = 0;
+    conn->mismatches = 0;
+
+    ret = hpack_header_encoder_init (&conn->enc);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    ret = hpack_header_parser_new (&conn->parser);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    hpack_header_parser_reg_store (conn->parser, &conn->store);
+    hpack_header_parser_set_stats (conn->parser, &result->dec_stats);
+    hpack_header_encoder_set_stats (&conn->enc, &result->enc_stats);
+    hpack_header_encoder_set_policy (&conn->enc, policy->func, &policy->arg);
+    hpack_header_encoder_set_reorder (&conn->enc, opts->reorder);
+    hpack_header_encoder_set_differential (&conn->enc, opts->differential);
+
+    /* Both ends of the connection agree on the Header Table size */
+    ret = hpack_header_table_set_max (&conn->enc.table, table_size, evicted);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    return hpack_header_table_set_max (&conn->parser->context.table, table_size, evicted);
+}
+
+static void
+conn_mrproper (conn_t *conn)
+{
+    hpack_header_encoder_mrproper (&conn->enc);
+    hpack_header_parser_mrproper (&conn->parser);
+    hpack_header_store_mrproper (&conn->store);
+}
+
+static ret_t
+replay_list (conn_t *conn, corpus_list_t *list, chula_buffer_t *wire, result_t *result)
+{
+    ret_t                ret;
+    uint64_t             start;
+    unsigned int         consumed = 0;
+    hpack_header_field_t field;
+    corpus_t            *corpus   = conn->corpus;
+
+    hpack_header_field_init (&field);
+    chula_buffer_clean (wire);
+
+    /* Encode */
+    start = now_ns();
+
+    for (uint32_t i=0; i < list->num; i++) {
+        chula_buffer_t  name;
+        chula_buffer_t  value;
+        corpus_field_t *f = &corpus->fields[list->first + i];
+
+        chula_buffer_fake (&name,  (const char *) corpus->data.buf + f->name_off,  f->name_len);
+        chula_buffer_fake (&value, (const char *) corpus->data.buf + f->value_off, f->value_len);
+        hpack_header_field_borrow (&field, &name, &value);
+
+        ret = hpack_header_encoder_add_field (&conn->enc, &field);
+        if (unlikely (ret != ret_ok)) goto out;
+    }
+
+    ret = hpack_header_encoder_render (&conn->enc, wire);
+    if (unlikely (ret != ret_ok)) goto out;
+
+    result->enc_ns += now_ns() - start;
+
+    /* Decode */
+    conn->expected = conn->enc.store.headers.next;
+    conn->next     = 0;
+
+    start = now_ns();
+    ret = hpack_header_parser_all (conn->parser, wire, 0, &consumed);
+    result->dec_ns += now_ns() - start;
+
+    if ((ret == ret_ok) &&
+        ((consumed != wire->len) || (conn->next != list->num)))
+    {
+        ret = ret_error;
+    }
+
+out:
+    hpack_header_encoder_clean (&conn->enc);
+    hpack_header_field_mrproper (&field);
+    return ret;
+}
+
+static ret_t
+replay (corpus_t *corpus, options_t *opts, uint16_t table_size, policy_t *policy, result_t *result)
+{
+    ret_t           ret   = ret_ok;
+    conn_t         *conns;
+    chula_buffer_t  wire  = CHULA_BUF_INIT;
+    int64_t         base  = profile.live_bytes;
+
+    memset (result, 0, sizeof(result_t));
+    result->table_size = table_size;
+    result->policy     = policy;
+    hpack_stats_init (&result->enc_stats);
+    hpack_stats_init (&result->dec_stats);
+
+    chula_mem_policy_profile_reset_peak (&profile);
+
+    conns = malloc (opts->connections * sizeof(conn_t));
+    if (unlikely (conns == NULL)) return ret_nomem;
+
+    for (unsigned int c=0; c < opts->connections; c++) {
+        ret = conn_init (&conns[c], corpus, opts, table_size, policy, result);
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    for (unsigned int r=0; r < opts->repeat; r++) {
+        for (uint32_t l=0; l < corpus->num_lists; l++) {
+            conn_t *conn = &conns[l % opts->connections];
+
+            ret = replay_list (conn, &corpus->lists[l], &wire, result);
+            if (unlikely (ret != ret_ok)) {
+                result->errors++;
+            }
+        }
+    }
+
+    result->peak_bytes = profile.peak_bytes - base;
+
+    for (unsigned int c=0; c < opts->connections; c++) {
+        result->errors += conns[c].mismatches;
+        conn_mrproper (&conns[c]);
+    }
+
+    free (conns);
+    chula_buffer_mrproper (&wire);
+    return ret_ok;
+}
+
+static void
+report (result_t *result, options_t *opts, bool first)
+{
+    hpack_stats_t *enc     = &result->enc_stats;
+    hpack_stats_t *dec     = &result->dec_stats;
+    double         ratio   = enc->decoded_len ? (double)enc->wire_len / enc->decoded_len : 0;
+    double         enc_ns  = enc->fields ? (double)result->enc_ns / enc->fields : 0;
+    double         dec_ns  = dec->fields ? (double)result->dec_ns / dec->fields : 0;
+    double         hits    = dec->fields ? (double)dec->reps[rep_indexed] / dec->fields : 0;
+
+    if (opts->json) {
+        printf ("%s\n    {\"table_size\": %u, \"policy\": \"%s\", \"connections\": %u, \"fields\": %llu, "
+                "\"plain_octets\": %llu, \"wire_octets\": %llu, \"ratio\": %.4f, "
+                "\"encode_ns_per_header\": %.1f, \"decode_ns_per_header\": %.1f, "
+                "\"table_hit_rate\": %.4f, \"evictions\": %llu, \"peak_bytes\": %lld, \"errors\": %u}",
+                first ? "" : ",",
+                result->table_size, result->policy->name, opts->connections,
+                (unsigned long long) dec->fields,
+                (unsigned long long) enc->decoded_len,
+                (unsigned long long) enc->wire_len,
+                ratio, enc_ns, dec_ns, hits,
+                (unsigned long long) dec->evictions,
+                (long long) result->peak_bytes, result->errors);
+        return;
+    }
+
+    printf ("%10u %-14s %6u %8.4f %12.1f %12.1f %9.2f%% %10llu %10.1f %7u\n",
+            result->table_size, result->policy->name, opts->connections, ratio, enc_ns, dec_ns, hits * 100,
+            (unsigned long long) dec->evictions,
+            result->peak_bytes / 1024.0, result->errors);
+}
+
+static ret_t
+parse_sizes (options_t *opts, const char *list)
+{
+    char *end;
+
+    opts->num_sizes = 0;
+
+    while (*list != '\0') {
+        unsigned long size = strtoul (list, &end, 10);
+
+        if ((end == list) || (size > UINT16_MAX) || (opts->num_sizes >= MAX_TABLE_SIZES)) {
+            return ret_error;
+        }
+
+        opts->sizes[opts->num_sizes++] = (uint16_t) size;
+
+        list = (*end == ',') ? end + 1 : end;
+    }
+
+    return (opts->num_sizes > 0) ? ret_ok : ret_error;
+}
+
+static ret_t
+parse_policies (options_t *opts, const char *list)
+{
+    char         *end;
+    const char   *arg;
+    size_t        len;
+    policy_t     *policy;
+
+    opts->num_policies = 0;
+
+    while (*list != '\0') {
+        if (opts->num_policies >= MAX_POLICIES) return ret_error;
+
+        len = strcspn (list, ",");
+        if ((len == 0) || (len >= sizeof(policy->name))) return ret_error;
+
+        policy = &opts->policies[opts->num_policies++];
+        memcpy (policy->name, list, len);
+        policy->name[len] = '\0';
+        policy->arg       = 0;
+
+        arg = strchr (policy->name, ':');
+
+        if (! strcmp (policy->name, "all")) {
+            policy->func = hpack_header_encoder_policy_always;
+        } else if (! strcmp (policy->name, "none")) {
+            policy->func = hpack_header_encoder_policy_never;
+        } else if (! strcmp (policy->name, "cost")) {
+            policy->func = hpack_header_encoder_policy_cost;
+        } else if ((arg != NULL) && (! strncmp (policy->name, "max-value:", 10))) {
+            policy->func = hpack_header_encoder_policy_max_value;
+        } else if ((arg != NULL) && (! strncmp (policy->name, "min-seen:", 9))) {
+            policy->func = hpack_header_encoder_policy_min_seen;
+        } else {
+            return ret_error;
+        }
+
+        if (arg != NULL) {
+            policy->arg = strtoul (arg + 1, &end, 10);
+            if ((end == arg + 1) || (*end != '\0')) return ret_error;
+        }
+
+        list += len;
+        if (*list == ',') list++;
+    }
+
+    return (opts->num_policies > 0) ? ret_ok : ret_error;
+}
+
+static void
+usage (const char *prog)
+{
+    printf ("Usage: %s [options] CORPUS...\n\n"
+            "  --connections=N      Simulated connections (default %d)\n"
+            "  --table-size=S[,S]   Header Table sizes to compare (default %d)\n"
+            "  --policy=P[,P]       Indexing policies to compare: all, none, cost,\n"
+            "                       max-value:N or min-seen:K (default all)\n"
+            "  --reorder            Let the encoder reorder the fields\n"
+            "  --differential       Render only what changed since the previous\n"
+            "                       header list of the connection\n"
+            "  --repeat=N           Replays of the corpus (default 1)\n"
+            "  --json               Machine-readable output\n"
+            "  --help               This help\n\n"
+            "The corpus has a \"name: value\" header field per line, and an empty\n"
+            "line after each header list. Lines starting with '#' are comments.\n",
+            prog, DEFAULT_CONNECTIONS, SETTINGS_HEADER_TABLE_SIZE);
+}
+
+int
+main (int argc, char *argv[])
+{
+    ret_t     ret;
+    int       re    = 0;
+    corpus_t  corpus;
+    result_t  result;
+    options_t opts  = {.connections = DEFAULT_CONNECTIONS, .repeat = 1, .num_sizes = 1,
+                       .sizes = {SETTINGS_HEADER_TABLE_SIZE}, .num_policies = 1,
+                       .policies = {{"all", hpack_header_encoder_policy_always, 0}},
+                       .reorder = false, .differential = false, .json = false};
+
+    /* Track the memory in use from now on */
+    chula_mem_mgr_init (&mgr);
+    chula_mem_policy_profile_init (&profile, false);
+    chula_mem_mgr_set_policy (&mgr, MEM_POLICY(&profile));
+
+    corpus_init (&corpus);
+
+    for (int i=1; i < argc; i++) {
+        if (! strncmp (argv[i], "--connections=", 14)) {
+            opts.connections = atoi (argv[i] + 14);
+            if (opts.connections < 1) opts.connections = 1;
+        } else if (! strncmp (argv[i], "--table-size=", 13)) {
+            if (parse_sizes (&opts, argv[i] + 13) != ret_ok) {
+                fprintf (stderr, "Invalid table size list: %s\n", argv[i] + 13);
+                return 1;
+            }
+        } else if (! strncmp (argv[i], "--policy=", 9)) {
+            if (parse_policies (&opts, argv[i] + 9) != ret_ok) {
+                fprintf (stderr, "Invalid policy list: %s\n", argv[i] + 9);
+                return 1;
+            }
+        } else if (! strncmp (argv[i], "--repeat=", 9)) {
+            opts.repeat = atoi (argv[i] + 9);
+            if (opts.repeat < 1) opts.repeat = 1;
+        } else if (! strcmp (argv[i], "--reorder")) {
+            opts.reorder = true;
+        } else if (! strcmp (argv[i], "--differential")) {
+            opts.differential = true;
+        } else if (! strcmp (argv[i], "--json")) {
+            opts.json = true;
+        } else if (! strncmp (argv[i], "--", 2)) {
+            usage (argv[0]);
+            return strcmp (argv[i], "--help") ? 1 : 0;
+        } else {
+            ret = corpus_load (&corpus, argv[i]);
+            if (ret != ret_ok) return 1;
+        }
+    }
+
+    if (corpus.num_lists == 0) {
+        usage (argv[0]);
+        return 1;
+    }
+
+    if (opts.json) {
+        printf ("{\n  \"header_lists\": %u,\n  \"fields\": %u,\n  \"octets\": %llu,\n  \"repeat\": %u,\n  \"runs\": [",
+                corpus.num_lists, corpus.num_fields, (unsigned long long) corpus.octets, opts.repeat);
+    } else {
+        printf ("Corpus: %u header lists, %u fields, %llu octets\n\n",
+                corpus.num_lists, corpus.num_fields, (unsigned long long) corpus.octets);
+        printf ("%10s %-14s %6s %8s %12s %12s %10s %10s %10s %7s\n",
+                "table size", "policy", "conns", "ratio", "enc ns/hdr", "dec ns/hdr",
+                "hit rate", "evictions", "peak KiB", "errors");
+    }
+
+    for (unsigned int s=0; s < opts.num_sizes; s++) {
+        for (unsigned int p=0; p < opts.num_policies; p++) {
+            ret = replay (&corpus, &opts, opts.sizes[s], &opts.policies[p], &result);
+            if (ret != ret_ok) {
+                fprintf (stderr, "Replay failed (ret=%d)\n", ret);
+                return 1;
+            }
+
+            report (&result, &opts, (s == 0) && (p == 0));
+            re += result.errors;
+        }
+    }
+
+    if (opts.json) {
+        printf ("\n  ]\n}\n");
+    }
+
+    corpus_mrproper (&corpus);
+    return (re > 0) ? 1 : 0;
+}
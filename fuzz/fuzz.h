@@ -0,0 +1,64 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file      fuzz.h
+ * @brief     Common declarations of the fuzz targets.
+ *
+ * Every target implements the libFuzzer entry point. With clang it links
+ * against libFuzzer; with other compilers standalone.c provides a main()
+ * that runs the entry point over files and directories, so the seed
+ * corpora can be replayed as regression tests.
+ *
+ * @date      October, 2026
+ */
+
+#ifndef LIBHPACK_FUZZ_H
+#define LIBHPACK_FUZZ_H
+
+#include <libhpack/libhpack.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Invariant broken: let the fuzzer report it as a crash */
+#define fuzz_assert(cond)                                               \
+    do {                                                                \
+        if (unlikely (!(cond))) {                                       \
+            fprintf (stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond);  \
+            abort();                                                    \
+        }                                                               \
+    } while (false)
+
+int LLVMFuzzerTestOneInput (const uint8_t *data, size_t size);
+
+#endif /* LIBHPACK_FUZZ_H */
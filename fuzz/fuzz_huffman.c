@@ -0,0 +1,80 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Huffman decoding.
+ *
+ * A string that decodes must decode to the same octets once encoded
+ * again, and the decoding limit must hold.
+ */
+
+#include "fuzz.h"
+
+int
+LLVMFuzzerTestOneInput (const uint8_t *data, size_t size)
+{
+    ret_t                          ret;
+    chula_buffer_t                 in;
+    chula_buffer_t                 decoded   = CHULA_BUF_INIT;
+    chula_buffer_t                 encoded   = CHULA_BUF_INIT;
+    chula_buffer_t                 again     = CHULA_BUF_INIT;
+    hpack_huffman_decode_context_t context   = HUFFMAN_DEC_CTX_INIT;
+    hpack_huffman_decode_context_t bounded   = HUFFMAN_DEC_CTX_INIT;
+    hpack_huffman_decode_context_t context2  = HUFFMAN_DEC_CTX_INIT;
+
+    chula_buffer_fake (&in, (const char *) data, size);
+
+    ret = hpack_huffman_decode (&in, &decoded, &context);
+    if (ret == ret_ok) {
+        ret = hpack_huffman_encode (&decoded, &encoded);
+        fuzz_assert (ret == ret_ok);
+
+        ret = hpack_huffman_decode (&encoded, &again, &context2);
+        fuzz_assert (ret == ret_ok);
+        fuzz_assert (again.len == decoded.len);
+        fuzz_assert ((decoded.len == 0) || (memcmp (again.buf, decoded.buf, decoded.len) == 0));
+
+        /* Half the room: denied, never written past the limit */
+        if (decoded.len > 1) {
+            chula_buffer_clean (&again);
+            bounded.limit = decoded.len / 2;
+
+            ret = hpack_huffman_decode (&in, &again, &bounded);
+            fuzz_assert (ret != ret_ok);
+            fuzz_assert (again.len <= decoded.len / 2);
+        }
+    }
+
+    chula_buffer_mrproper (&decoded);
+    chula_buffer_mrproper (&encoded);
+    chula_buffer_mrproper (&again);
+    return 0;
+}
@@ -0,0 +1,81 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Integer decoding.
+ *
+ * The first octet selects the prefix length, the rest is the encoded
+ * integer. A decoded integer must encode back to the same octets count
+ * or fewer, and decode to the same value.
+ */
+
+#include "fuzz.h"
+
+int
+LLVMFuzzerTestOneInput (const uint8_t *data, size_t size)
+{
+    ret_t         ret;
+    int           prefix;
+    unsigned int  value;
+    unsigned int  value2;
+    unsigned int  consumed;
+    unsigned int  consumed2;
+    unsigned char mem_len;
+    unsigned char mem[16];
+    unsigned char reencoded[16];
+
+    if (size < 2) {
+        return 0;
+    }
+
+    prefix  = (data[0] % 8) + 1;
+    mem_len = (size - 1 > sizeof(mem)) ? sizeof(mem) : size - 1;
+    memcpy (mem, data + 1, mem_len);
+
+    ret = hpack_integer_decode (prefix, mem, mem_len, &value, &consumed);
+    if (ret != ret_ok) {
+        return 0;
+    }
+
+    fuzz_assert ((consumed > 0) && (consumed <= mem_len));
+
+    reencoded[0] = 0;
+    ret = hpack_integer_encode (prefix, value, reencoded, &mem_len);
+    fuzz_assert (ret == ret_ok);
+    fuzz_assert (mem_len <= consumed);
+
+    ret = hpack_integer_decode (prefix, reencoded, mem_len, &value2, &consumed2);
+    fuzz_assert (ret == ret_ok);
+    fuzz_assert (value2 == value);
+    fuzz_assert (consumed2 == mem_len);
+
+    return 0;
+}
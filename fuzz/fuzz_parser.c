@@ -0,0 +1,124 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Header Block decoding.
+ *
+ * The first octet selects the parser options, the rest is the Header Block:
+ *   bit 0: validation of names and values
+ *   bit 1: resource limits
+ *   bit 2: Huffman cache
+ *   bit 3: split the input into two Header Blocks at the second octet
+ *
+ * After decoding, the context must survive a snapshot and a restore.
+ */
+
+#include "fuzz.h"
+
+static ret_t
+decode (hpack_header_parser_t *parser,
+        const uint8_t         *data,
+        size_t                 size)
+{
+    chula_buffer_t raw;
+    unsigned int   consumed = 0;
+
+    chula_buffer_fake (&raw, (const char *) data, size);
+    return hpack_header_parser_all (parser, &raw, 0, &consumed);
+}
+
+int
+LLVMFuzzerTestOneInput (const uint8_t *data, size_t size)
+{
+    ret_t                        ret;
+    uint8_t                      flags;
+    size_t                       split;
+    unsigned int                 consumed;
+    hpack_header_store_t         store;
+    hpack_huffman_cache_t        cache;
+    hpack_header_parser_t       *parser    = NULL;
+    hpack_header_parser_t       *restored  = NULL;
+    chula_buffer_t               snapshot  = CHULA_BUF_INIT;
+    hpack_header_parser_limits_t limits    = {.max_header_list_size = 16384,
+                                              .max_fields           = 256,
+                                              .max_string_len       = 4096};
+
+    if (size < 1) {
+        return 0;
+    }
+
+    flags = data[0];
+    data += 1;
+    size -= 1;
+
+    hpack_header_store_init (&store);
+    hpack_huffman_cache_init (&cache);
+
+    hpack_header_parser_new (&parser);
+    hpack_header_parser_reg_store (parser, &store);
+
+    if (flags & 1) {
+        hpack_header_parser_set_validation (parser, true);
+    }
+    if (flags & 2) {
+        hpack_header_parser_set_limits (parser, &limits);
+    }
+    if (flags & 4) {
+        hpack_header_parser_set_huffman_cache (parser, &cache);
+    }
+
+    split = size;
+    if ((flags & 8) && (size > 1)) {
+        split = data[0] % size;
+    }
+
+    ret = decode (parser, data, split);
+    if ((ret == ret_ok) && (split < size)) {
+        ret = decode (parser, data + split, size - split);
+    }
+
+    /* Whatever the result, the context can be migrated */
+    ret = hpack_header_parser_snapshot (parser, &snapshot);
+    fuzz_assert (ret == ret_ok);
+
+    hpack_header_parser_new (&restored);
+
+    ret = hpack_header_parser_restore (restored, &snapshot, 0, &consumed);
+    fuzz_assert (ret == ret_ok);
+    fuzz_assert (consumed == snapshot.len);
+
+    chula_buffer_mrproper (&snapshot);
+    hpack_header_parser_mrproper (&restored);
+    hpack_header_parser_mrproper (&parser);
+    hpack_huffman_cache_mrproper (&cache);
+    hpack_header_store_mrproper (&store);
+    return 0;
+}
@@ -0,0 +1,148 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Differential target: encoder output through the parser.
+ *
+ * The input is a header list: NUL terminated names and values,
+ * alternating. It is encoded twice on the same encoder, as two Header
+ * Blocks of one connection, and each block must decode to the very same
+ * header list.
+ */
+
+#include "fuzz.h"
+
+#define MAX_FIELDS 64
+
+typedef struct {
+    hpack_header_store_t  store;   /* First: emit() casts it back */
+    chula_buffer_t       *names;
+    chula_buffer_t       *values;
+    unsigned int          num;
+    unsigned int          next;
+} expect_t;
+
+static ret_t
+expect_emit (hpack_header_store_t *store,
+             hpack_header_field_t *field)
+{
+    expect_t *expect = (expect_t *) store;
+
+    fuzz_assert (expect->next < expect->num);
+    fuzz_assert (chula_buffer_cmp_buf (&field->name, &expect->names[expect->next]) == 0);
+    fuzz_assert (chula_buffer_cmp_buf (&field->value, &expect->values[expect->next]) == 0);
+
+    expect->next++;
+    return ret_ok;
+}
+
+static const uint8_t *
+next_string (const uint8_t *p, const uint8_t *end, chula_buffer_t *buf)
+{
+    const uint8_t *nul = memchr (p, '\0', end - p);
+
+    if (nul == NULL) {
+        nul = end;
+    }
+
+    chula_buffer_fake (buf, (const char *) p, nul - p);
+    return (nul < end) ? nul + 1 : end;
+}
+
+int
+LLVMFuzzerTestOneInput (const uint8_t *data, size_t size)
+{
+    ret_t                  ret;
+    unsigned int           consumed;
+    expect_t               expect;
+    hpack_header_encoder_t enc;
+    hpack_header_parser_t *parser = NULL;
+    chula_buffer_t         wire   = CHULA_BUF_INIT;
+    chula_buffer_t         names[MAX_FIELDS];
+    chula_buffer_t         values[MAX_FIELDS];
+    const uint8_t         *p      = data;
+    const uint8_t         *end    = data + size;
+
+    /* Header list */
+    expect.num = 0;
+
+    while ((p < end) && (expect.num < MAX_FIELDS)) {
+        p = next_string (p, end, &names[expect.num]);
+        p = next_string (p, end, &values[expect.num]);
+
+        /* Fields without a name are not emitted */
+        if (names[expect.num].len > 0) {
+            expect.num++;
+        }
+    }
+
+    hpack_header_store_init (&expect.store);
+    expect.store.emit = expect_emit;
+    expect.names      = names;
+    expect.values     = values;
+
+    hpack_header_encoder_init (&enc);
+    hpack_header_parser_new (&parser);
+    hpack_header_parser_reg_store (parser, &expect.store);
+
+    for (int block=0; block < 2; block++) {
+        chula_buffer_clean (&wire);
+
+        for (unsigned int i=0; i < expect.num; i++) {
+            hpack_header_field_t field;
+
+            hpack_header_field_init (&field);
+            hpack_header_field_borrow (&field, &names[i], &values[i]);
+
+            ret = hpack_header_encoder_add_field (&enc, &field);
+            fuzz_assert (ret == ret_ok);
+
+            hpack_header_field_mrproper (&field);
+        }
+
+        ret = hpack_header_encoder_render (&enc, &wire);
+        fuzz_assert (ret == ret_ok);
+        hpack_header_encoder_clean (&enc);
+
+        expect.next = 0;
+        consumed    = 0;
+
+        ret = hpack_header_parser_all (parser, &wire, 0, &consumed);
+        fuzz_assert (ret == ret_ok);
+        fuzz_assert (consumed == wire.len);
+        fuzz_assert (expect.next == expect.num);
+    }
+
+    chula_buffer_mrproper (&wire);
+    hpack_header_parser_mrproper (&parser);
+    hpack_header_encoder_mrproper (&enc);
+    return 0;
+}
@@ -0,0 +1,135 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Runs LLVMFuzzerTestOneInput() over files and directories of inputs
+ * when libFuzzer is not available. Options starting with '-' are ignored,
+ * so the same command line works for both.
+ */
+
+#include "fuzz.h"
+
+#include <stdio.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+static int
+run_file (const char *path)
+{
+    FILE    *file;
+    long     len;
+    uint8_t *data;
+
+    file = fopen (path, "rb");
+    if (file == NULL) {
+        fprintf (stderr, "Could not open %s\n", path);
+        return 1;
+    }
+
+    fseek (file, 0, SEEK_END);
+    len = ftell (file);
+    fseek (file, 0, SEEK_SET);
+
+    /* Exact size: the sanitizers catch reads past the input */
+    data = malloc (len > 0 ? len : 1);
+    if (data == NULL) {
+        fclose (file);
+        return 1;
+    }
+
+    if (fread (data, 1, len, file) != (size_t) len) {
+        fprintf (stderr, "Could not read %s\n", path);
+        free (data);
+        fclose (file);
+        return 1;
+    }
+
+    LLVMFuzzerTestOneInput (data, len);
+
+    free (data);
+    fclose (file);
+    return 0;
+}
+
+static int
+run_path (const char *path, unsigned int *runs)
+{
+    int            re = 0;
+    DIR           *dir;
+    struct dirent *entry;
+    struct stat    info;
+    char           child[4096];
+
+    if (stat (path, &info) != 0) {
+        fprintf (stderr, "Could not stat %s\n", path);
+        return 1;
+    }
+
+    if (! S_ISDIR (info.st_mode)) {
+        *runs += 1;
+        return run_file (path);
+    }
+
+    dir = opendir (path);
+    if (dir == NULL) {
+        return 1;
+    }
+
+    while ((entry = readdir (dir)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+
+        snprintf (child, sizeof(child), "%s/%s", path, entry->d_name);
+        re += run_path (child, runs);
+    }
+
+    closedir (dir);
+    return re;
+}
+
+int
+main (int argc, char *argv[])
+{
+    int          re   = 0;
+    unsigned int runs = 0;
+
+    for (int i=1; i < argc; i++) {
+        if (argv[i][0] == '-') {
+            continue;
+        }
+
+        re += run_path (argv[i], &runs);
+    }
+
+    printf ("%u inputs run\n", runs);
+    return re;
+}
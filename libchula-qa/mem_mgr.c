@@ -45,6 +45,10 @@
 # include <sys/mman.h>
 #endif
 
+#ifdef HAVE_EXECINFO_H
+# include <execinfo.h>
+#endif
+
 
 /* ANSI colors
  */
@@ -56,6 +60,13 @@
 
 static chula_mem_policy_t *current_policy  = NULL;
 static chula_mem_mgr_t    *current_manager = NULL;
+static __thread void      *current_caller  = NULL;
+
+#ifdef LINUX
+static void *_system_malloc  (size_t size);
+static void *_system_realloc (void *ptr, size_t size);
+static void  _system_free    (void *ptr);
+#endif
 
 #define PRINT(...) chula_mem_mgr_work (current_manager, printf(__VA_ARGS__))
 
@@ -72,6 +83,11 @@ chula_mem_mgr_init (chula_mem_mgr_t *mgr)
     mgr->system.malloc  = zone->malloc;
     mgr->system.realloc = zone->realloc;
     mgr->system.free    = zone->free;
+#elif defined(LINUX)
+    /* The wrapped functions go straight to the system ones */
+    mgr->system.malloc  = _system_malloc;
+    mgr->system.realloc = _system_realloc;
+    mgr->system.free    = _system_free;
 #endif
 
     return ret_ok;
@@ -150,6 +166,7 @@ void *
 __wrap_malloc (size_t size)
 {
     void* (*custom)(size_t) = current_policy->malloc;
+    current_caller = __builtin_return_address(0);
     return custom(size);
 }
 
@@ -157,6 +174,7 @@ void *
 __wrap_realloc (void *ptr, size_t size)
 {
     void* (*custom)(void *, size_t) = current_policy->realloc;
+    current_caller = __builtin_return_address(0);
     return custom (ptr, size);
 }
 
@@ -215,6 +233,27 @@ chula_mem_policy_mrproper (chula_mem_policy_t *policy)
 }
 
 
+/* System Memory Policy
+ */
+
+#ifdef LINUX
+FUNC_MALLOC (system)
+{
+    return CALL_MALLOC;
+}
+
+FUNC_REALLOC (system)
+{
+    return CALL_REALLOC;
+}
+
+FUNC_FREE (system)
+{
+    CALL_FREE;
+}
+#endif
+
+
 /* Counter Memory Policy
  */
 
@@ -224,6 +263,7 @@ FUNC_MALLOC (counter)
 
     if (! current_manager->frozen) {
         policy->n_malloc++;
+        policy->n_bytes += size;
     }
 
     return CALL_MALLOC;
@@ -235,6 +275,7 @@ FUNC_REALLOC (counter)
 
     if (! current_manager->frozen) {
         policy->n_realloc++;
+        policy->n_bytes += size;
     }
 
     return CALL_REALLOC;
@@ -259,6 +300,7 @@ chula_mem_policy_counter_init (chula_mem_policy_counter_t *polcnt)
     polcnt->n_malloc     = 0;
     polcnt->n_realloc    = 0;
     polcnt->n_free       = 0;
+    polcnt->n_bytes      = 0;
     polcnt->base.malloc  = _counter_malloc;
     polcnt->base.realloc = _counter_realloc;
     polcnt->base.free    = _counter_free;
@@ -273,6 +315,230 @@ chula_mem_policy_counter_mrproper (chula_mem_policy_counter_t *polcnt)
 }
 
 
+/* Profile Memory Policy
+ */
+
+#if defined(HAVE_MALLOC_USABLE_SIZE)
+# define USABLE_SIZE(p) ((p) ? (int64_t) malloc_usable_size(p) : 0)
+#elif defined(HAVE_MALLOC_SIZE)
+# define USABLE_SIZE(p) ((p) ? (int64_t) malloc_size(p) : 0)
+#else
+# define USABLE_SIZE(p) 0
+#endif
+
+static void
+profile_live (chula_mem_policy_profile_t *policy, int64_t delta)
+{
+    /* Memory in use is tracked even when frozen */
+    policy->live_bytes += delta;
+    if (policy->live_bytes > policy->peak_bytes) {
+        policy->peak_bytes = policy->live_bytes;
+    }
+}
+
+static void
+profile_track (chula_mem_policy_profile_t *policy, size_t size)
+{
+    int               n      = 0;
+    int               skip   = 0;
+    chula_mem_site_t *site   = NULL;
+    void             *frames[CHULA_MEM_SITE_DEPTH + 4];
+
+    if (! policy->track_sites) {
+        return;
+    }
+
+#ifdef HAVE_BACKTRACE
+    n = backtrace (frames, CHULA_MEM_SITE_DEPTH + 4);
+
+    /* Skip the memory manager frames: start at the allocation caller */
+    for (int i=0; i < n; i++) {
+        if (frames[i] == current_caller) {
+            skip = i;
+            break;
+        }
+    }
+#endif
+
+    n -= skip;
+    if (n > CHULA_MEM_SITE_DEPTH) {
+        n = CHULA_MEM_SITE_DEPTH;
+    }
+
+    for (uint32_t i=0; i < policy->n_sites; i++) {
+        if ((policy->sites[i].n_frames == n) &&
+            (memcmp (policy->sites[i].frames, frames + skip, n * sizeof(void *)) == 0))
+        {
+            site = &policy->sites[i];
+            break;
+        }
+    }
+
+    if (site == NULL) {
+        if (policy->n_sites >= CHULA_MEM_SITES_MAX) {
+            policy->n_untracked++;
+            return;
+        }
+
+        site = &policy->sites[policy->n_sites++];
+        site->n_frames = n;
+        site->n_allocs = 0;
+        site->n_bytes  = 0;
+        memcpy (site->frames, frames + skip, n * sizeof(void *));
+    }
+
+    site->n_allocs++;
+    site->n_bytes += size;
+}
+
+FUNC_MALLOC (profile)
+{
+    void                       *mem;
+    chula_mem_policy_profile_t *policy = (chula_mem_policy_profile_t *)current_policy;
+
+    if (! current_manager->frozen) {
+        policy->counter.n_malloc++;
+        policy->counter.n_bytes += size;
+        profile_track (policy, size);
+    }
+
+    mem = CALL_MALLOC;
+    profile_live (policy, USABLE_SIZE(mem));
+
+    return mem;
+}
+
+FUNC_REALLOC (profile)
+{
+    void                       *mem;
+    int64_t                     prev   = USABLE_SIZE(ptr);
+    chula_mem_policy_profile_t *policy = (chula_mem_policy_profile_t *)current_policy;
+
+    if (! current_manager->frozen) {
+        policy->counter.n_realloc++;
+        policy->counter.n_bytes += size;
+        profile_track (policy, size);
+    }
+
+    mem = CALL_REALLOC;
+    if (mem != NULL) {
+        profile_live (policy, USABLE_SIZE(mem) - prev);
+    }
+
+    return mem;
+}
+
+FUNC_FREE (profile)
+{
+    chula_mem_policy_profile_t *policy = (chula_mem_policy_profile_t *)current_policy;
+
+    if (! current_manager->frozen) {
+        policy->counter.n_free++;
+    }
+
+    profile_live (policy, - USABLE_SIZE(ptr));
+    CALL_FREE;
+}
+
+ret_t
+chula_mem_policy_profile_init (chula_mem_policy_profile_t *polprof, bool track_sites)
+{
+    chula_mem_policy_counter_init (&polprof->counter);
+
+    polprof->track_sites          = track_sites;
+    polprof->live_bytes           = 0;
+    polprof->peak_bytes           = 0;
+    polprof->counter.base.malloc  = _profile_malloc;
+    polprof->counter.base.realloc = _profile_realloc;
+    polprof->counter.base.free    = _profile_free;
+
+    return chula_mem_policy_profile_reset (polprof);
+}
+
+ret_t
+chula_mem_policy_profile_mrproper (chula_mem_policy_profile_t *polprof)
+{
+    return chula_mem_policy_counter_mrproper (&polprof->counter);
+}
+
+ret_t
+chula_mem_policy_profile_reset (chula_mem_policy_profile_t *polprof)
+{
+    polprof->counter.n_malloc  = 0;
+    polprof->counter.n_realloc = 0;
+    polprof->counter.n_free    = 0;
+    polprof->counter.n_bytes   = 0;
+    polprof->n_sites           = 0;
+    polprof->n_untracked       = 0;
+
+    return ret_ok;
+}
+
+ret_t
+chula_mem_policy_profile_reset_peak (chula_mem_policy_profile_t *polprof)
+{
+    polprof->peak_bytes = polprof->live_bytes;
+    return ret_ok;
+}
+
+ret_t
+chula_mem_policy_profile_repr (chula_mem_policy_profile_t *polprof,
+                               uint32_t                    max_sites,
+                               chula_buffer_t             *buf)
+{
+    bool              frozen = false;
+    chula_mem_site_t *sorted[CHULA_MEM_SITES_MAX];
+
+    /* Sites with more allocations first */
+    for (uint32_t i=0; i < polprof->n_sites; i++) {
+        uint32_t j = i;
+
+        while ((j > 0) && (sorted[j-1]->n_allocs < polprof->sites[i].n_allocs)) {
+            sorted[j] = sorted[j-1];
+            j--;
+        }
+        sorted[j] = &polprof->sites[i];
+    }
+
+    if ((max_sites == 0) || (max_sites > polprof->n_sites)) {
+        max_sites = polprof->n_sites;
+    }
+
+    /* The report allocates: it must not be accounted */
+    if (current_manager != NULL) {
+        frozen = current_manager->frozen;
+        chula_mem_mgr_freeze (current_manager);
+    }
+
+    for (uint32_t i=0; i < max_sites; i++) {
+        chula_mem_site_t *site = sorted[i];
+
+        chula_buffer_add_va (buf, "%u allocs, %llu bytes\n",
+                             site->n_allocs, (unsigned long long) site->n_bytes);
+
+#ifdef HAVE_BACKTRACE
+        char **symbols = backtrace_symbols (site->frames, site->n_frames);
+        if (symbols != NULL) {
+            for (int f=0; f < site->n_frames; f++) {
+                chula_buffer_add_va (buf, "    %s\n", symbols[f]);
+            }
+            free (symbols);
+        }
+#endif
+    }
+
+    if (polprof->n_untracked > 0) {
+        chula_buffer_add_va (buf, "%u allocs from untracked sites\n", polprof->n_untracked);
+    }
+
+    if ((current_manager != NULL) && (! frozen)) {
+        chula_mem_mgr_thaw (current_manager);
+    }
+
+    return ret_ok;
+}
+
+
 /* Scheduled Failure Memory Policy
  */
 
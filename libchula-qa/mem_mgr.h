@@ -55,8 +55,29 @@ typedef struct {
     uint32_t           n_malloc;
     uint32_t           n_realloc;
     uint32_t           n_free;
+    uint64_t           n_bytes;
 } chula_mem_policy_counter_t;
 
+#define CHULA_MEM_SITE_DEPTH 8
+#define CHULA_MEM_SITES_MAX  128
+
+typedef struct {
+    void              *frames[CHULA_MEM_SITE_DEPTH];
+    int                n_frames;
+    uint32_t           n_allocs;
+    uint64_t           n_bytes;
+} chula_mem_site_t;
+
+typedef struct {
+    chula_mem_policy_counter_t counter;
+    bool                       track_sites;
+    chula_mem_site_t           sites[CHULA_MEM_SITES_MAX];
+    uint32_t                   n_sites;
+    uint32_t                   n_untracked;
+    int64_t                    live_bytes;
+    int64_t                    peak_bytes;
+} chula_mem_policy_profile_t;
+
 typedef struct {
     chula_mem_policy_t base;
     uint32_t           counter;
@@ -84,6 +105,13 @@ ret_t chula_mem_policy_random_mrproper (chula_mem_policy_random_t *polran);
 ret_t chula_mem_policy_counter_init     (chula_mem_policy_counter_t *polcnt);
 ret_t chula_mem_policy_counter_mrproper (chula_mem_policy_counter_t *polcnt);
 
+/* Memory Policy: Profile (counter + allocation sites) */
+ret_t chula_mem_policy_profile_init     (chula_mem_policy_profile_t *polprof, bool track_sites);
+ret_t chula_mem_policy_profile_mrproper (chula_mem_policy_profile_t *polprof);
+ret_t chula_mem_policy_profile_reset    (chula_mem_policy_profile_t *polprof);
+ret_t chula_mem_policy_profile_reset_peak (chula_mem_policy_profile_t *polprof);
+ret_t chula_mem_policy_profile_repr     (chula_mem_policy_profile_t *polprof, uint32_t max_sites, chula_buffer_t *buf);
+
 /* Memory Policy: Scheduled Failure */
 ret_t chula_mem_policy_sched_fail_init     (chula_mem_policy_sched_fail_t *polschd, uint32_t fail_after, uint32_t recover_after);
 ret_t chula_mem_policy_sched_fail_mrproper (chula_mem_policy_sched_fail_t *polschd);
@@ -215,11 +215,12 @@ chula_buffer_import (chula_buffer_t *buf, char *str, uint32_t len)
 ret_t
 chula_buffer_mrproper (chula_buffer_t *buf)
 {
-    if (buf->buf) {
+    /* Read-only buffers do not own their memory */
+    if ((buf->buf) && (buf->size > 0)) {
         free (buf->buf);
-        buf->buf = NULL;
     }
 
+    buf->buf  = NULL;
     buf->len  = 0;
     buf->size = 0;
 
@@ -229,7 +230,7 @@ chula_buffer_mrproper (chula_buffer_t *buf)
 void
 chula_buffer_clean (chula_buffer_t *buf)
 {
-    if (buf->buf != NULL)
+    if (buf->size > 0)
         buf->buf[0] = (uint8_t) '\0';
     buf->len = 0;
 }
@@ -281,6 +282,9 @@ realloc_inc_bufsize (chula_buffer_t *buf, size_t incsize)
     uint8_t *pbuf;
     size_t   newsize = buf->size + incsize + REALLOC_EXTRA_SIZE + 1;
 
+    if (unlikely (chula_buffer_is_readonly (buf)))
+        return ret_deny;
+
     pbuf = (uint8_t *) realloc(buf->buf, newsize);
     if (unlikely (pbuf == NULL)) return ret_nomem;
 
@@ -295,6 +299,9 @@ realloc_new_bufsize (chula_buffer_t *buf, size_t newsize)
 {
     uint8_t *pbuf;
 
+    if (unlikely (chula_buffer_is_readonly (buf)))
+        return ret_deny;
+
     newsize += REALLOC_EXTRA_SIZE + 1;
 
     pbuf = (uint8_t *) realloc(buf->buf, newsize);
@@ -319,7 +326,7 @@ chula_buffer_add (chula_buffer_t *buf, const char *txt, size_t size)
      */
     available = buf->size - buf->len;
 
-    if ((uint32_t) available < (size+1)) {
+    if ((available < 0) || ((uint32_t) available < (size+1))) {
         ret = realloc_inc_bufsize(buf, size - available);
         if (unlikely (ret != ret_ok)) return ret;
     }
@@ -908,7 +915,7 @@ chula_buffer_prepend (chula_buffer_t *buf, const char *txt, size_t size)
 
     /* Get memory
      */
-    if ((uint32_t) free < (size+1)) {
+    if ((free < 0) || ((uint32_t) free < (size+1))) {
         ret = realloc_inc_bufsize(buf, size - free);
         if (unlikely (ret != ret_ok)) return ret;
     }
@@ -992,6 +999,9 @@ chula_buffer_ensure_size (chula_buffer_t *buf, size_t size)
 
     /* It already has memory, but it needs more..
      */
+    if (unlikely (chula_buffer_is_readonly (buf)))
+        return ret_deny;
+
     pbuf = (uint8_t *) realloc(buf->buf, size);
     if (unlikely (pbuf == NULL)) return ret_nomem;
 
@@ -60,6 +60,7 @@ typedef struct {
 #define CHULA_BUF_SLIDE_NONE         INT_MIN
 
 #define chula_buffer_is_empty(b)        (BUF(b)->len == 0)
+#define chula_buffer_is_readonly(b)     ((BUF(b)->buf != NULL) && (BUF(b)->size == 0))
 #define chula_buffer_add_str(b,s)       chula_buffer_add      (b, s, sizeof(s)-1)
 #define chula_buffer_prepend_str(b,s)   chula_buffer_prepend  (b, s, sizeof(s)-1)
 #define chula_buffer_prepend_buf(b,s)   chula_buffer_prepend  (b, (char *)(s)->buf, (s)->len)
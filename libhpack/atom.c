@@ -0,0 +1,267 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file      atom.c
+ * @brief     Interned Header Field names (atoms).
+ *
+ * Names are kept in an open addressing hash table (FNV-1a hashes, linear
+ * probing) that doubles its size when it gets half full.
+ *
+ * @date      October, 2026
+ */
+
+#include "atom.h"
+#include "macros.h"
+
+
+/**
+ * @cond INTERNAL
+ * FNV-1a hash of a name.
+ * @endcond
+ */
+static inline uint32_t
+hash_name (const uint8_t *p, uint32_t len)
+{
+    uint32_t h = 2166136261u;
+
+    for (uint32_t i=0; i < len; i++) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+
+    return h;
+}
+
+
+/**
+ * @cond INTERNAL
+ * Finds the slot of a name, or the free slot where it would go.
+ * @endcond
+ */
+static hpack_atoms_entry_t *
+find_slot (hpack_atoms_entry_t *slots,
+           uint32_t             num_slots,
+           uint32_t             hash,
+           const uint8_t       *name,
+           uint32_t             len)
+{
+    hpack_atoms_entry_t *e;
+    uint32_t             i  = hash & (num_slots - 1);
+
+    while (true) {
+        e = &slots[i];
+
+        if (e->atom == HPACK_ATOM_NONE)
+            return e;
+
+        if ((e->hash == hash) &&
+            (e->name.len == len) &&
+            (memcmp (e->name.buf, name, len) == 0))
+            return e;
+
+        i = (i + 1) & (num_slots - 1);
+    }
+}
+
+
+static ret_t
+grow (hpack_atoms_t *atoms)
+{
+    hpack_atoms_entry_t *slots;
+    hpack_atoms_entry_t *e;
+    uint32_t             num_slots = atoms->num_slots * 2;
+
+    slots = (hpack_atoms_entry_t *) calloc (num_slots, sizeof(hpack_atoms_entry_t));
+    if (unlikely (slots == NULL))
+        return ret_nomem;
+
+    for (uint32_t i=0; i < atoms->num_slots; i++) {
+        if (atoms->slots[i].atom == HPACK_ATOM_NONE)
+            continue;
+
+        e = find_slot (slots, num_slots, atoms->slots[i].hash,
+                       atoms->slots[i].name.buf, atoms->slots[i].name.len);
+        *e = atoms->slots[i];
+    }
+
+    free (atoms->slots);
+    atoms->slots     = slots;
+    atoms->num_slots = num_slots;
+
+    return ret_ok;
+}
+
+
+static ret_t
+insert (hpack_atoms_t  *atoms,
+        chula_buffer_t *name,
+        uint16_t        atom_new,
+        uint16_t       *atom)
+{
+    ret_t                ret;
+    hpack_atoms_entry_t *e;
+    uint32_t             hash = hash_name (name->buf, name->len);
+
+    e = find_slot (atoms->slots, atoms->num_slots, hash, name->buf, name->len);
+    if (e->atom != HPACK_ATOM_NONE) {
+        *atom = e->atom;
+        return ret_ok;
+    }
+
+    chula_buffer_init (&e->name);
+    ret = chula_buffer_add_buffer (&e->name, name);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    e->hash = hash;
+    e->atom = atom_new;
+    *atom   = atom_new;
+
+    /* Keep the table at most half full. */
+    if (++atoms->num_atoms * 2 > atoms->num_slots)
+        return grow (atoms);
+
+    return ret_ok;
+}
+
+
+/** Atoms table initializer
+ *
+ * Initializes an atoms table with the names of the Static Table.
+ *
+ * @param[out] atoms  Atoms table to initialize.
+ *
+ * @return Result of the operation.
+ * @retval ret_nomem  Not enough memory.
+ * @retval ret_ok     Initialized successfully.
+ */
+ret_t
+hpack_atoms_init (hpack_atoms_t *atoms)
+{
+    ret_t ret;
+
+    atoms->num_slots = HPACK_ATOMS_SLOTS;
+    atoms->num_atoms = 0;
+    atoms->next      = HPACK_ATOM_USER;
+
+    atoms->slots = (hpack_atoms_entry_t *) calloc (atoms->num_slots, sizeof(hpack_atoms_entry_t));
+    if (unlikely (atoms->slots == NULL))
+        return ret_nomem;
+
+    atoms->static_atoms[0] = HPACK_ATOM_NONE;
+
+    for (uint16_t n=1; n <= STATIC_ENTRIES; n++) {
+        chula_buffer_t name = *hpack_header_table_static_name (n);
+
+        ret = insert (atoms, &name, n, &atoms->static_atoms[n]);
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    return ret_ok;
+}
+
+
+ret_t
+hpack_atoms_mrproper (hpack_atoms_t *atoms)
+{
+    for (uint32_t i=0; i < atoms->num_slots; i++) {
+        if (atoms->slots[i].atom != HPACK_ATOM_NONE) {
+            chula_buffer_mrproper (&atoms->slots[i].name);
+        }
+    }
+
+    free (atoms->slots);
+    atoms->slots = NULL;
+
+    return ret_ok;
+}
+
+HPACK_ADD_FUNC_NEW(atoms);
+HPACK_ADD_FUNC_FREE(atoms);
+
+
+/** Register a Header Field name
+ *
+ * Names already known, including those of the Static Table, keep their atom.
+ *
+ * @param[in,out] atoms  Atoms table.
+ * @param[in]     name   Name to register.
+ * @param[out]    atom   Atom of the name.
+ *
+ * @return Result of the operation.
+ * @retval ret_nomem  Not enough memory.
+ * @retval ret_error  There are no atoms left.
+ * @retval ret_ok     The name is registered.
+ */
+ret_t
+hpack_atoms_register (hpack_atoms_t  *atoms,
+                      chula_buffer_t *name,
+                      uint16_t       *atom)
+{
+    ret_t ret;
+
+    if (unlikely (atoms->next == UINT16_MAX))
+        return ret_error;
+
+    ret = insert (atoms, name, atoms->next, atom);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    if (*atom == atoms->next)
+        atoms->next++;
+
+    return ret_ok;
+}
+
+
+/** Get the atom of a Header Field name
+ *
+ * @param[in]  atoms  Atoms table.
+ * @param[in]  name   Name to look up.
+ * @param[out] atom   Atom of the name, HPACK_ATOM_NONE if it is unknown.
+ *
+ * @return Result of the operation.
+ * @retval ret_not_found  The name is unknown.
+ * @retval ret_ok         The name was found.
+ */
+ret_t
+hpack_atoms_lookup (hpack_atoms_t  *atoms,
+                    chula_buffer_t *name,
+                    uint16_t       *atom)
+{
+    hpack_atoms_entry_t *e;
+
+    e = find_slot (atoms->slots, atoms->num_slots,
+                   hash_name (name->buf, name->len), name->buf, name->len);
+
+    *atom = e->atom;
+    return (e->atom == HPACK_ATOM_NONE) ? ret_not_found : ret_ok;
+}
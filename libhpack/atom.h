@@ -0,0 +1,108 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file      atom.h
+ * @brief     Interned Header Field names (atoms).
+ *
+ * An atom is a small integer that identifies a Header Field name, so code
+ * handling decoded fields can switch on integers instead of comparing strings.
+ *
+ * The names in the Static Table are always known. Their atom is the index of
+ * the first Static Table entry with that name, so for instance the atom of
+ * `:status` is [hpack_static_status_200](@ref hpack_header_table_static_t). Any
+ * other name can be registered, and it will get an atom starting at
+ * HPACK_ATOM_USER.
+ *
+ * Atom tables can be shared by many parsers, but names must not be registered
+ * while they are in use.
+ *
+ * @date      October, 2026
+ */
+
+#ifndef LIBHPACK_ATOM_H
+#define LIBHPACK_ATOM_H
+
+#if !defined(HPACK_H_INSIDE) && !defined (HPACK_COMPILATION)
+# error "Only <libhpack/libhpack.h> can be included directly."
+#endif
+
+#include <libchula/libchula.h>
+#include <libhpack/header_table.h>
+
+/** Unknown name. */
+#define HPACK_ATOM_NONE   0
+
+/** First atom for registered names. */
+#define HPACK_ATOM_USER   64
+
+/** Initial number of slots of the hash table. It must be a power of two. */
+#define HPACK_ATOMS_SLOTS 128
+
+/**
+ * Entry of the atoms hash table.
+ */
+typedef struct {
+    uint32_t       hash;  /**< Hash of the name. */
+    uint16_t       atom;  /**< Atom of the name, HPACK_ATOM_NONE if the slot is free. */
+    chula_buffer_t name;  /**< Interned name. */
+} hpack_atoms_entry_t;
+
+/**
+ * Atoms table.
+ */
+typedef struct {
+    hpack_atoms_entry_t *slots;                          /**< Open addressing hash table. */
+    uint32_t             num_slots;                      /**< Number of slots. */
+    uint32_t             num_atoms;                      /**< Number of used slots. */
+    uint16_t             next;                           /**< Next atom to assign to a registered name. */
+    uint16_t             static_atoms[STATIC_ENTRIES+1]; /**< Atom of the name of each Static Table entry. */
+} hpack_atoms_t;
+
+
+ret_t hpack_atoms_new      (hpack_atoms_t **atoms);
+ret_t hpack_atoms_free     (hpack_atoms_t  *atoms);
+ret_t hpack_atoms_init     (hpack_atoms_t  *atoms);
+ret_t hpack_atoms_mrproper (hpack_atoms_t  *atoms);
+
+ret_t hpack_atoms_register (hpack_atoms_t  *atoms,
+                            chula_buffer_t *name,
+                            uint16_t       *atom);
+ret_t hpack_atoms_lookup   (hpack_atoms_t  *atoms,
+                            chula_buffer_t *name,
+                            uint16_t       *atom);
+
+/** Atom of the name of a Static Table entry, HPACK_ATOM_NONE if out of range. */
+#define hpack_atoms_static(atoms,static_idx) \
+    (((static_idx) <= STATIC_ENTRIES) ? (atoms)->static_atoms[(static_idx)] : HPACK_ATOM_NONE)
+
+#endif /* LIBHPACK_ATOM_H */
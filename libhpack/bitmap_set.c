@@ -480,7 +480,7 @@ hpack_set_iter_next (hpack_set_iterator_t *iter)
     while ((HPACK_SET_NUM_ENTRIES > iter->entry) && (-1 == result)) {
 
         /* We only check the bits if we know there's something in the remaining bits of this entry */
-        if (iter->set[iter->entry] & ~((hpack_set_entry_t) (1 << iter->bit)-1)) {
+        if (iter->set[iter->entry] & ~(((hpack_set_entry_t) 1 << iter->bit) - 1)) {
 
             /* Check remaining bits from this entry */
             while ((iter->bit < HPACK_SET_BITS_IN_ENTRY) && (-1 == result)) {
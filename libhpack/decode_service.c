@@ -0,0 +1,592 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file      decode_service.c
+ * @brief     Parallel decoding of independent connections.
+ *
+ * The queues of jobs and inboxes are intrusive multiple producers, single
+ * consumer queues (Vyukov). The number of jobs pending in a lane decides who
+ * schedules it: the submission that finds it at zero queues the lane, and
+ * the worker that takes it down to zero lets it go. A lane is therefore in
+ * at most one inbox or deque, and decoded by at most one worker at a time.
+ *
+ * The deques are Chase-Lev deques, with the memory ordering of "Correct and
+ * Efficient Work-Stealing for Weak Memory Models" (Le et al., 2013). They do
+ * not grow: they have room for every lane of the service.
+ *
+ * @date      October, 2026
+ */
+
+#include <sched.h>
+#include <unistd.h>
+
+#include "decode_service.h"
+#include "macros.h"
+
+/* Jobs of a lane decoded before letting other lanes go first */
+#define LANE_BATCH 16
+
+typedef hpack_decode_node_t    node_t;
+typedef hpack_decode_queue_t   queue_t;
+typedef hpack_decode_deque_t   deque_t;
+typedef hpack_decode_lane_t    lane_t;
+typedef hpack_decode_worker_t  worker_t;
+
+
+/* Queues
+ */
+
+static void
+queue_init (queue_t *q)
+{
+    q->stub.next = NULL;
+    q->head      = &q->stub;
+    q->tail      = &q->stub;
+}
+
+static void
+queue_push (queue_t *q,
+            node_t  *n)
+{
+    node_t *prev;
+
+    n->next = NULL;
+
+    prev = __atomic_exchange_n (&q->head, n, __ATOMIC_SEQ_CST);
+    __atomic_store_n (&prev->next, n, __ATOMIC_RELEASE);
+}
+
+/* NULL if empty, or if a producer has not finished linking its node */
+static node_t *
+queue_pop (queue_t *q)
+{
+    node_t *tail = q->tail;
+    node_t *next = __atomic_load_n (&tail->next, __ATOMIC_ACQUIRE);
+
+    if (tail == &q->stub) {
+        if (next == NULL)
+            return NULL;
+
+        q->tail = next;
+        tail    = next;
+        next    = __atomic_load_n (&next->next, __ATOMIC_ACQUIRE);
+    }
+
+    if (next != NULL) {
+        q->tail = next;
+        return tail;
+    }
+
+    if (tail != __atomic_load_n (&q->head, __ATOMIC_SEQ_CST))
+        return NULL;
+
+    /* Last node: the stub goes behind it */
+    queue_push (q, &q->stub);
+
+    next = __atomic_load_n (&tail->next, __ATOMIC_ACQUIRE);
+    if (next != NULL) {
+        q->tail = next;
+        return tail;
+    }
+
+    return NULL;
+}
+
+
+/* Deques
+ */
+
+static ret_t
+deque_init (deque_t  *d,
+            uint32_t  size)
+{
+    uint32_t n = 1;
+
+    while (n < size) {
+        n <<= 1;
+    }
+
+    d->lanes = (lane_t **) calloc (n, sizeof(lane_t *));
+    if (unlikely (d->lanes == NULL))
+        return ret_nomem;
+
+    d->mask   = n - 1;
+    d->top    = 0;
+    d->bottom = 0;
+
+    return ret_ok;
+}
+
+static void
+deque_push (deque_t *d,
+            lane_t  *lane)
+{
+    int64_t b = __atomic_load_n (&d->bottom, __ATOMIC_RELAXED);
+
+    __atomic_store_n (&d->lanes[b & d->mask], lane, __ATOMIC_RELAXED);
+    __atomic_thread_fence (__ATOMIC_RELEASE);
+    __atomic_store_n (&d->bottom, b + 1, __ATOMIC_RELAXED);
+}
+
+static lane_t *
+deque_take (deque_t *d)
+{
+    int64_t  t;
+    lane_t  *lane = NULL;
+    int64_t  b    = __atomic_load_n (&d->bottom, __ATOMIC_RELAXED) - 1;
+
+    __atomic_store_n (&d->bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence (__ATOMIC_SEQ_CST);
+    t = __atomic_load_n (&d->top, __ATOMIC_RELAXED);
+
+    if (t > b) {
+        /* Empty */
+        __atomic_store_n (&d->bottom, b + 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    lane = __atomic_load_n (&d->lanes[b & d->mask], __ATOMIC_RELAXED);
+
+    if (t == b) {
+        /* Last one: race the thieves for it */
+        if (! __atomic_compare_exchange_n (&d->top, &t, t + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+            lane = NULL;
+        }
+        __atomic_store_n (&d->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+
+    return lane;
+}
+
+static lane_t *
+deque_steal (deque_t *d)
+{
+    int64_t  b;
+    lane_t  *lane;
+    int64_t  t = __atomic_load_n (&d->top, __ATOMIC_ACQUIRE);
+
+    __atomic_thread_fence (__ATOMIC_SEQ_CST);
+    b = __atomic_load_n (&d->bottom, __ATOMIC_ACQUIRE);
+
+    if (t >= b)
+        return NULL;
+
+    lane = __atomic_load_n (&d->lanes[t & d->mask], __ATOMIC_RELAXED);
+
+    if (! __atomic_compare_exchange_n (&d->top, &t, t + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        return NULL;
+
+    return lane;
+}
+
+static bool
+deque_is_empty (deque_t *d)
+{
+    return (__atomic_load_n (&d->bottom, __ATOMIC_RELAXED) <= __atomic_load_n (&d->top, __ATOMIC_RELAXED));
+}
+
+
+/* Workers
+ */
+
+static void
+worker_wake (worker_t *w)
+{
+    pthread_mutex_lock (&w->mutex);
+    w->wake = true;
+    pthread_cond_signal (&w->cond);
+    pthread_mutex_unlock (&w->mutex);
+}
+
+static void
+worker_block (worker_t *w)
+{
+    pthread_mutex_lock (&w->mutex);
+    while (! w->wake) {
+        pthread_cond_wait (&w->cond, &w->mutex);
+    }
+    w->wake = false;
+    pthread_mutex_unlock (&w->mutex);
+}
+
+/* Takes over the wake up of an idle worker. Whoever clears its flag has to
+ * wake it.
+ */
+static bool
+worker_claim (worker_t *w)
+{
+    return (__atomic_load_n (&w->idle, __ATOMIC_RELAXED) &&
+            __atomic_exchange_n (&w->idle, 0, __ATOMIC_SEQ_CST));
+}
+
+/* Gets an idle worker to steal the lanes left in the deque of @a w */
+static void
+wake_peer (worker_t *w)
+{
+    hpack_decode_service_t *service = w->service;
+    unsigned int            me      = w - service->workers;
+
+    for (unsigned int i=1; i < service->num_workers; i++) {
+        worker_t *peer = &service->workers[(me + i) % service->num_workers];
+
+        if (worker_claim (peer)) {
+            worker_wake (peer);
+            return;
+        }
+    }
+}
+
+static lane_t *
+find_lane (worker_t *w)
+{
+    node_t                 *node;
+    lane_t                 *lane;
+    hpack_decode_service_t *service = w->service;
+    unsigned int            me      = w - service->workers;
+
+    /* Lanes scheduled on this worker */
+    while ((node = queue_pop (&w->inbox)) != NULL) {
+        deque_push (&w->deque, (lane_t *) node);
+    }
+
+    lane = deque_take (&w->deque);
+    if (lane != NULL) {
+        if (! deque_is_empty (&w->deque)) {
+            wake_peer (w);
+        }
+        return lane;
+    }
+
+    /* Steal from the others */
+    for (unsigned int i=1; i < service->num_workers; i++) {
+        worker_t *victim = &service->workers[(me + i) % service->num_workers];
+
+        lane = deque_steal (&victim->deque);
+        if (lane != NULL)
+            return lane;
+    }
+
+    return NULL;
+}
+
+static void
+run_lane (worker_t *w,
+          lane_t   *lane)
+{
+    node_t             *node;
+    hpack_decode_job_t *job;
+
+    for (unsigned int n=0; n < LANE_BATCH; n++) {
+        /* There is a job: its producer may still be linking it */
+        while ((node = queue_pop (&lane->jobs)) == NULL) {
+            sched_yield();
+        }
+
+        job = (hpack_decode_job_t *) node;
+
+        job->consumed = 0;
+        job->ret      = hpack_header_parser_all (lane->parser, job->block, 0, &job->consumed);
+
+        /* The job belongs to the caller from now on. The lane does not,
+         * until it is released below.
+         */
+        job->func (job);
+
+        /* Nothing else to do: the next submission schedules the lane again.
+         * The lane is not touched after this.
+         */
+        if (__atomic_sub_fetch (&lane->pending, 1, __ATOMIC_ACQ_REL) == 0)
+            return;
+    }
+
+    deque_push (&w->deque, lane);
+}
+
+static void *
+worker_main (void *arg)
+{
+    lane_t   *lane;
+    worker_t *w = arg;
+
+    while (true) {
+        lane = find_lane (w);
+        if (lane != NULL) {
+            run_lane (w, lane);
+            continue;
+        }
+
+        /* Look once more after raising the flag: submissions check it
+         * after queueing a lane.
+         */
+        __atomic_store_n (&w->idle, 1, __ATOMIC_SEQ_CST);
+
+        lane = find_lane (w);
+        if (lane != NULL) {
+            __atomic_store_n (&w->idle, 0, __ATOMIC_SEQ_CST);
+            run_lane (w, lane);
+            continue;
+        }
+
+        if (__atomic_load_n (&w->service->stop, __ATOMIC_SEQ_CST))
+            break;
+
+        worker_block (w);
+    }
+
+    return NULL;
+}
+
+
+/* Service
+ */
+
+/* Joins the first @a num_threads workers, and frees all of them */
+static void
+stop_workers (hpack_decode_service_t *service,
+              unsigned int            num_threads)
+{
+    __atomic_store_n (&service->stop, true, __ATOMIC_SEQ_CST);
+
+    for (unsigned int i=0; i < num_threads; i++) {
+        worker_wake (&service->workers[i]);
+    }
+
+    for (unsigned int i=0; i < num_threads; i++) {
+        pthread_join (service->workers[i].thread, NULL);
+    }
+
+    for (unsigned int i=0; i < service->num_workers; i++) {
+        worker_t *w = &service->workers[i];
+
+        pthread_mutex_destroy (&w->mutex);
+        pthread_cond_destroy (&w->cond);
+        free (w->deque.lanes);
+    }
+
+    free (service->workers);
+    service->workers     = NULL;
+    service->num_workers = 0;
+}
+
+static unsigned int
+num_cpus (void)
+{
+    long n = sysconf (_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? (unsigned int) n : 1;
+}
+
+/** Start a decoding service
+ *
+ * @param[out] service      Service to initialize.
+ * @param[in]  num_workers  Worker threads, 0 for one per online CPU.
+ * @param[in]  max_lanes    Maximum number of lanes.
+ *
+ * @return Result of the operation.
+ */
+ret_t
+hpack_decode_service_init (hpack_decode_service_t *service,
+                           unsigned int            num_workers,
+                           uint32_t                max_lanes)
+{
+    ret_t        ret;
+    unsigned int started;
+
+    if (num_workers == 0) {
+        num_workers = num_cpus();
+    }
+
+    service->workers     = (worker_t *) calloc (num_workers, sizeof(worker_t));
+    service->num_workers = 0;
+    service->max_lanes   = max_lanes;
+    service->num_lanes   = 0;
+    service->next        = 0;
+    service->stop        = false;
+
+    if (unlikely (service->workers == NULL))
+        return ret_nomem;
+
+    /* Workers steal from each other: all of them are set up before any
+     * thread starts.
+     */
+    for (unsigned int i=0; i < num_workers; i++) {
+        worker_t *w = &service->workers[i];
+
+        w->service = service;
+        w->idle    = 0;
+        w->wake    = false;
+        queue_init (&w->inbox);
+
+        ret = deque_init (&w->deque, max_lanes);
+        if (unlikely (ret != ret_ok)) {
+            stop_workers (service, 0);
+            return ret;
+        }
+
+        pthread_mutex_init (&w->mutex, NULL);
+        pthread_cond_init (&w->cond, NULL);
+
+        service->num_workers++;
+    }
+
+    for (started=0; started < num_workers; started++) {
+        worker_t *w = &service->workers[started];
+
+        if (unlikely (pthread_create (&w->thread, NULL, worker_main, w) != 0)) {
+            stop_workers (service, started);
+            return ret_error;
+        }
+    }
+
+    return ret_ok;
+}
+
+/** Stop a decoding service
+ *
+ * Jobs already submitted are decoded before the workers exit.
+ *
+ * @param[in,out] service  Service to stop.
+ *
+ * @return Result of the operation.
+ */
+ret_t
+hpack_decode_service_mrproper (hpack_decode_service_t *service)
+{
+    stop_workers (service, service->num_workers);
+    return ret_ok;
+}
+
+/** Add the decoder of a connection
+ *
+ * @param[in,out] service  Service.
+ * @param[out]    lane     Lane to initialize.
+ * @param[in]     parser   Decoder of the connection. Only the workers use
+ *                         it until the lane is removed.
+ *
+ * @return Result of the operation.
+ * @retval ret_deny  The service has max_lanes lanes already.
+ * @retval ret_ok    The lane is ready for jobs.
+ */
+ret_t
+hpack_decode_service_add_lane (hpack_decode_service_t *service,
+                               hpack_decode_lane_t    *lane,
+                               hpack_header_parser_t  *parser)
+{
+    if (__atomic_add_fetch (&service->num_lanes, 1, __ATOMIC_RELAXED) > service->max_lanes) {
+        __atomic_sub_fetch (&service->num_lanes, 1, __ATOMIC_RELAXED);
+        return ret_deny;
+    }
+
+    lane->parser  = parser;
+    lane->pending = 0;
+    queue_init (&lane->jobs);
+
+    return ret_ok;
+}
+
+/** Remove the decoder of a connection
+ *
+ * The worker releases the lane after the function of its last job returns,
+ * so the lane can still be busy when that function has already reported
+ * the job as done. Retry until it stops returning @c ret_eagain. The lane,
+ * and its parser, can be freed once it has been removed. It cannot be
+ * removed from the function of one of its own jobs.
+ *
+ * @param[in,out] service  Service.
+ * @param[in,out] lane     Lane to remove.
+ *
+ * @return Result of the operation.
+ * @retval ret_eagain  The lane has jobs still being decoded, or a worker
+ *                     has not released it yet.
+ * @retval ret_ok      The lane was removed.
+ */
+ret_t
+hpack_decode_service_remove_lane (hpack_decode_service_t *service,
+                                  hpack_decode_lane_t    *lane)
+{
+    if (__atomic_load_n (&lane->pending, __ATOMIC_ACQUIRE) != 0)
+        return ret_eagain;
+
+    __atomic_sub_fetch (&service->num_lanes, 1, __ATOMIC_RELAXED);
+    return ret_ok;
+}
+
+/** Submit a Header Block to decode
+ *
+ * Safe to call from any thread, including from the function of a job.
+ *
+ * @param[in,out] service  Service.
+ * @param[in,out] lane     Lane of the connection the Header Block belongs to.
+ * @param[in]     job      Header Block and function to call once decoded.
+ *
+ * @return Result of the operation.
+ */
+ret_t
+hpack_decode_service_submit (hpack_decode_service_t *service,
+                             hpack_decode_lane_t    *lane,
+                             hpack_decode_job_t     *job)
+{
+    worker_t     *w;
+    bool          claimed = false;
+    unsigned int  start;
+
+    if (unlikely ((job->func == NULL) || (job->block == NULL)))
+        return ret_error;
+
+    queue_push (&lane->jobs, &job->node);
+
+    /* Being decoded, or already scheduled */
+    if (__atomic_fetch_add (&lane->pending, 1, __ATOMIC_ACQ_REL) != 0)
+        return ret_ok;
+
+    /* An idle worker if there is one, the next one otherwise */
+    start = __atomic_fetch_add (&service->next, 1, __ATOMIC_RELAXED);
+    w     = &service->workers[start % service->num_workers];
+
+    for (unsigned int i=0; i < service->num_workers; i++) {
+        worker_t *candidate = &service->workers[(start + i) % service->num_workers];
+
+        if (worker_claim (candidate)) {
+            w       = candidate;
+            claimed = true;
+            break;
+        }
+    }
+
+    queue_push (&w->inbox, &lane->node);
+
+    /* It may have gone idle without seeing the lane */
+    if (claimed || __atomic_exchange_n (&w->idle, 0, __ATOMIC_SEQ_CST)) {
+        worker_wake (w);
+    }
+
+    return ret_ok;
+}
@@ -0,0 +1,172 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file      decode_service.h
+ * @brief     Parallel decoding of independent connections.
+ *
+ * A pool of worker threads decoding Header Blocks with
+ * hpack_header_parser_all(). Each decoder, with the decoding context of a
+ * connection, is wrapped in a lane. Jobs submitted to the same lane are
+ * decoded one after another, in the order they were submitted, while lanes
+ * are decoded in parallel.
+ *
+ * Submitting a job does not lock: it is queued in its lane, and a lane with
+ * new work is queued in the inbox of a worker. Workers keep the lanes in a
+ * work-stealing deque, and idle workers steal lanes from the busy ones. A
+ * worker only blocks when there is nothing left to decode.
+ *
+ * The function of a job is called from the worker that decoded it. The
+ * fields are in the store registered in the parser of the lane, and the
+ * next job of the lane is not decoded until the function returns. The
+ * worker still uses the lane after that, so the function must not free
+ * the lane or its parser: remove the lane with
+ * hpack_decode_service_remove_lane() first, once the function returned.
+ *
+ * @date      October, 2026
+ */
+
+#ifndef LIBHPACK_DECODE_SERVICE_H
+#define LIBHPACK_DECODE_SERVICE_H
+
+#if !defined(HPACK_H_INSIDE) && !defined (HPACK_COMPILATION)
+# error "Only <libhpack/libhpack.h> can be included directly."
+#endif
+
+#include <pthread.h>
+
+#include <libchula/libchula.h>
+#include <libhpack/header_parser.h>
+
+/**
+ * Link of the lock-free queues. First member of the queued structures.
+ */
+typedef struct hpack_decode_node {
+    struct hpack_decode_node *next;
+} hpack_decode_node_t;
+
+/**
+ * Multiple producers, single consumer queue.
+ */
+typedef struct {
+    hpack_decode_node_t *head;  /**< Last node queued, written by the producers. */
+    hpack_decode_node_t *tail;  /**< Next node to dequeue, owned by the consumer. */
+    hpack_decode_node_t  stub;  /**< Node keeping the queue linked when it is empty. */
+} hpack_decode_queue_t;
+
+/* Forward declaration */
+typedef struct hpack_decode_job hpack_decode_job_t;
+
+/**
+ * Function called once a job has been decoded.
+ */
+typedef void (*hpack_decode_job_func_t) (hpack_decode_job_t *job);
+
+/**
+ * Header Block to decode. Owned by the caller, it must not be touched from
+ * its submission until its function is called.
+ */
+struct hpack_decode_job {
+    hpack_decode_node_t      node;      /**< Link in the queue of the lane. */
+    chula_buffer_t          *block;     /**< Header Block to decode. */
+    hpack_decode_job_func_t  func;      /**< Called with the result. */
+    void                    *data;      /**< Free for the caller. */
+    ret_t                    ret;       /**< Result of hpack_header_parser_all(). */
+    unsigned int             consumed;  /**< Octets of @a block decoded. */
+};
+
+/**
+ * Decoder of a connection, and the jobs queued for it.
+ */
+typedef struct {
+    hpack_decode_node_t    node;     /**< Link in the inbox of a worker. */
+    hpack_header_parser_t *parser;   /**< Decoder of the connection. */
+    hpack_decode_queue_t   jobs;     /**< Jobs submitted, not decoded yet. */
+    uint32_t               pending;  /**< Jobs submitted and not finished. */
+} hpack_decode_lane_t;
+
+/**
+ * Work-stealing deque of lanes: the owner pushes and takes at the bottom,
+ * the other workers steal from the top.
+ */
+typedef struct {
+    int64_t               top;     /**< Next lane to steal. */
+    int64_t               bottom;  /**< Next free slot. */
+    hpack_decode_lane_t **lanes;   /**< Circular array of lanes. */
+    uint32_t              mask;    /**< Size of @a lanes minus one. */
+} hpack_decode_deque_t;
+
+/* Forward declaration */
+typedef struct hpack_decode_service hpack_decode_service_t;
+
+/**
+ * Worker thread.
+ */
+typedef struct {
+    hpack_decode_service_t *service;  /**< Service the worker belongs to. */
+    pthread_t               thread;   /**< Thread of the worker. */
+    hpack_decode_queue_t    inbox;    /**< Lanes with new jobs scheduled on this worker. */
+    hpack_decode_deque_t    deque;    /**< Lanes being decoded by this worker. */
+    uint32_t                idle;     /**< Whether it is about to block, or blocked. */
+    bool                    wake;     /**< Wake up call, under @a mutex. */
+    pthread_mutex_t         mutex;    /**< Only taken to block and wake up. */
+    pthread_cond_t          cond;     /**< Signaled to wake it up. */
+} hpack_decode_worker_t;
+
+/**
+ * Decoding service.
+ */
+struct hpack_decode_service {
+    hpack_decode_worker_t *workers;      /**< Worker threads. */
+    unsigned int           num_workers;  /**< Number of @a workers. */
+    uint32_t               max_lanes;    /**< Maximum number of lanes. */
+    uint32_t               num_lanes;    /**< Lanes added. */
+    uint32_t               next;         /**< Round-robin counter to pick an inbox. */
+    bool                   stop;         /**< Workers exit once there is nothing left to do. */
+};
+
+
+ret_t hpack_decode_service_init      (hpack_decode_service_t *service,
+                                      unsigned int            num_workers,
+                                      uint32_t                max_lanes);
+ret_t hpack_decode_service_mrproper  (hpack_decode_service_t *service);
+
+ret_t hpack_decode_service_add_lane    (hpack_decode_service_t *service,
+                                        hpack_decode_lane_t    *lane,
+                                        hpack_header_parser_t  *parser);
+ret_t hpack_decode_service_remove_lane (hpack_decode_service_t *service,
+                                        hpack_decode_lane_t    *lane);
+
+ret_t hpack_decode_service_submit    (hpack_decode_service_t *service,
+                                      hpack_decode_lane_t    *lane,
+                                      hpack_decode_job_t     *job);
+
+#endif /* LIBHPACK_DECODE_SERVICE_H */
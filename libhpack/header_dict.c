@@ -0,0 +1,166 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file      header_dict.c
+ * @brief     Shared read-only Header Dictionary.
+ *
+ * @date      October, 2026
+ */
+
+#include "header_dict.h"
+
+
+/** Create a new Header Dictionary
+ *
+ * The new dictionary is empty, can be populated with [add](@ref hpack_header_dict_add)
+ * and has a single reference owned by the caller.
+ *
+ * @param[out] dict  Reference to the pointer of the new Dictionary.
+ *
+ * @return Result of the operation.
+ * @retval ret_nomem  There's no memory for the new Dictionary.
+ * @retval ret_ok     Created successfully.
+ */
+ret_t
+hpack_header_dict_new (hpack_header_dict_t **dict)
+{
+    ret_t                ret;
+    hpack_header_dict_t *n;
+
+    n = (hpack_header_dict_t *) malloc (sizeof(hpack_header_dict_t));
+    if (unlikely (n == NULL))
+        return ret_nomem;
+
+    ret = hpack_header_table_init (&n->table);
+    if (unlikely (ret != ret_ok)) {
+        free (n);
+        return ret;
+    }
+
+    n->refs   = 1;
+    n->frozen = false;
+
+    *dict = n;
+    return ret_ok;
+}
+
+
+/** Get a new reference to a Header Dictionary
+ *
+ * @param[in,out] dict  Dictionary to reference.
+ *
+ * @return Result of the operation.
+ * @retval ret_ok  Currently this is the only possible result.
+ */
+ret_t
+hpack_header_dict_ref (hpack_header_dict_t *dict)
+{
+    __sync_add_and_fetch (&dict->refs, 1);
+    return ret_ok;
+}
+
+
+/** Release a reference to a Header Dictionary
+ *
+ * The Dictionary is freed when its last reference is released. The pointer is
+ * set to NULL.
+ *
+ * @param[in,out] dict  Reference to the pointer of the Dictionary.
+ *
+ * @return Result of the operation.
+ * @retval ret_ok  Currently this is the only possible result.
+ */
+ret_t
+hpack_header_dict_unref (hpack_header_dict_t **dict)
+{
+    if (*dict == NULL)
+        return ret_ok;
+
+    if (__sync_sub_and_fetch (&(*dict)->refs, 1) == 0) {
+        hpack_header_table_mrproper (&(*dict)->table);
+        free (*dict);
+    }
+
+    *dict = NULL;
+    return ret_ok;
+}
+
+
+/** Add an entry to a Header Dictionary
+ *
+ * Entries are added as they would be added to a Header Table, so the last one
+ * added will be the first one (HPACK index 1). Unlike a Header Table, adding an
+ * entry never evicts older ones.
+ *
+ * @param[in,out] dict   Dictionary to add the entry to.
+ * @param[in]     field  Header Field to add.
+ *
+ * @return Result of the operation.
+ * @retval ret_deny  The dictionary is frozen, or the entry does not fit.
+ * @retval ret_ok    The entry has been added.
+ */
+ret_t
+hpack_header_dict_add (hpack_header_dict_t  *dict,
+                       hpack_header_field_t *field)
+{
+    uint64_t    size;
+    hpack_set_t evicted_set;
+
+    if (dict->frozen)
+        return ret_deny;
+
+    hpack_header_field_get_size (field, &size);
+
+    if ((size + dict->table.used_data > dict->table.max_data) ||
+        (dict->table.num_headers + 1 >= HPACK_MAX_HEADER_TABLE_ENTRIES))
+        return ret_deny;
+
+    return hpack_header_table_add (&dict->table, field, evicted_set);
+}
+
+
+/** Make a Header Dictionary immutable
+ *
+ * It is done automatically when the Dictionary is attached to a Header Table.
+ *
+ * @param[in,out] dict  Dictionary to freeze.
+ *
+ * @return Result of the operation.
+ * @retval ret_ok  Currently this is the only possible result.
+ */
+ret_t
+hpack_header_dict_freeze (hpack_header_dict_t *dict)
+{
+    dict->frozen = true;
+    return ret_ok;
+}
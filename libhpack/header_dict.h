@@ -0,0 +1,83 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file      header_dict.h
+ * @brief     Shared read-only Header Dictionary.
+ *
+ * A Header Dictionary is a pre-populated Header Table that many [Header
+ * Tables](@ref hpack_header_table_t) can start from. It is meant for
+ * deployments where both peers are under our control and can agree on the
+ * same dictionary: the first Header Block of every connection can then use
+ * Indexed Representations for the popular entries right away.
+ *
+ * Dictionaries are reference counted and become immutable once they are
+ * attached to a table for the first time. Tables read from the dictionary until
+ * they need to modify their content, and only then they make a private copy of
+ * it (copy-on-write).
+ *
+ * Attaching and releasing dictionaries is thread safe. Populating them is not,
+ * so it must be finished before the dictionary is shared.
+ *
+ * @date      October, 2026
+ */
+
+#ifndef LIBHPACK_HEADER_DICT_H
+#define LIBHPACK_HEADER_DICT_H
+
+#if !defined(HPACK_H_INSIDE) && !defined (HPACK_COMPILATION)
+# error "Only <libhpack/libhpack.h> can be included directly."
+#endif
+
+#include <libchula/libchula.h>
+#include <libhpack/header_field.h>
+#include <libhpack/header_table.h>
+
+/**
+ * Header Dictionary Structure.
+ */
+struct hpack_header_dict {
+    hpack_header_table_t table;   /**< Entries of the dictionary. */
+    int                  refs;    /**< Reference counter. */
+    bool                 frozen;  /**< No more entries can be added. */
+};
+
+ret_t hpack_header_dict_new   (hpack_header_dict_t **dict);
+ret_t hpack_header_dict_ref   (hpack_header_dict_t  *dict);
+ret_t hpack_header_dict_unref (hpack_header_dict_t **dict);
+
+ret_t hpack_header_dict_add   (hpack_header_dict_t  *dict,
+                               hpack_header_field_t *field);
+
+ret_t hpack_header_dict_freeze (hpack_header_dict_t *dict);
+
+#endif /* LIBHPACK_HEADER_DICT_H */
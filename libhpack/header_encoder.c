@@ -34,6 +34,7 @@
 #include "header_field.h"
 #include "integer.h"
 #include "huffman.h"
+#include "probes-internal.h"
 
 ret_t
 hpack_header_encoder_init (hpack_header_encoder_t *enc)
@@ -42,6 +43,29 @@ hpack_header_encoder_init (hpack_header_encoder_t *enc)
 
     chula_buffer_init_RET (&enc->tmp);
     chula_buffer_ensure_size_RET (&enc->tmp, 32);
+    chula_buffer_init_RET (&enc->pending);
+    chula_buffer_init_RET (&enc->order);
+
+    enc->stats        = NULL;
+    enc->next         = NULL;
+    enc->pending_off  = 0;
+    enc->policy       = hpack_header_encoder_policy_always;
+    enc->policy_data  = NULL;
+    enc->sensitive    = NULL;
+    enc->resize       = false;
+    enc->resize_to    = 0;
+    enc->reorder      = false;
+    enc->differential = false;
+    enc->num_kept     = 0;
+    enc->first_kept   = 0;
+    enc->rendered     = 0;
+
+    memset (enc->seen, 0, sizeof(enc->seen));
+    hpack_header_table_set_init (enc->reference_set, false);
+    hpack_header_table_set_init (enc->kept, false);
+
+    ret = hpack_header_table_init (&enc->table);
+    if (ret != ret_ok) return ret;
 
     ret = hpack_header_store_init (&enc->store);
     if (ret != ret_ok) return ret;
@@ -57,204 +81,1616 @@ hpack_header_encoder_mrproper (hpack_header_encoder_t *enc)
     ret = hpack_header_store_mrproper (&enc->store);
     if (ret != ret_ok) return ret;
 
+    ret = hpack_header_table_mrproper (&enc->table);
+    if (ret != ret_ok) return ret;
+
     chula_buffer_mrproper_RET (&enc->tmp);
+    chula_buffer_mrproper_RET (&enc->pending);
+    chula_buffer_mrproper_RET (&enc->order);
 
     return ret_ok;
 }
 
 ret_t
-hpack_header_encoder_add (hpack_header_encoder_t *enc,
-                          chula_buffer_t         *name,
-                          chula_buffer_t         *value)
+hpack_header_encoder_clean (hpack_header_encoder_t *enc)
 {
-    ret_t                 ret;
-    hpack_header_field_t *field = HPACK_NEW_OBJ(header_field);
+    ret_t ret;
 
-    /* Build new header field */
-    chula_buffer_add_buffer_RET (&field->name, name);
-    chula_buffer_add_buffer_RET (&field->value, value);
+    /* Drop the fields of the last Header Block, keeping their memory */
+    ret = hpack_header_store_clean (&enc->store);
+    if (ret != ret_ok) return ret;
 
-    /* Add the field */
-    ret = hpack_header_encoder_add_field (enc, field);
-    if (unlikely (ret != ret_ok)) return ret;
+    /* And any bounded rendering of it */
+    chula_buffer_clean (&enc->pending);
+    enc->next        = NULL;
+    enc->pending_off = 0;
 
     return ret_ok;
 }
 
+ret_t
+hpack_header_encoder_set_stats (hpack_header_encoder_t *enc,
+                                hpack_stats_t          *stats)
+{
+    enc->stats = stats;
+    return ret_ok;
+}
+
+ret_t
+hpack_header_encoder_set_policy (hpack_header_encoder_t        *enc,
+                                 hpack_header_encoder_policy_t  policy,
+                                 void                          *data)
+{
+    if (unlikely (policy == NULL))
+        return ret_error;
+
+    enc->policy      = policy;
+    enc->policy_data = data;
 
+    return ret_ok;
+}
+
+/* The set is not copied, it must outlive the encoder */
 ret_t
-hpack_header_encoder_add_field (hpack_header_encoder_t *enc,
-                                hpack_header_field_t   *field)
+hpack_header_encoder_set_sensitive (hpack_header_encoder_t *enc,
+                                    hpack_sensitive_t      *sensitive)
 {
-    return hpack_header_store_emit (&enc->store, field);
+    enc->sensitive = sensitive;
+    return ret_ok;
 }
 
-static ret_t
-add_string (hpack_header_encoder_t *enc,
-            chula_buffer_t         *in,
-            bool                    huffman,
-            chula_buffer_t         *output)
+/** Reorder the fields of each Header Block
+ *
+ * Fields fully found in the Header Table are rendered first, before new
+ * entries can evict them or push their indexes up, and fields sharing a name
+ * are rendered next to each other. Pseudo-header fields stay in front, and
+ * fields with the same name keep their relative order.
+ *
+ * @param[in,out] enc      Encoder.
+ * @param[in]     reorder  Whether fields are reordered.
+ *
+ * @return Result of the operation.
+ */
+ret_t
+hpack_header_encoder_set_reorder (hpack_header_encoder_t *enc,
+                                  bool                    reorder)
+{
+    enc->reorder = reorder;
+    return ret_ok;
+}
+
+/** Render only what changed since the previous Header Block
+ *
+ * The decoder emits the fields left in its Reference Set at the end of each
+ * Header Block. Fields whose entry is still referenced from the previous one
+ * are therefore not rendered again: only the new fields are, after removing
+ * the references that are no longer needed with Indexed Representations, or
+ * with a Reference Set Emptying when that is shorter.
+ *
+ * Fields kept this way are emitted last, so the relative order of fields with
+ * different names is not preserved. The store is relinked in the order the
+ * decoder will emit the fields. Pseudo-header fields, fields sharing a name
+ * and sensitive fields are always rendered.
+ *
+ * @param[in,out] enc           Encoder.
+ * @param[in]     differential  Whether only the changes are rendered.
+ *
+ * @return Result of the operation.
+ */
+ret_t
+hpack_header_encoder_set_differential (hpack_header_encoder_t *enc,
+                                       bool                    differential)
+{
+    enc->differential = differential;
+    return ret_ok;
+}
+
+/** Schedule a Maximum Header Table Size change
+ *
+ * The Header Table is resized, and the change emitted, at the start of the
+ * next Header Block. Only the last size scheduled before it counts.
+ *
+ * @param[in,out] enc   Encoder.
+ * @param[in]     size  New Maximum Header Table Size.
+ *
+ * @return Result of the operation.
+ * @retval ret_error  The size is greater than SETTINGS_HEADER_TABLE_SIZE.
+ * @retval ret_ok     The change is scheduled.
+ */
+ret_t
+hpack_header_encoder_set_table_size (hpack_header_encoder_t *enc,
+                                     uint16_t                size)
+{
+    if (unlikely (size > SETTINGS_HEADER_TABLE_SIZE))
+        return ret_error;
+
+    enc->resize    = true;
+    enc->resize_to = size;
+
+    return ret_ok;
+}
+
+/** Serialize the encoding context of a Header Encoder
+ *
+ * Appends the encoding context of @a enc to @a out, so it can be restored by
+ * [hpack_header_encoder_restore](@ref hpack_header_encoder_restore), for
+ * instance to move a connection to a different process along with its
+ * [decoding context](@ref hpack_header_parser_snapshot). It uses the same
+ * format, with bit 1 of the flags set:
+ *
+ @verbatim
+   +------------------+-------------+-----------+
+   | Magic "HPCK" (32)| Version (8) | Flags (8) |
+   +------------------+-------------+-----------+
+   | Header Table (see hpack_header_table_snapshot)  |
+   +-------------------+------------------------------+
+   | Num. refs (8)     | HPACK Index (8) x Num. refs  |  Reference Set
+   +-------------------+------------------------------+
+   | Size (16)         |  Scheduled Maximum Header Table Size, if flag bit 2 is set
+   +-------------------+
+ @endverbatim
+ *
+ * The fields added for the next Header Block, the configuration of the
+ * encoder and the counts of the indexing policies are not part of it.
+ *
+ * @param[in]  enc  Encoder to serialize.
+ * @param[out] out  Buffer to append the snapshot to.
+ *
+ * @return Result of the operation.
+ * @retval ret_eagain  A bounded rendering is in progress: the snapshot has to
+ *                     be taken between Header Blocks.
+ * @retval ret_nomem   Not enough memory to grow @a out.
+ * @retval ret_ok      The snapshot was appended.
+ */
+ret_t
+hpack_header_encoder_snapshot (hpack_header_encoder_t *enc,
+                               chula_buffer_t         *out)
 {
     ret_t   ret;
-    uint8_t mem_len = 16;
-    uint8_t mem[16] = {[0 ... 15] =  0};
+    uint8_t flags = HPACK_SNAPSHOT_ENCODER;
 
-    chula_buffer_clean (&enc->tmp);
+    if (unlikely ((enc->next != NULL) || (enc->pending.len > 0)))
+        return ret_eagain;
 
-    if (huffman) {
-        /* Encode */
-        ret = hpack_huffman_encode (in, &enc->tmp);
-        if (unlikely (ret != ret_ok)) return ret;
+    if (enc->resize) {
+        flags |= HPACK_SNAPSHOT_RESIZE;
+    }
 
-        /* Length */
-        mem[0] = 1 << 7;
-        ret = hpack_integer_encode (7, enc->tmp.len, mem, &mem_len);
-        if (unlikely (ret != ret_ok)) return ret;
+    chula_buffer_add      (out, HPACK_SNAPSHOT_MAGIC, HPACK_SNAPSHOT_MAGIC_LEN);
+    chula_buffer_add_char (out, HPACK_SNAPSHOT_VERSION);
+    chula_buffer_add_char (out, flags);
 
-        /* Compose */
-        chula_buffer_add_RET (output, (const char *)mem, mem_len);
-        chula_buffer_add_buffer_RET (output, &enc->tmp);
+    ret = hpack_header_table_snapshot (&enc->table, out);
+    if (unlikely (ret != ret_ok)) return ret;
 
-        return ret_ok;
+    ret = hpack_header_table_snapshot_set (&enc->table, enc->reference_set, out);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    if (enc->resize) {
+        ret = chula_buffer_add_uint16be (out, enc->resize_to);
+        if (unlikely (ret != ret_ok)) return ret;
     }
 
-    /* Length */
-    ret = hpack_integer_encode (7, in->len, mem, &mem_len);
+    return ret_ok;
+}
+
+/** Restore the encoding context of a Header Encoder
+ *
+ * Replaces the encoding context of @a enc with the one serialized by
+ * [hpack_header_encoder_snapshot](@ref hpack_header_encoder_snapshot). Any
+ * bounded rendering in progress is dropped. The fields added to the encoder
+ * and its configuration are kept.
+ *
+ * @param[in,out] enc       Encoder to restore.
+ * @param[in]     buf       Buffer with the snapshot.
+ * @param[in]     offset    Offset of the snapshot in @a buf.
+ * @param[out]    consumed  How many octets were consumed.
+ *
+ * @return Result of the operation.
+ * @retval ret_deny   The snapshot is from an unsupported version.
+ * @retval ret_error  The snapshot is truncated, corrupted or of a parser.
+ * @retval ret_ok     The encoding context was restored.
+ */
+ret_t
+hpack_header_encoder_restore (hpack_header_encoder_t *enc,
+                              chula_buffer_t         *buf,
+                              unsigned int            offset,
+                              unsigned int           *consumed)
+{
+    ret_t        ret;
+    uint8_t      version;
+    uint8_t      flags;
+    unsigned int con = 0;
+    unsigned int n   = offset;
+
+    *consumed = 0;
+
+    if (unlikely ((buf->len < offset + HPACK_SNAPSHOT_MAGIC_LEN + 2) ||
+                  (memcmp (buf->buf + n, HPACK_SNAPSHOT_MAGIC, HPACK_SNAPSHOT_MAGIC_LEN) != 0)))
+        return ret_error;
+    n += HPACK_SNAPSHOT_MAGIC_LEN;
+
+    version = buf->buf[n++];
+    if (unlikely ((version < 1) || (version > HPACK_SNAPSHOT_VERSION)))
+        return ret_deny;
+
+    flags = buf->buf[n++];
+    if (unlikely (! (flags & HPACK_SNAPSHOT_ENCODER)))
+        return ret_error;
+
+    /* Nothing of a rendering in progress is left */
+    chula_buffer_clean (&enc->pending);
+    enc->next        = NULL;
+    enc->pending_off = 0;
+    enc->num_kept    = 0;
+    enc->first_kept  = 0;
+    enc->rendered    = 0;
+    hpack_header_table_set_clear (enc->kept);
+
+    ret = hpack_header_table_restore (&enc->table, buf, n, &con);
     if (unlikely (ret != ret_ok)) return ret;
+    n += con;
 
-    /* Compose */
-    chula_buffer_add_RET (output, (const char *)mem, mem_len);
-    chula_buffer_add_buffer_RET (output, in);
+    ret = hpack_header_table_restore_set (&enc->table, enc->reference_set, buf, &n);
+    if (unlikely (ret != ret_ok)) return ret_error;
+
+    enc->resize    = false;
+    enc->resize_to = 0;
+
+    if (flags & HPACK_SNAPSHOT_RESIZE) {
+        if (unlikely (buf->len - n < 2))
+            return ret_error;
+
+        enc->resize    = true;
+        enc->resize_to = (buf->buf[n] << 8) | buf->buf[n+1];
+        n += 2;
+
+        if (unlikely (enc->resize_to > SETTINGS_HEADER_TABLE_SIZE))
+            return ret_error;
+    }
 
+    *consumed = n - offset;
     return ret_ok;
 }
 
-static ret_t
-render_indexed (hpack_header_encoder_t *enc,
-                hpack_header_field_t   *field,
-                chula_buffer_t         *output)
+static uint16_t *
+seen_slot (hpack_header_encoder_t *enc,
+           const chula_buffer_t   *name)
 {
-    /* Indexed Header Field
-     *     0   1   2   3   4   5   6   7
-     *   +---+---+---+---+---+---+---+---+
-     *   | 1 |        Index (7+)         |
-     *   +---+---------------------------+
+    uint32_t hash = 2166136261u;
+
+    /* FNV-1a */
+    for (uint32_t i = 0; i < name->len; i++) {
+        hash = (hash ^ name->buf[i]) * 16777619u;
+    }
+
+    return &enc->seen[hash & (HPACK_ENCODER_SEEN_SLOTS - 1)];
+}
+
+/* Approximate: names sharing a slot add up */
+uint32_t
+hpack_header_encoder_seen (hpack_header_encoder_t *enc,
+                           const chula_buffer_t   *name)
+{
+    return *seen_slot (enc, name);
+}
+
+bool
+hpack_header_encoder_policy_always (hpack_header_encoder_t *enc,
+                                    hpack_header_field_t   *field,
+                                    void                   *data)
+{
+    UNUSED(enc);
+    UNUSED(field);
+    UNUSED(data);
+
+    return true;
+}
+
+bool
+hpack_header_encoder_policy_never (hpack_header_encoder_t *enc,
+                                   hpack_header_field_t   *field,
+                                   void                   *data)
+{
+    UNUSED(enc);
+    UNUSED(field);
+    UNUSED(data);
+
+    return false;
+}
+
+/* data points to a uint32_t with the longest value to index */
+bool
+hpack_header_encoder_policy_max_value (hpack_header_encoder_t *enc,
+                                       hpack_header_field_t   *field,
+                                       void                   *data)
+{
+    UNUSED(enc);
+
+    return field->value.len <= *(const uint32_t *) data;
+}
+
+/* data points to a uint32_t with the times a name has to be rendered,
+ * including this one, before it is indexed.
+ */
+bool
+hpack_header_encoder_policy_min_seen (hpack_header_encoder_t *enc,
+                                      hpack_header_field_t   *field,
+                                      void                   *data)
+{
+    return hpack_header_encoder_seen (enc, &field->name) >= *(const uint32_t *) data;
+}
+
+/* Indexes a field when the octets it would have saved so far, had it been
+ * indexed on its first appearance, make up for the octets of the entries it
+ * evicts. Fields that fit in the free space of the Header Table are always
+ * indexed.
+ */
+bool
+hpack_header_encoder_policy_cost (hpack_header_encoder_t *enc,
+                                  hpack_header_field_t   *field,
+                                  void                   *data)
+{
+    uint64_t size;
+    uint64_t free_len;
+    uint64_t saved;
+    uint32_t seen;
+
+    UNUSED(data);
+
+    hpack_header_field_get_size (field, &size);
+
+    if (size > enc->table.max_data)
+        return false;
+
+    free_len = enc->table.max_data - enc->table.used_data;
+    if (size <= free_len)
+        return true;
+
+    seen  = hpack_header_encoder_seen (enc, &field->name);
+    saved = (uint64_t) (field->name.len + field->value.len) * ((seen > 0) ? seen - 1 : 0);
+
+    return saved >= size - free_len;
+}
+
+static void
+stats_field (hpack_header_encoder_t              *enc,
+             hpack_header_field_t                *field,
+             hpack_header_field_representation_t  rep,
+             uint32_t                             wire_len)
+{
+    if (enc->stats == NULL)
+        return;
+
+    enc->stats->reps[rep]   += 1;
+    enc->stats->fields      += 1;
+    enc->stats->wire_len    += wire_len;
+    enc->stats->decoded_len += field->name.len + field->value.len;
+}
+
+ret_t
+hpack_header_encoder_add (hpack_header_encoder_t *enc,
+                          chula_buffer_t         *name,
+                          chula_buffer_t         *value)
+{
+    ret_t                ret;
+    hpack_header_field_t field;
+
+    /* The store copies the field, into the buffers of a previous one when
+     * the encoder has been cleaned.
      */
+    hpack_header_field_init (&field);
+    hpack_header_field_borrow (&field, name, value);
 
+    ret = hpack_header_encoder_add_field (enc, &field);
 
-    return ret_ok;
+    hpack_header_field_mrproper (&field);
+    return ret;
 }
 
-static ret_t
-render_indexed_value (hpack_header_encoder_t *enc,
-                      hpack_header_field_t   *field,
-                      bool                    huffman,
-                      bool                    indexing,
-                      chula_buffer_t         *output)
+/* Takes name and value over instead of copying them. See
+ * hpack_header_store_adopt().
+ */
+ret_t
+hpack_header_encoder_adopt (hpack_header_encoder_t *enc,
+                            chula_buffer_t         *name,
+                            chula_buffer_t         *value)
 {
-    ret_t ret;
+    return hpack_header_store_adopt (&enc->store, name, value);
+}
 
-    /* Literal Header Field never Indexed - Indexed Name
-     *
-     *     0   1   2   3   4   5   6   7
-     *   +---+---+---+---+---+---+---+---+
-     *   | 0 | 0 | 0 | 1 |  Index (4+)   |
-     *   +---+---+-----------------------+
-     *   | H |     Value Length (7+)     |
-     *   +---+---------------------------+
-     *   | Value String (Length octets)  |
-     *   +-------------------------------+
-     *
-     * Literal Header Field without Indexing - Indexed Name
-     *
-     *     0   1   2   3   4   5   6   7
-     *   +---+---+---+---+---+---+---+---+
-     *   | 0 | 0 | 0 | 0 |  Index (4+)   |
-     *   +---+---+-----------------------+
-     *   | H |     Value Length (7+)     |
-     *   +---+---------------------------+
-     *   | Value String (Length octets)  |
-     *   +-------------------------------+
+
+ret_t
+hpack_header_encoder_add_field (hpack_header_encoder_t *enc,
+                                hpack_header_field_t   *field)
+{
+    /* The store of the encoder keeps the default emission */
+    return hpack_header_store_add (&enc->store, field);
+}
+
+ret_t
+hpack_header_encoder_add_ref (hpack_header_encoder_t *enc,
+                              const chula_buffer_t   *name,
+                              const chula_buffer_t   *value)
+{
+    /* Name and value must outlive the rendering. The value is referenced
+     * by hpack_header_encoder_render_iov() instead of copied.
      */
-    if (indexing) {
-        chula_buffer_add_char_RET (output, (char)1<<3);
-    } else {
-        chula_buffer_add_char_RET (output, (char)0);
-    }
+    return hpack_header_store_add_borrowed (&enc->store, name, value);
+}
 
-    ret = add_string (enc, &field->value, huffman, output);
-    if (unlikely (ret != ret_ok)) return ret;
+ret_t
+hpack_header_encoder_iov_init (hpack_header_encoder_iov_t *iov)
+{
+    iov->iov   = NULL;
+    iov->len   = 0;
+    iov->size  = 0;
+    iov->total = 0;
+    iov->mark  = 0;
 
-    return ret_ok;
+    return chula_buffer_init (&iov->arena);
+}
+
+ret_t
+hpack_header_encoder_iov_mrproper (hpack_header_encoder_iov_t *iov)
+{
+    free (iov->iov);
+
+    iov->iov  = NULL;
+    iov->size = 0;
+
+    hpack_header_encoder_iov_clean (iov);
+    return chula_buffer_mrproper (&iov->arena);
 }
 
+ret_t
+hpack_header_encoder_iov_clean (hpack_header_encoder_iov_t *iov)
+{
+    iov->len   = 0;
+    iov->total = 0;
+    iov->mark  = 0;
+
+    chula_buffer_clean (&iov->arena);
+    return ret_ok;
+}
 
 static ret_t
-render_literal (hpack_header_encoder_t *enc,
-                hpack_header_field_t   *field,
-                bool                    huffman,
-                bool                    indexing,
-                chula_buffer_t         *output)
+iov_push (hpack_header_encoder_iov_t *iov,
+          void                       *base,
+          size_t                      len)
 {
-    ret_t ret;
+    unsigned int  size;
+    struct iovec *tmp;
 
-    /* Literal Header Field without Indexing - New Name
-     *
-     *     0   1   2   3   4   5   6   7
-     *   +---+---+---+---+---+---+---+---+
-     *   | 0 | 0 | 0 | 0 |       0       |
-     *   +---+---+-----------------------+
-     *   | H |     Name Length (7+)      |
-     *   +---+---------------------------+
-     *   |  Name String (Length octets)  |
-     *   +---+---------------------------+
-     *   | H |     Value Length (7+)     |
-     *   +---+---------------------------+
-     *   | Value String (Length octets)  |
-     *   +-------------------------------+
-     *
-     * Literal Header Field with Incremental Indexing - New Name
-     *
-     *     0   1   2   3   4   5   6   7
-     *   +---+---+---+---+---+---+---+---+
-     *   | 0 | 1 |           0           |
-     *   +---+---+-----------------------+
-     *   | H |     Name Length (7+)      |
-     *   +---+---------------------------+
-     *   |  Name String (Length octets)  |
-     *   +---+---------------------------+
-     *   | H |     Value Length (7+)     |
-     *   +---+---------------------------+
-     *   | Value String (Length octets)  |
-     *   +-------------------------------+
-     */
-    if (indexing) {
-        chula_buffer_add_char_RET (output, (char)1<<7);
-    } else {
-        chula_buffer_add_char_RET (output, (char)0);
+    if (len == 0)
+        return ret_ok;
+
+    if (iov->len == iov->size) {
+        size = (iov->size > 0) ? iov->size * 2 : 16;
+
+        tmp = (struct iovec *) realloc (iov->iov, size * sizeof(struct iovec));
+        if (unlikely (tmp == NULL)) return ret_nomem;
+
+        iov->iov  = tmp;
+        iov->size = size;
     }
 
-    /* Name */
-    ret = add_string (enc, &field->name, huffman, output);
-    if (unlikely (ret != ret_ok)) return ret;
+    iov->iov[iov->len].iov_base = base;
+    iov->iov[iov->len].iov_len  = len;
 
-    ret = add_string (enc, &field->value, huffman, output);
-    if (unlikely (ret != ret_ok)) return ret;
+    iov->len   += 1;
+    iov->total += len;
 
     return ret_ok;
 }
 
-ret_t
-hpack_header_encoder_render (hpack_header_encoder_t *enc,
-                             chula_buffer_t         *output)
+/* Pieces of the arena have no base while rendering, because the arena moves
+ * as it grows. iov_point() sets them once it is done.
+ */
+static ret_t
+iov_push_arena (hpack_header_encoder_iov_t *iov)
 {
-    ret_t                       ret;
-    hpack_header_store_entry_t *i;
+    ret_t ret;
+
+    ret = iov_push (iov, NULL, iov->arena.len - iov->mark);
+    iov->mark = iov->arena.len;
+
+    return ret;
+}
+
+static void
+iov_point (hpack_header_encoder_iov_t *iov,
+           bool                        point)
+{
+    uint8_t *p = iov->arena.buf;
+
+    for (unsigned int n = 0; n < iov->len; n++) {
+        struct iovec *v = &iov->iov[n];
+
+        if (point) {
+            if (v->iov_base != NULL)
+                continue;
+            v->iov_base = p;
+            p += v->iov_len;
+
+        } else if (((uint8_t *) v->iov_base >= iov->arena.buf) &&
+                   ((uint8_t *) v->iov_base <  iov->arena.buf + iov->arena.len)) {
+            v->iov_base = NULL;
+        }
+    }
+}
+
+/* Where a rendering goes: a buffer or a set of frame payloads */
+typedef struct {
+    chula_buffer_t                *buf;
+    hpack_header_encoder_frames_t *frames;
+    uint32_t                       len;     /* Octets of the Header Block rendered */
+} output_t;
+
+static ret_t
+output_add (output_t   *out,
+            const char *data,
+            uint32_t    len)
+{
+    ret_t                          ret;
+    uint32_t                       n;
+    chula_buffer_t                *payload;
+    hpack_header_encoder_frames_t *frames  = out->frames;
+
+    if (frames == NULL) {
+        ret = chula_buffer_add (out->buf, data, len);
+        if (unlikely (ret != ret_ok)) return ret;
+
+        out->len += len;
+        return ret_ok;
+    }
+
+    /* Spill into the next payload, even in the middle of a field */
+    while (len > 0) {
+        if ((frames->used == 0) ||
+            (frames->payloads[frames->used - 1].len >= frames->max_len))
+        {
+            if (unlikely (frames->used == frames->num))
+                return ret_deny;
+
+            frames->used += 1;
+            continue;
+        }
+
+        payload = &frames->payloads[frames->used - 1];
+        n       = MIN (len, frames->max_len - payload->len);
+
+        ret = chula_buffer_add (payload, data, n);
+        if (unlikely (ret != ret_ok)) return ret;
+
+        data     += n;
+        len      -= n;
+        out->len += n;
+    }
+
+    return ret_ok;
+}
+
+static ret_t
+output_add_char (output_t *out,
+                 char      c)
+{
+    return output_add (out, &c, 1);
+}
+
+static ret_t
+add_string (hpack_header_encoder_t     *enc,
+            chula_buffer_t             *in,
+            bool                        huffman,
+            output_t                   *output,
+            hpack_header_encoder_iov_t *ref)
+{
+    ret_t   ret;
+    uint8_t mem_len = 16;
+    uint8_t mem[16] = {[0 ... 15] =  0};
+
+    chula_buffer_clean (&enc->tmp);
+
+    /* Referenced strings go raw, straight from the caller's memory */
+    if (ref != NULL) {
+        huffman = false;
+    }
+
+    if (enc->stats != NULL) {
+        if (huffman) {
+            enc->stats->strings_huffman += 1;
+        } else {
+            enc->stats->strings_raw += 1;
+        }
+    }
+
+    if (huffman) {
+        /* Encode */
+        ret = hpack_huffman_encode (in, &enc->tmp);
+        if (unlikely (ret != ret_ok)) return ret;
+
+        /* Length */
+        mem[0] = 1 << 7;
+        ret = hpack_integer_encode (7, enc->tmp.len, mem, &mem_len);
+        if (unlikely (ret != ret_ok)) return ret;
+
+        /* Compose */
+        ret = output_add (output, (const char *)mem, mem_len);
+        if (unlikely (ret != ret_ok)) return ret;
+
+        return output_add (output, (const char *)enc->tmp.buf, enc->tmp.len);
+    }
+
+    /* Length */
+    ret = hpack_integer_encode (7, in->len, mem, &mem_len);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    /* Compose */
+    ret = output_add (output, (const char *)mem, mem_len);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    if (ref != NULL) {
+        ret = iov_push_arena (ref);
+        if (unlikely (ret != ret_ok)) return ret;
+
+        ret = iov_push (ref, in->buf, in->len);
+        if (unlikely (ret != ret_ok)) return ret;
+
+        /* Part of the Header Block, although not in the buffer */
+        output->len += in->len;
+        return ret_ok;
+    }
+
+    return output_add (output, (const char *)in->buf, in->len);
+}
+
+/* Adds a rendered field to the Header Table, as the decoder does */
+static ret_t
+table_add (hpack_header_encoder_t *enc,
+           hpack_header_field_t   *field)
+{
+    ret_t       ret;
+    hpack_set_t evicted_set;
+
+    ret = hpack_header_table_add (&enc->table, field, evicted_set);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    /* Evicted entries leave the Reference Set */
+    hpack_header_table_set_relative_comp (enc->reference_set, evicted_set);
+
+    /* The new entry is referenced, unless it did not fit */
+    if (! hpack_header_table_set_is_full (evicted_set)) {
+        hpack_header_table_set_add (&enc->table, enc->reference_set, 1);
+    }
+
+    return ret_ok;
+}
+
+static ret_t
+add_index (uint8_t   first,
+           int       prefix,
+           uint16_t  idx,
+           output_t *output)
+{
+    ret_t   ret;
+    uint8_t mem_len = 16;
+    uint8_t mem[16] = {[0 ... 15] =  0};
+
+    mem[0] = first;
+    ret = hpack_integer_encode (prefix, idx, mem, &mem_len);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    return output_add (output, (const char *)mem, mem_len);
+}
+
+static ret_t
+render_indexed (hpack_header_encoder_t *enc,
+                hpack_header_field_t   *field,
+                uint16_t                idx,
+                output_t               *output)
+{
+    ret_t    ret;
+    uint32_t start = output->len;
+
+    /* Indexed Header Field
+     *     0   1   2   3   4   5   6   7
+     *   +---+---+---+---+---+---+---+---+
+     *   | 1 |        Index (7+)         |
+     *   +---+---------------------------+
+     */
+    ret = add_index (0x80, 7, idx, output);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    stats_field (enc, field, rep_indexed, output->len - start);
+
+    /* Static Table entries are copied into the Header Table */
+    if (idx > enc->table.num_headers)
+        return table_add (enc, field);
+
+    hpack_header_table_set_add (&enc->table, enc->reference_set, idx);
+    return ret_ok;
+}
+
+static ret_t
+render_indexed_name (hpack_header_encoder_t              *enc,
+                     hpack_header_field_t                *field,
+                     uint16_t                             idx,
+                     bool                                 huffman,
+                     hpack_header_field_representation_t  rep,
+                     output_t                            *output,
+                     hpack_header_encoder_iov_t          *ref)
+{
+    ret_t    ret;
+    uint32_t start = output->len;
+
+    /* Literal Header Field without Indexing - Indexed Name
+     *
+     *     0   1   2   3   4   5   6   7
+     *   +---+---+---+---+---+---+---+---+
+     *   | 0 | 0 | 0 | 0 |  Index (4+)   |
+     *   +---+---+-----------------------+
+     *   | H |     Value Length (7+)     |
+     *   +---+---------------------------+
+     *   | Value String (Length octets)  |
+     *   +-------------------------------+
+     *
+     * Literal Header Field never Indexed - Indexed Name
+     *
+     *     0   1   2   3   4   5   6   7
+     *   +---+---+---+---+---+---+---+---+
+     *   | 0 | 0 | 0 | 1 |  Index (4+)   |
+     *   +---+---+-----------------------+
+     *   | H |     Value Length (7+)     |
+     *   +---+---------------------------+
+     *   | Value String (Length octets)  |
+     *   +-------------------------------+
+     *
+     * Literal Header Field with Incremental Indexing - Indexed Name
+     *
+     *     0   1   2   3   4   5   6   7
+     *   +---+---+---+---+---+---+---+---+
+     *   | 0 | 1 |      Index (6+)       |
+     *   +---+---+-----------------------+
+     *   | H |     Value Length (7+)     |
+     *   +---+---------------------------+
+     *   | Value String (Length octets)  |
+     *   +-------------------------------+
+     */
+    switch (rep) {
+    case rep_inc_indexed:
+        ret = add_index (0x40, 6, idx, output);
+        break;
+    case rep_never_indx:
+        ret = add_index (0x10, 4, idx, output);
+        break;
+    default:
+        ret = add_index (0x00, 4, idx, output);
+    }
+    if (unlikely (ret != ret_ok)) return ret;
+
+    /* Value, which may be referenced rather than copied */
+    ret = add_string (enc, &field->value, huffman, output, ref);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    stats_field (enc, field, rep, output->len - start);
+    return ret_ok;
+}
+
+
+static ret_t
+render_literal (hpack_header_encoder_t              *enc,
+                hpack_header_field_t                *field,
+                bool                                 huffman,
+                hpack_header_field_representation_t  rep,
+                output_t                            *output,
+                hpack_header_encoder_iov_t          *ref)
+{
+    ret_t    ret;
+    uint32_t start = output->len;
+
+    /* Literal Header Field without Indexing - New Name
+     *
+     *     0   1   2   3   4   5   6   7
+     *   +---+---+---+---+---+---+---+---+
+     *   | 0 | 0 | 0 | 0 |       0       |
+     *   +---+---+-----------------------+
+     *   | H |     Name Length (7+)      |
+     *   +---+---------------------------+
+     *   |  Name String (Length octets)  |
+     *   +---+---------------------------+
+     *   | H |     Value Length (7+)     |
+     *   +---+---------------------------+
+     *   | Value String (Length octets)  |
+     *   +-------------------------------+
+     *
+     * Literal Header Field never Indexed - New Name
+     *
+     *     0   1   2   3   4   5   6   7
+     *   +---+---+---+---+---+---+---+---+
+     *   | 0 | 0 | 0 | 1 |       0       |
+     *   +---+---+-----------------------+
+     *   | H |     Name Length (7+)      |
+     *   +---+---------------------------+
+     *   |  Name String (Length octets)  |
+     *   +---+---------------------------+
+     *   | H |     Value Length (7+)     |
+     *   +---+---------------------------+
+     *   | Value String (Length octets)  |
+     *   +-------------------------------+
+     *
+     * Literal Header Field with Incremental Indexing - New Name
+     *
+     *     0   1   2   3   4   5   6   7
+     *   +---+---+---+---+---+---+---+---+
+     *   | 0 | 1 |           0           |
+     *   +---+---+-----------------------+
+     *   | H |     Name Length (7+)      |
+     *   +---+---------------------------+
+     *   |  Name String (Length octets)  |
+     *   +---+---------------------------+
+     *   | H |     Value Length (7+)     |
+     *   +---+---------------------------+
+     *   | Value String (Length octets)  |
+     *   +-------------------------------+
+     */
+    switch (rep) {
+    case rep_inc_indexed:
+        ret = output_add_char (output, 0x40);
+        break;
+    case rep_never_indx:
+        ret = output_add_char (output, 0x10);
+        break;
+    default:
+        ret = output_add_char (output, 0);
+    }
+    if (unlikely (ret != ret_ok)) return ret;
+
+    /* Name */
+    ret = add_string (enc, &field->name, huffman, output, NULL);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    /* Value, which may be referenced rather than copied */
+    ret = add_string (enc, &field->value, huffman, output, ref);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    stats_field (enc, field, rep, output->len - start);
+    return ret_ok;
+}
+
+/* Field kept in the Reference Set by a differential rendering */
+typedef struct {
+    hpack_header_store_entry_t *entry;
+    uint16_t                    slot;   /* Internal index of its entry */
+} kept_t;
+
+static ret_t
+render_field (hpack_header_encoder_t     *enc,
+              hpack_header_field_t       *field,
+              output_t                   *output,
+              hpack_header_encoder_iov_t *iov)
+{
+    ret_t                                ret;
+    uint16_t                             idx;
+    bool                                 name_only;
+    uint16_t                            *seen;
+    hpack_header_field_representation_t  rep;
+    uint32_t                             n         = enc->rendered++;
+    uint32_t                             evictions = enc->table.evictions;
+
+    /* Fields added with hpack_header_encoder_add_ref() are referenced from
+     * an I/O vector.
+     */
+    hpack_header_encoder_iov_t          *ref       = (field->borrowed) ? iov : NULL;
+
+    seen = seen_slot (enc, &field->name);
+    if (*seen < UINT16_MAX) {
+        *seen += 1;
+    }
+
+    /* Fields kept in the Reference Set are emitted by the decoder */
+    if ((enc->num_kept > 0) && (n >= enc->first_kept)) {
+        if (enc->stats != NULL) {
+            enc->stats->fields      += 1;
+            enc->stats->decoded_len += field->name.len + field->value.len;
+        }
+        return ret_ok;
+    }
+
+    ret = hpack_header_table_find (&enc->table, &field->name, &field->value, &idx, &name_only);
+    if (ret != ret_ok) {
+        idx = 0;
+    }
+
+    if (hpack_sensitive_is (enc->sensitive, &field->name)) {
+        /* Never referenced from the Header Table, whatever the policy */
+        rep = rep_never_indx;
+    }
+    else if ((idx != 0) && (! name_only)) {
+        /* An entry already in the Reference Set was emitted earlier in this
+         * Header Block. Referencing it again would remove it instead.
+         */
+        if (! hpack_header_table_set_exists (&enc->table, enc->reference_set, idx)) {
+            ret = render_indexed (enc, field, idx, output);
+            goto out;
+        }
+
+        rep = rep_wo_indexing;
+    } else {
+        rep = enc->policy (enc, field, enc->policy_data) ? rep_inc_indexed : rep_wo_indexing;
+    }
+
+    if (idx != 0) {
+        ret = render_indexed_name (enc, field, idx, true, rep, output, ref);
+    } else {
+        ret = render_literal (enc, field, true, rep, output, ref);
+    }
+
+    if ((ret == ret_ok) && (rep == rep_inc_indexed)) {
+        ret = table_add (enc, field);
+    }
+
+out:
+    if (enc->stats != NULL) {
+        enc->stats->evictions += enc->table.evictions - evictions;
+    }
+
+    return ret;
+}
+
+static ret_t
+render_resize (hpack_header_encoder_t *enc,
+               output_t               *output)
+{
+    ret_t       ret;
+    hpack_set_t evicted;
+    uint32_t    evictions = enc->table.evictions;
+
+    ret = hpack_header_table_set_max (&enc->table, enc->resize_to, evicted);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    /* Evicted entries can no longer be referenced */
+    hpack_header_table_set_relative_comp (enc->reference_set, evicted);
+
+    enc->resize = false;
+
+    if (enc->stats != NULL) {
+        enc->stats->size_updates += 1;
+        enc->stats->evictions    += enc->table.evictions - evictions;
+    }
+
+    /* Maximum Header Table Size Change
+     *
+     *     0   1   2   3   4   5   6   7
+     *   +---+---+---+---+---+---+---+---+
+     *   | 0 | 0 | 1 | 0 | Max size (4+) |
+     *   +---+---------------------------+
+     */
+    return add_index (0x20, 4, enc->resize_to, output);
+}
+
+/* Reordering classes, in rendering order */
+enum {
+    order_pseudo,   /* Pseudo-header fields */
+    order_indexed,  /* Names with a field fully found in the Header Table */
+    order_other
+};
+
+typedef struct {
+    hpack_header_store_entry_t *entry;
+    uint32_t                    group;  /* First field with the same name */
+    uint8_t                     class;  /* Class of the group, kept by its first field */
+} order_t;
+
+static bool
+same_name (hpack_header_store_entry_t *a,
+           hpack_header_store_entry_t *b)
+{
+    chula_buffer_t *na = &HPACK_HEADER_FIELD(a)->name;
+    chula_buffer_t *nb = &HPACK_HEADER_FIELD(b)->name;
+
+    return ((na->len == nb->len) && (memcmp (na->buf, nb->buf, na->len) == 0));
+}
+
+/* Relinks the fields of the store by class, keeping the fields of a name
+ * together and in the order they were added.
+ */
+static ret_t
+reorder (hpack_header_encoder_t *enc)
+{
+    ret_t                       ret;
+    uint16_t                    idx;
+    bool                        name_only;
+    order_t                    *items;
+    uint32_t                    num   = 0;
+    hpack_header_store_entry_t *i;
+
+    hpack_header_store_foreach (i, &enc->store) {
+        num++;
+    }
+
+    if (num < 2)
+        return ret_ok;
+
+    chula_buffer_clean (&enc->order);
+    ret = chula_buffer_ensure_size (&enc->order, num * sizeof(order_t));
+    if (unlikely (ret != ret_ok)) return ret;
+
+    items = (order_t *) enc->order.buf;
+    num   = 0;
 
     hpack_header_store_foreach (i, &enc->store) {
         hpack_header_field_t *field = HPACK_HEADER_FIELD(i);
+        order_t              *item  = &items[num];
+
+        item->entry = i;
+        item->group = num;
+        item->class = ((field->name.len > 0) && (field->name.buf[0] == ':')) ? order_pseudo : order_other;
+
+        for (uint32_t n=0; n < num; n++) {
+            if ((items[n].group == n) && (same_name (items[n].entry, i))) {
+                item->group = n;
+                break;
+            }
+        }
+
+        if ((item->class == order_other) &&
+            (! hpack_sensitive_is (enc->sensitive, &field->name)))
+        {
+            ret = hpack_header_table_find (&enc->table, &field->name, &field->value, &idx, &name_only);
+            if ((ret == ret_ok) && (! name_only)) {
+                items[item->group].class = order_indexed;
+            }
+        }
+
+        num++;
+    }
+
+    INIT_LIST_HEAD (&enc->store.headers);
+
+    for (uint8_t class = order_pseudo; class <= order_other; class++) {
+        for (uint32_t n=0; n < num; n++) {
+            if ((items[n].group != n) || (items[n].class != class))
+                continue;
+
+            for (uint32_t m=n; m < num; m++) {
+                if (items[m].group == n) {
+                    chula_list_add_tail (&items[m].entry->entry, &enc->store.headers);
+                }
+            }
+        }
+    }
+
+    return ret_ok;
+}
+
+static uint32_t
+index_len (uint16_t idx)
+{
+    uint32_t len = 2;
+
+    if (idx < 0x7F)
+        return 1;
+
+    for (idx -= 0x7F; idx >= 0x80; idx >>= 7) {
+        len++;
+    }
+
+    return len;
+}
+
+static bool
+unique_name (hpack_header_encoder_t     *enc,
+             hpack_header_store_entry_t *entry)
+{
+    hpack_header_store_entry_t *i;
+
+    hpack_header_store_foreach (i, &enc->store) {
+        if ((i != entry) && (same_name (i, entry)))
+            return false;
+    }
+
+    return true;
+}
+
+/* Keeps the fields whose entry is in the Reference Set, moving them to the
+ * end of the store, and removes the other references. Either one at a time,
+ * or all of them with a Reference Set Emptying if that takes fewer octets
+ * than the kept fields cost to render again. Nothing is kept if the other
+ * fields could evict an entry before the decoder gets to emit it.
+ */
+static ret_t
+render_delta (hpack_header_encoder_t *enc,
+              output_t               *output)
+{
+    ret_t                       ret;
+    int                         idx;
+    uint16_t                    found;
+    bool                        name_only;
+    kept_t                     *items;
+    hpack_set_t                 unused;
+    hpack_set_iterator_t        iter;
+    uint32_t                    num         = 0;
+    uint32_t                    num_kept    = 0;
+    uint32_t                    cost_toggle = 0;
+    uint32_t                    cost_empty  = 1;
+    uint32_t                    added       = 0;
+    hpack_header_store_entry_t *i;
+
+    hpack_header_store_foreach (i, &enc->store) {
+        num++;
+    }
+
+    chula_buffer_clean (&enc->order);
+    ret = chula_buffer_ensure_size (&enc->order, num * sizeof(kept_t) + 1);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    items = (kept_t *) enc->order.buf;
+
+    hpack_header_store_foreach (i, &enc->store) {
+        hpack_header_field_t *field = HPACK_HEADER_FIELD(i);
+
+        if (hpack_sensitive_is (enc->sensitive, &field->name))
+            continue;
+
+        added += field->name.len + field->value.len + HPACK_HEADER_ENTRY_OVERHEAD;
+
+        if (((field->name.len > 0) && (field->name.buf[0] == ':')) ||
+            (! unique_name (enc, i)))
+            continue;
+
+        ret = hpack_header_table_find (&enc->table, &field->name, &field->value, &found, &name_only);
+        if ((ret != ret_ok) || (name_only) || (found > enc->table.num_headers) ||
+            (! hpack_header_table_set_exists (&enc->table, enc->reference_set, found)))
+            continue;
+
+        added -= field->name.len + field->value.len + HPACK_HEADER_ENTRY_OVERHEAD;
+
+        items[num_kept].entry = i;
+        items[num_kept].slot  = INDEX_SWITCH_HT_HPACK(&enc->table, found);
+        hpack_set_add (enc->kept, items[num_kept].slot);
+
+        cost_empty += index_len (found);
+        num_kept++;
+    }
+
+    /* References no field is kept for */
+    hpack_header_table_set_set (unused, enc->reference_set);
+    hpack_header_table_set_relative_comp (unused, enc->kept);
+
+    hpack_header_table_iter_init (&iter, unused);
+    while ((idx = hpack_header_table_iter_next (&enc->table, &iter)) != -1) {
+        cost_toggle += index_len (idx);
+    }
+
+    /* The other fields could evict the entries of the kept ones, which
+     * would then have to be rendered anyway.
+     */
+    if ((cost_empty <= cost_toggle) ||
+        (enc->table.used_data + added > enc->table.max_data))
+    {
+        hpack_header_table_set_clear (enc->kept);
+        hpack_header_table_set_clear (enc->reference_set);
+
+        /* Reference Set Emptying */
+        return output_add_char (output, 0x30);
+    }
+
+    /* Indexed Representations of referenced entries remove them */
+    hpack_header_table_iter_init (&iter, unused);
+    while ((idx = hpack_header_table_iter_next (&enc->table, &iter)) != -1) {
+        ret = add_index (0x80, 7, idx, output);
+        if (unlikely (ret != ret_ok)) return ret;
+
+        hpack_header_table_set_remove (&enc->table, enc->reference_set, idx);
+    }
+
+    for (uint32_t n=0; n < num_kept; n++) {
+        chula_list_del (&items[n].entry->entry);
+        chula_list_add_tail (&items[n].entry->entry, &enc->store.headers);
+    }
+
+    enc->num_kept   = num_kept;
+    enc->first_kept = num - num_kept;
+
+    return ret_ok;
+}
+
+/* A scheduled Maximum Header Table Size change goes first. Then, as every
+ * field of a Header Block is emitted explicitly, the Reference Set the
+ * decoder kept from the previous one is emptied, unless only the changes are
+ * rendered. Fields are reordered once the Header Table is as the decoder will
+ * start the Header Block with.
+ */
+static ret_t
+render_start (hpack_header_encoder_t *enc,
+              output_t               *output)
+{
+    ret_t    ret;
+    uint32_t start = output->len;
+
+    enc->num_kept = 0;
+    enc->rendered = 0;
+    hpack_header_table_set_clear (enc->kept);
+
+    if (enc->resize) {
+        ret = render_resize (enc, output);
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    if (enc->reorder) {
+        ret = reorder (enc);
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    if (hpack_header_table_set_is_empty (enc->reference_set)) {
+        ret = ret_ok;
+    } else if (enc->differential) {
+        ret = render_delta (enc, output);
+    } else {
+        hpack_header_table_set_clear (enc->reference_set);
+
+        /* Reference Set Emptying */
+        ret = output_add_char (output, 0x30);
+    }
+
+    if (enc->stats != NULL) {
+        enc->stats->wire_len += output->len - start;
+    }
+
+    return ret;
+}
+
+/* Relinks the kept fields in the order the decoder emits them: by entry,
+ * after the rendered ones.
+ */
+static void
+render_end (hpack_header_encoder_t *enc)
+{
+    kept_t               *items = (kept_t *) enc->order.buf;
+    hpack_set_iterator_t  iter;
+    int                   slot;
+
+    if (enc->num_kept == 0)
+        return;
+
+    hpack_set_iter_init (&iter, enc->kept);
+    while ((slot = hpack_set_iter_next (&iter)) != -1) {
+        for (uint32_t n=0; n < enc->num_kept; n++) {
+            if (items[n].slot != slot)
+                continue;
+
+            chula_list_del (&items[n].entry->entry);
+            chula_list_add_tail (&items[n].entry->entry, &enc->store.headers);
+            break;
+        }
+    }
+
+    enc->num_kept = 0;
+}
+
+/* Finishes a Header Block whose rendering was left in progress: what was
+ * encoded but not delivered goes first, then the fields not encoded yet.
+ */
+static ret_t
+render_resume (hpack_header_encoder_t     *enc,
+               output_t                   *output,
+               hpack_header_encoder_iov_t *iov)
+{
+    ret_t                       ret;
+    hpack_header_store_entry_t *entry;
+
+    ret = output_add (output, (const char *)enc->pending.buf + enc->pending_off,
+                      enc->pending.len - enc->pending_off);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    chula_buffer_clean (&enc->pending);
+    enc->pending_off = 0;
+
+    while (enc->next != &enc->store.headers) {
+        entry     = list_entry (enc->next, hpack_header_store_entry_t, entry);
+        enc->next = enc->next->next;
+
+        ret = render_field (enc, HPACK_HEADER_FIELD(entry), output, iov);
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    render_end (enc);
+    enc->next = NULL;
+
+    return ret_ok;
+}
+
+static ret_t
+render_fields (hpack_header_encoder_t     *enc,
+               output_t                   *output,
+               hpack_header_encoder_iov_t *iov)
+{
+    ret_t                       ret;
+    hpack_header_store_entry_t *i;
+
+    HPACK_PROBE1 (encoder_render_start, enc);
+
+    if (enc->next != NULL) {
+        ret = render_resume (enc, output, iov);
+        goto out;
+    }
+
+    ret = render_start (enc, output);
+    if (unlikely (ret != ret_ok)) goto out;
+
+    hpack_header_store_foreach (i, &enc->store) {
+        ret = render_field (enc, HPACK_HEADER_FIELD(i), output, iov);
+        if (unlikely (ret != ret_ok)) goto out;
+    }
+
+    render_end (enc);
+    ret = ret_ok;
+
+out:
+    HPACK_PROBE3 (encoder_render_end, enc, ret, output->len);
+    return ret;
+}
+
+ret_t
+hpack_header_encoder_render (hpack_header_encoder_t *enc,
+                             chula_buffer_t         *output)
+{
+    output_t out = {.buf = output, .frames = NULL, .len = 0};
+
+    return render_fields (enc, &out, NULL);
+}
+
+ret_t
+hpack_header_encoder_render_iov (hpack_header_encoder_t     *enc,
+                                 hpack_header_encoder_iov_t *iov)
+{
+    ret_t    ret;
+    output_t out = {.buf = &iov->arena, .frames = NULL, .len = 0};
+
+    /* Pieces from a previous rendering point to the arena */
+    iov_point (iov, false);
+
+    /* Encoded octets go to the arena */
+    ret = render_fields (enc, &out, iov);
+    if (likely (ret == ret_ok)) {
+        ret = iov_push_arena (iov);
+    }
+
+    iov_point (iov, true);
+    return ret;
+}
+
+/* Renders at most max_len octets, and returns ret_eagain if the Header Block
+ * has not been completely rendered yet. The next call goes on from the exact
+ * octet where this one stopped.
+ *
+ * Fields are encoded one at a time, so only the one that does not fit is
+ * kept aside. Each field is encoded only once, however many calls it takes
+ * to render it, which keeps the Header Table in step with the decoder.
+ */
+ret_t
+hpack_header_encoder_render_bounded (hpack_header_encoder_t *enc,
+                                     chula_buffer_t         *output,
+                                     uint32_t                max_len)
+{
+    ret_t                       ret;
+    uint32_t                    len;
+    hpack_header_store_entry_t *entry;
+    uint32_t                    start = output->len;
+    output_t                    out   = {.buf = &enc->pending, .frames = NULL, .len = 0};
+
+    HPACK_PROBE1 (encoder_render_start, enc);
+
+    if (enc->next == NULL) {
+        chula_buffer_clean (&enc->pending);
+        enc->pending_off = 0;
+
+        ret = render_start (enc, &out);
+        if (unlikely (ret != ret_ok)) goto out;
+
+        enc->next = enc->store.headers.next;
+    }
+
+    while (true) {
+        /* Whatever is left of the last field */
+        len = MIN (enc->pending.len - enc->pending_off, max_len - (output->len - start));
+
+        ret = chula_buffer_add (output, (const char *)enc->pending.buf + enc->pending_off, len);
+        if (unlikely (ret != ret_ok)) goto out;
+
+        enc->pending_off += len;
+
+        if (enc->pending_off < enc->pending.len) {
+            ret = ret_eagain;
+            goto out;
+        }
+
+        /* Done with the Header Block */
+        if (enc->next == &enc->store.headers) {
+            render_end (enc);
+            enc->next = NULL;
+            ret = ret_ok;
+            goto out;
+        }
+
+        /* Encode the next field */
+        chula_buffer_clean (&enc->pending);
+        enc->pending_off = 0;
+
+        entry     = list_entry (enc->next, hpack_header_store_entry_t, entry);
+        enc->next = enc->next->next;
+
+        ret = render_field (enc, HPACK_HEADER_FIELD(entry), &out, NULL);
+        if (unlikely (ret != ret_ok)) goto out;
+    }
+
+out:
+    HPACK_PROBE3 (encoder_render_end, enc, ret, output->len - start);
+    return ret;
+}
+
+/* Each payload is appended to until it holds frames->max_len octets.
+ *
+ * The Header Block is encoded aside first, so nothing is written to the
+ * payloads unless all of it fits. Otherwise it returns ret_deny and keeps
+ * the encoded Header Block, which is already accounted for in the Header
+ * Table: the next rendering, with more payloads or with any other render
+ * function, delivers it. Cleaning the encoder before that would leave the
+ * decoder out of step.
+ */
+ret_t
+hpack_header_encoder_render_frames (hpack_header_encoder_t        *enc,
+                                    hpack_header_encoder_frames_t *frames)
+{
+    ret_t    ret;
+    uint32_t room = 0;
+    output_t out  = {.buf = &enc->pending, .frames = NULL, .len = 0};
+
+    if (unlikely (frames->max_len == 0))
+        return ret_error;
+
+    if (enc->next == NULL) {
+        chula_buffer_clean (&enc->pending);
+        enc->pending_off = 0;
+
+        ret = render_fields (enc, &out, NULL);
+        if (unlikely (ret != ret_ok)) return ret;
+
+        /* Encoded, not delivered yet */
+        enc->next = &enc->store.headers;
+    }
+
+    for (unsigned int i=0; i < frames->num; i++) {
+        if (frames->payloads[i].len < frames->max_len) {
+            room += frames->max_len - frames->payloads[i].len;
+        }
+    }
+
+    if (enc->pending.len - enc->pending_off > room)
+        return ret_deny;
+
+    frames->used = 0;
+    out.buf      = NULL;
+    out.frames   = frames;
+
+    return render_fields (enc, &out, NULL);
+}
+
+/* Swaps the fields of two stores */
+static void
+swap_fields (hpack_header_store_t *a,
+             hpack_header_store_t *b)
+{
+    chula_list_t tmp;
+
+    INIT_LIST_HEAD (&tmp);
+    chula_list_reparent (&a->headers, &tmp);
+
+    INIT_LIST_HEAD (&a->headers);
+    chula_list_reparent (&b->headers, &a->headers);
+
+    INIT_LIST_HEAD (&b->headers);
+    chula_list_reparent (&tmp, &b->headers);
+}
+
+/* Huffman codes are up to 30 bits long */
+#define HUFFMAN_MAX_LEN(len) (((len) * 30 + 7) / 8)
+
+/* Octets a Header Block should not go over, to size the arena once. Each
+ * field takes at most its representation and index (3 octets), both string
+ * lengths (5 octets each) and both strings Huffman encoded.
+ */
+static uint32_t
+batch_room (hpack_header_encoder_batch_t *item)
+{
+    hpack_header_store_entry_t *i;
+    hpack_header_store_t       *fields = (item->fields != NULL) ? item->fields : &item->enc->store;
+    uint32_t                    room   = 8 + (2 * item->enc->table.num_headers);
+
+    hpack_header_store_foreach (i, fields) {
+        hpack_header_field_t *field = HPACK_HEADER_FIELD(i);
+        room += HUFFMAN_MAX_LEN(field->name.len) + HUFFMAN_MAX_LEN(field->value.len) + 13;
+    }
+
+    return room;
+}
+
+/* The next encoder is likely cold: its Header Table is read by every
+ * field rendered.
+ */
+static void
+batch_prefetch (hpack_header_encoder_batch_t *item)
+{
+    hpack_header_encoder_t *enc = item->enc;
+
+    HPACK_PREFETCH (&enc->table.num_headers);
+    HPACK_PREFETCH (enc->reference_set);
+
+    if (enc->table.headers_offsets.buffer != NULL) {
+        for (unsigned int n=0; n < HPACK_MAX_HEADER_TABLE_ENTRIES * sizeof(uint16_t); n += 64) {
+            HPACK_PREFETCH ((const char *) enc->table.headers_offsets.buffer + n);
+        }
+    }
+
+    if (item->fields != NULL) {
+        HPACK_PREFETCH (item->fields->headers.next);
+    }
+}
+
+/** Render the Header Blocks of many streams at once
+ *
+ * Header Blocks are rendered one after another, in the order of @a batch,
+ * into a single arena that grows once. Each item gets the offset and length
+ * of its Header Block. Streams of the same connection share its encoder, so
+ * the fields of each one can be supplied in a store of its own. They are
+ * rendered as if they had been added to the encoder, and are given back
+ * afterwards.
+ *
+ * @param[in,out] batch  Streams to render.
+ * @param[in]     num    Number of streams in @a batch.
+ * @param[out]    arena  Buffer the Header Blocks are appended to.
+ *
+ * @return Result of the operation. On error, the streams before the one
+ *         that failed are rendered.
+ */
+ret_t
+hpack_header_encoder_render_batch (hpack_header_encoder_batch_t *batch,
+                                   unsigned int                  num,
+                                   chula_buffer_t               *arena)
+{
+    ret_t    ret;
+    uint32_t room = 0;
+
+    for (unsigned int n=0; n < num; n++) {
+        batch[n].offset = arena->len;
+        batch[n].len    = 0;
+
+        room += batch_room (&batch[n]);
+    }
+
+    ret = chula_buffer_ensure_addlen (arena, room);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    for (unsigned int n=0; n < num; n++) {
+        hpack_header_encoder_batch_t *item = &batch[n];
+        output_t                      out  = {.buf = arena, .frames = NULL, .len = 0};
+
+        if (n + 1 < num) {
+            batch_prefetch (&batch[n + 1]);
+        }
+
+        if (item->fields != NULL) {
+            swap_fields (&item->enc->store, item->fields);
+        }
+
+        item->offset = arena->len;
+        ret = render_fields (item->enc, &out, NULL);
+        item->len    = out.len;
+
+        if (item->fields != NULL) {
+            swap_fields (&item->enc->store, item->fields);
+        }
 
-        ret = render_literal (enc, field, true, false, output);
         if (unlikely (ret != ret_ok)) return ret;
     }
 
@@ -42,24 +42,154 @@
 #include <libhpack/header_table.h>
 #include <libhpack/header_store.h>
 #include <libhpack/bitmap_set.h>
+#include <libhpack/stats.h>
+#include <libhpack/sensitive.h>
+
+#include <sys/uio.h>
 
 /**
- * Header Parser Structure.
+ * Header Block rendered as an I/O vector, ready for writev().
  */
 typedef struct {
-    hpack_header_store_t store;
-    chula_buffer_t       tmp;
-} hpack_header_encoder_t;
+    struct iovec   *iov;    /**< Pieces of the Header Block, in order. */
+    unsigned int    len;    /**< Pieces in use. */
+    unsigned int    size;   /**< Pieces allocated. */
+    uint32_t        total;  /**< Octets of the whole Header Block. */
+    chula_buffer_t  arena;  /**< Octets encoded by the encoder, which some pieces point to. */
+    uint32_t        mark;   /**< Octets of @a arena already covered by a piece. */
+} hpack_header_encoder_iov_t;
+
+/**
+ * Frame payloads to render a Header Block into, as a HEADERS frame followed
+ * by CONTINUATION frames.
+ */
+typedef struct {
+    chula_buffer_t *payloads;  /**< Payloads supplied by the caller, filled in order. */
+    unsigned int    num;       /**< Number of @a payloads. */
+    uint32_t        max_len;   /**< Maximum length of a payload: SETTINGS_MAX_FRAME_SIZE. */
+    unsigned int    used;      /**< Payloads with part of the Header Block. */
+} hpack_header_encoder_frames_t;
+
+/* Forward declaration */
+typedef struct hpack_header_encoder hpack_header_encoder_t;
+
+/**
+ * Header Block of a stream rendered by hpack_header_encoder_render_batch().
+ */
+typedef struct {
+    hpack_header_encoder_t *enc;     /**< Encoder of the connection of the stream. */
+    hpack_header_store_t   *fields;  /**< Fields of the stream, NULL for the ones added to @a enc. */
+    uint32_t                offset;  /**< Where the Header Block starts in the arena. */
+    uint32_t                len;     /**< Octets of the Header Block. */
+} hpack_header_encoder_batch_t;
+
+/** Slots of the sketch counting how many times each name was rendered */
+#define HPACK_ENCODER_SEEN_SLOTS 256
+
+/**
+ * Indexing policy: decides whether a Header Field is added to the Header
+ * Table when it is rendered.
+ */
+typedef bool (*hpack_header_encoder_policy_t) (hpack_header_encoder_t *enc,
+                                               hpack_header_field_t   *field,
+                                               void                   *data);
+
+/**
+ * Header Parser Structure.
+ */
+struct hpack_header_encoder {
+    hpack_header_store_t           store;
+    chula_buffer_t                 tmp;
+    hpack_stats_t                 *stats;
+    chula_list_t                  *next;          /**< Next field of a bounded rendering, NULL if none is in progress. */
+    chula_buffer_t                 pending;       /**< Encoded field that did not fit in the last bounded rendering. */
+    uint32_t                       pending_off;   /**< Octets of @a pending already rendered. */
+    hpack_header_table_t           table;         /**< Header Table, as the decoder will have it. */
+    hpack_set_t                    reference_set; /**< Reference Set, as the decoder will have it. */
+    hpack_header_encoder_policy_t  policy;        /**< Indexing policy. */
+    void                          *policy_data;   /**< Argument for @a policy. */
+    hpack_sensitive_t             *sensitive;     /**< Names never indexed, NULL for the default ones. */
+    bool                           resize;        /**< Whether a Maximum Header Table Size change is scheduled. */
+    uint16_t                       resize_to;     /**< Size to set at the start of the next Header Block. */
+    bool                           reorder;       /**< Whether fields are reordered before rendering them. */
+    chula_buffer_t                 order;         /**< Scratch space of the reordering pass, then fields kept in the Reference Set. */
+    bool                           differential;  /**< Whether fields left in the Reference Set are not rendered again. */
+    hpack_set_t                    kept;          /**< Entries of the fields kept in the Reference Set. */
+    uint32_t                       num_kept;      /**< Fields kept in the Reference Set, at the end of the store. */
+    uint32_t                       first_kept;    /**< Position of the first kept field. */
+    uint32_t                       rendered;      /**< Fields of the current Header Block rendered so far. */
+    uint16_t                       seen[HPACK_ENCODER_SEEN_SLOTS]; /**< Times the names were rendered, by hash. */
+};
 
 ret_t hpack_header_encoder_init     (hpack_header_encoder_t *enc);
 ret_t hpack_header_encoder_mrproper (hpack_header_encoder_t *enc);
+ret_t hpack_header_encoder_clean    (hpack_header_encoder_t *enc);
+
+ret_t hpack_header_encoder_set_stats (hpack_header_encoder_t *enc,
+                                      hpack_stats_t          *stats);
+
+ret_t hpack_header_encoder_set_policy (hpack_header_encoder_t        *enc,
+                                       hpack_header_encoder_policy_t  policy,
+                                       void                          *data);
+
+ret_t hpack_header_encoder_set_sensitive (hpack_header_encoder_t *enc,
+                                          hpack_sensitive_t      *sensitive);
+
+ret_t hpack_header_encoder_set_reorder (hpack_header_encoder_t *enc,
+                                        bool                    reorder);
+
+ret_t hpack_header_encoder_set_differential (hpack_header_encoder_t *enc,
+                                             bool                    differential);
+
+ret_t hpack_header_encoder_set_table_size (hpack_header_encoder_t *enc,
+                                           uint16_t                size);
+
+ret_t hpack_header_encoder_snapshot (hpack_header_encoder_t *enc,
+                                     chula_buffer_t         *out);
+ret_t hpack_header_encoder_restore  (hpack_header_encoder_t *enc,
+                                     chula_buffer_t         *buf,
+                                     unsigned int            offset,
+                                     unsigned int           *consumed);
+
+uint32_t hpack_header_encoder_seen (hpack_header_encoder_t *enc,
+                                    const chula_buffer_t   *name);
+
+/* Indexing policies */
+bool hpack_header_encoder_policy_always    (hpack_header_encoder_t *enc, hpack_header_field_t *field, void *data);
+bool hpack_header_encoder_policy_never     (hpack_header_encoder_t *enc, hpack_header_field_t *field, void *data);
+bool hpack_header_encoder_policy_max_value (hpack_header_encoder_t *enc, hpack_header_field_t *field, void *data);
+bool hpack_header_encoder_policy_min_seen  (hpack_header_encoder_t *enc, hpack_header_field_t *field, void *data);
+bool hpack_header_encoder_policy_cost      (hpack_header_encoder_t *enc, hpack_header_field_t *field, void *data);
 
 ret_t hpack_header_encoder_add       (hpack_header_encoder_t *enc,
                                       chula_buffer_t         *name,
                                       chula_buffer_t         *value);
 ret_t hpack_header_encoder_add_field (hpack_header_encoder_t *enc,
                                       hpack_header_field_t   *field);
+ret_t hpack_header_encoder_add_ref   (hpack_header_encoder_t *enc,
+                                      const chula_buffer_t   *name,
+                                      const chula_buffer_t   *value);
+ret_t hpack_header_encoder_adopt     (hpack_header_encoder_t *enc,
+                                      chula_buffer_t         *name,
+                                      chula_buffer_t         *value);
 ret_t hpack_header_encoder_render    (hpack_header_encoder_t *enc,
                                       chula_buffer_t         *output);
+ret_t hpack_header_encoder_render_bounded (hpack_header_encoder_t *enc,
+                                           chula_buffer_t         *output,
+                                           uint32_t                max_len);
+
+ret_t hpack_header_encoder_iov_init     (hpack_header_encoder_iov_t *iov);
+ret_t hpack_header_encoder_iov_mrproper (hpack_header_encoder_iov_t *iov);
+ret_t hpack_header_encoder_iov_clean    (hpack_header_encoder_iov_t *iov);
+
+ret_t hpack_header_encoder_render_iov (hpack_header_encoder_t     *enc,
+                                       hpack_header_encoder_iov_t *iov);
+
+ret_t hpack_header_encoder_render_frames (hpack_header_encoder_t        *enc,
+                                          hpack_header_encoder_frames_t *frames);
+
+ret_t hpack_header_encoder_render_batch (hpack_header_encoder_batch_t *batch,
+                                         unsigned int                  num,
+                                         chula_buffer_t               *arena);
 
 #endif /* LIBHPACK_HEADER_ENCODER_H */
@@ -95,14 +95,40 @@ hpack_header_field_init (hpack_header_field_t *header)
     header->flags.rep = rep_empty;
     header->flags.name = is_indexed_ht;
     header->flags.value = is_indexed_ht;
+    header->static_idx = 0;
+    header->atom = 0;
+    header->borrowed = false;
 
     ret  = chula_buffer_init (&header->name);
     ret += chula_buffer_init (&header->value);
+    ret += chula_buffer_init (&header->own_name);
+    ret += chula_buffer_init (&header->own_value);
 
     return ret;
 }
 
 
+/**
+ * @cond INTERNAL
+ * Stops borrowing memory: puts back the name and value buffers of the field.
+ * @endcond
+ */
+static inline void
+unborrow (hpack_header_field_t *header)
+{
+    if (likely (! header->borrowed))
+        return;
+
+    header->name  = header->own_name;
+    header->value = header->own_value;
+
+    chula_buffer_init (&header->own_name);
+    chula_buffer_init (&header->own_value);
+
+    header->borrowed = false;
+}
+
+
 /** Empties a Header Field
  *
  * Cleans a Header Field leaving it empty: No name or value and flag set to empty
@@ -122,6 +148,10 @@ ret_t
 hpack_header_field_clean (hpack_header_field_t *header)
 {
     header->flags.rep = rep_empty;
+    header->static_idx = 0;
+    header->atom = 0;
+
+    unborrow (header);
 
     chula_buffer_clean (&header->name);
     chula_buffer_clean (&header->value);
@@ -153,6 +183,8 @@ hpack_header_field_mrproper (hpack_header_field_t *header)
 {
     ret_t ret;
 
+    unborrow (header);
+
     ret  = chula_buffer_mrproper (&header->name);
     ret += chula_buffer_mrproper (&header->value);
 
@@ -183,6 +215,8 @@ hpack_header_field_copy (hpack_header_field_t *header,
     ret_t re;
 
     header->flags = tocopy->flags;
+    header->static_idx = tocopy->static_idx;
+    header->atom = tocopy->atom;
 
     re =  chula_buffer_add_buffer (&header->name, &tocopy->name);
     re += chula_buffer_add_buffer (&header->value, &tocopy->value);
@@ -191,6 +225,48 @@ hpack_header_field_copy (hpack_header_field_t *header,
 }
 
 
+/** Make a Header Field point to read-only name and value
+ *
+ * The name and value of the Header Field become @a name and @a value, without
+ * copying them. The buffers the field had are put aside and restored the next
+ * time the field is [cleaned](@ref hpack_header_field_clean), so borrowing
+ * never allocates or frees memory.
+ *
+ * The borrowed memory must outlive the field and must not be modified through
+ * the field: the borrowed buffers are read-only, chula functions that would
+ * grow them fail with ret_deny. [Copies](@ref hpack_header_field_copy) of the
+ * field own their data.
+ *
+ * @pre @a header needs to have at the very least been [initialized](@ref hpack_header_field_init)
+ *
+ * @param[in,out] header Header Field to borrow the memory.
+ * @param[in]     name   Name to borrow.
+ * @param[in]     value  Value to borrow.
+ *
+ * @return Result of the operation.
+ * @retval ret_ok  Currently the only possible result of the operation.
+ */
+ret_t
+hpack_header_field_borrow (hpack_header_field_t *header,
+                           const chula_buffer_t *name,
+                           const chula_buffer_t *value)
+{
+    if (! header->borrowed) {
+        header->own_name  = header->name;
+        header->own_value = header->value;
+        header->borrowed  = true;
+    }
+
+    /* No size: chula refuses to grow them */
+    header->name       = *name;
+    header->name.size  = 0;
+    header->value      = *value;
+    header->value.size = 0;
+
+    return ret_ok;
+}
+
+
 /** Check if the Header Field has any contents
  *
  * Checks whether the Header Field is empty or not.
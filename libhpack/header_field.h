@@ -114,11 +114,21 @@ typedef struct {
 
 /**
  * Header Field contents once a header field has been decoded.
+ *
+ * The buffers put aside while [borrowing](@ref hpack_header_field_borrow) cost
+ * 32 octets per field and per store entry (80 instead of 48 on LP64). They keep
+ * a field that alternates Static Table entries and literals, like the scratch
+ * field of the parser, from freeing and allocating its buffers on every header.
  */
 typedef struct {
-    hpack_header_field_flags_t flags; /**< How was this field encoded. */
-    chula_buffer_t             name;  /**< Name part of the header. */
-    chula_buffer_t             value; /**< Value part of the header. */
+    hpack_header_field_flags_t flags;      /**< How was this field encoded. */
+    chula_buffer_t             name;       /**< Name part of the header. */
+    chula_buffer_t             value;      /**< Value part of the header. */
+    uint8_t                    static_idx; /**< Static Table entry (name and value) of the field, 0 if none. */
+    uint16_t                   atom;       /**< Interned name of the field, 0 if unknown (see hpack_atoms_t). */
+    bool                       borrowed;   /**< Name and value point to read-only memory. */
+    chula_buffer_t             own_name;   /**< Name buffer put aside while borrowing. */
+    chula_buffer_t             own_value;  /**< Value buffer put aside while borrowing. */
 } hpack_header_field_t;
 
 #define HPACK_HEADER_FIELD(f) ((hpack_header_field_t *)(f))
@@ -131,6 +141,7 @@ ret_t hpack_header_field_clean    (hpack_header_field_t  *header);
 ret_t hpack_header_field_mrproper (hpack_header_field_t  *header);
 bool  hpack_header_field_is_empty (hpack_header_field_t  *header);
 ret_t hpack_header_field_copy     (hpack_header_field_t  *header, hpack_header_field_t *tocopy);
+ret_t hpack_header_field_borrow   (hpack_header_field_t  *header, const chula_buffer_t *name, const chula_buffer_t *value);
 ret_t hpack_header_field_repr     (hpack_header_field_t  *header, chula_buffer_t       *output);
 ret_t hpack_header_field_get_size (hpack_header_field_t  *header, uint64_t             *size);
 
@@ -48,6 +48,7 @@
 #include "header_parser.h"
 #include "integer.h"
 #include "huffman.h"
+#include "probes-internal.h"
 
 
 /** Reserves memory for a new Header Parser and initializes it
@@ -88,7 +89,25 @@ hpack_header_parser_init (hpack_header_parser_t *parser)
 {
     ret_t ret;
 
-    parser->store = NULL;
+    parser->store         = NULL;
+    parser->huffman_cache = NULL;
+    parser->atoms         = NULL;
+    parser->validate      = false;
+    parser->error         = hpack_parser_error_none;
+    parser->block_size    = 0;
+    parser->block_fields  = 0;
+
+    parser->bomb_func     = NULL;
+    parser->bomb_data     = NULL;
+    parser->tripped       = 0;
+    parser->last_ref      = 0;
+    parser->stats         = NULL;
+
+    hpack_header_field_init (&parser->scratch);
+
+    memset (&parser->limits,     0, sizeof(hpack_header_parser_limits_t));
+    memset (&parser->counters,   0, sizeof(hpack_header_parser_counters_t));
+    memset (&parser->thresholds, 0, sizeof(hpack_header_parser_thresholds_t));
 
     hpack_header_table_set_init (parser->context.reference_set, false);
     hpack_header_table_set_init (parser->context.ref_not_emitted, false);
@@ -119,6 +138,9 @@ hpack_header_parser_init (hpack_header_parser_t *parser)
 ret_t
 hpack_header_parser_mrproper (hpack_header_parser_t **parser)
 {
+    hpack_header_table_mrproper (&(*parser)->context.table);
+    hpack_header_field_mrproper (&(*parser)->scratch);
+
     free (*parser);
     *parser = NULL;
     return ret_ok;
@@ -148,6 +170,486 @@ hpack_header_parser_reg_store (hpack_header_parser_t *parser,
 }
 
 
+/** Register a cache for Huffman decoded strings
+ *
+ * Huffman encoded strings long enough will be looked up in the @a cache before
+ * decoding them, and stored in it afterwards. The cache is not owned by the
+ * parser, so it can be shared by all the parsers running on the same thread.
+ *
+ * @param[out]   parser  Parser to use the cache.
+ * @param[in]    cache   Cache to use, or NULL to stop using it.
+ *
+ * @return Result of the registration.
+ * @retval ret_ok  Currently is the only possible result.
+ */
+ret_t
+hpack_header_parser_set_huffman_cache (hpack_header_parser_t *parser,
+                                       hpack_huffman_cache_t *cache)
+{
+    parser->huffman_cache = cache;
+    return ret_ok;
+}
+
+
+/** Register an atoms table to tag emitted fields
+ *
+ * Every emitted Header Field will have its [atom](@ref hpack_header_field_t)
+ * set when its name is known by @a atoms. Names coming from the Static Table
+ * are resolved by their index, without hashing them.
+ *
+ * @param[out]   parser  Parser to use the atoms.
+ * @param[in]    atoms   Atoms table, or NULL to stop tagging fields.
+ *
+ * @return Result of the registration.
+ * @retval ret_ok  Currently is the only possible result.
+ */
+ret_t
+hpack_header_parser_set_atoms (hpack_header_parser_t *parser,
+                               hpack_atoms_t         *atoms)
+{
+    parser->atoms = atoms;
+    return ret_ok;
+}
+
+
+/** Enable the validation of literal names and values
+ *
+ * Literal names must be lowercase tokens, optionally prefixed by a colon, and
+ * literal values must not contain NUL, CR or LF. Raw strings are checked while
+ * they are copied, and Huffman encoded strings right after being decoded.
+ * Fields violating these rules make the parser return @c ret_deny, and the
+ * reason is left in the [error](@ref hpack_header_parser_error_t) of the parser.
+ *
+ * Names and values taken from the Header Table are not checked again.
+ *
+ * @param[out]   parser    Parser to configure.
+ * @param[in]    validate  Whether to validate strings.
+ *
+ * @return Result of the operation.
+ * @retval ret_ok  Currently is the only possible result.
+ */
+ret_t
+hpack_header_parser_set_validation (hpack_header_parser_t *parser,
+                                    bool                   validate)
+{
+    parser->validate = validate;
+    return ret_ok;
+}
+
+
+/** Set the resource limits of each Header Block
+ *
+ * The limits are checked while the Header Block is decoded, so it is rejected
+ * as soon as it is known to exceed one of them: string lengths are checked
+ * before waiting for, or copying, their octets, and Huffman encoded strings
+ * stop being decoded once they reach the limit. When a limit is exceeded the
+ * parser returns @c ret_deny, and the [error](@ref hpack_header_parser_error_t)
+ * of the parser tells which one it was.
+ *
+ * @param[out]   parser  Parser to configure.
+ * @param[in]    limits  Limits to apply. Fields set to zero are not limited.
+ *
+ * @return Result of the operation.
+ * @retval ret_ok  Currently is the only possible result.
+ */
+ret_t
+hpack_header_parser_set_limits (hpack_header_parser_t              *parser,
+                                const hpack_header_parser_limits_t *limits)
+{
+    parser->limits = *limits;
+    return ret_ok;
+}
+
+
+/** Set the decoding bomb thresholds
+ *
+ * The parser always keeps a few [counters](@ref hpack_header_parser_counters_t)
+ * of the current Header Block: evictions, Header Table Size updates, decoded
+ * and wire octets, and repeated references to the same entry. Once
+ * @a thresholds are set, they are checked after every representation. When a
+ * counter goes over its threshold @a func is called, just once per counter and
+ * Header Block. If it does not return @c ret_ok, or there is no @a func, the
+ * parser rejects the Header Block with @c ret_deny and
+ * [hpack_parser_error_bomb](@ref hpack_header_parser_error_t).
+ *
+ * @param[out]   parser      Parser to configure.
+ * @param[in]    thresholds  Thresholds to check, or NULL to stop checking them.
+ * @param[in]    func        Function to call when a threshold trips, or NULL.
+ * @param[in]    data        Argument for @a func.
+ *
+ * @return Result of the operation.
+ * @retval ret_ok  Currently is the only possible result.
+ */
+ret_t
+hpack_header_parser_set_bomb_detection (hpack_header_parser_t                  *parser,
+                                        const hpack_header_parser_thresholds_t *thresholds,
+                                        hpack_header_parser_bomb_func_t         func,
+                                        void                                   *data)
+{
+    if (thresholds != NULL) {
+        parser->thresholds = *thresholds;
+    } else {
+        memset (&parser->thresholds, 0, sizeof(hpack_header_parser_thresholds_t));
+    }
+
+    parser->bomb_func = func;
+    parser->bomb_data = data;
+    return ret_ok;
+}
+
+
+/** Register compression statistics
+ *
+ * The parser will count in @a stats every representation it decodes, the
+ * fields it emits, and the octets, evictions and table size updates they
+ * cause. The statistics are not owned by the parser, so they can be shared.
+ *
+ * @param[out]   parser  Parser to update the statistics.
+ * @param[in]    stats   Statistics to update, or NULL to stop updating them.
+ *
+ * @return Result of the registration.
+ * @retval ret_ok  Currently is the only possible result.
+ */
+ret_t
+hpack_header_parser_set_stats (hpack_header_parser_t *parser,
+                               hpack_stats_t         *stats)
+{
+    parser->stats = stats;
+    return ret_ok;
+}
+
+
+/**
+ * @cond INTERNAL
+ * Counts a decoded representation, starting by octet @a c, in the statistics.
+ * @endcond
+ */
+static inline void
+stats_representation (hpack_stats_t        *stats,
+                      unsigned char         c,
+                      hpack_header_field_t *field,
+                      unsigned int          consumed,
+                      uint32_t              evicted)
+{
+    stats->wire_len  += consumed;
+    stats->evictions += evicted;
+
+    if ((c & 0xE0) == 0x20) {
+        if (c != 0x30)
+            stats->size_updates += 1;
+        return;
+    }
+
+    if (c & 0x80u) {
+        stats->reps[rep_indexed] += 1;
+        return;
+    }
+
+    stats->reps[field->flags.rep] += 1;
+
+    if (field->flags.name == is_new_huffman) {
+        stats->strings_huffman += 1;
+    } else if (field->flags.name == is_new) {
+        stats->strings_raw += 1;
+    }
+
+    if (field->flags.value == is_new_huffman) {
+        stats->strings_huffman += 1;
+    } else {
+        stats->strings_raw += 1;
+    }
+}
+
+
+/**
+ * @cond INTERNAL
+ * Resets the accounting of the Header Block.
+ * @endcond
+ */
+static inline void
+block_reset (hpack_header_parser_t *parser)
+{
+    parser->block_size   = 0;
+    parser->block_fields = 0;
+    parser->tripped      = 0;
+    parser->last_ref     = 0;
+
+    memset (&parser->counters, 0, sizeof(hpack_header_parser_counters_t));
+}
+
+
+/**
+ * @cond INTERNAL
+ * Checks the decoding bomb counters against the thresholds of the parser.
+ * @endcond
+ */
+static ret_t
+check_counters (hpack_header_parser_t *parser)
+{
+    ret_t                             ret;
+    uint8_t                           tripped    = 0;
+    hpack_header_parser_counters_t   *counters   = &parser->counters;
+    hpack_header_parser_thresholds_t *thresholds = &parser->thresholds;
+
+    if ((thresholds->max_evictions != 0) &&
+        (counters->evictions > thresholds->max_evictions))
+        tripped |= hpack_parser_counter_evictions;
+
+    if ((thresholds->max_size_updates != 0) &&
+        (counters->size_updates > thresholds->max_size_updates))
+        tripped |= hpack_parser_counter_size_updates;
+
+    if ((thresholds->max_ratio != 0) &&
+        (counters->decoded_len > thresholds->ratio_slack) &&
+        (counters->decoded_len > counters->wire_len * thresholds->max_ratio))
+        tripped |= hpack_parser_counter_ratio;
+
+    if ((thresholds->max_repeated_refs != 0) &&
+        (counters->repeated_refs > thresholds->max_repeated_refs))
+        tripped |= hpack_parser_counter_repeated_refs;
+
+    /* Report each counter once per Header Block. */
+    tripped &= ~parser->tripped;
+    if (likely (tripped == 0))
+        return ret_ok;
+
+    parser->tripped |= tripped;
+
+    for (uint8_t counter = 1; counter <= hpack_parser_counter_repeated_refs; counter <<= 1) {
+        if (! (tripped & counter))
+            continue;
+
+        ret = ret_deny;
+        if (parser->bomb_func != NULL) {
+            ret = parser->bomb_func (counters, counter, parser->bomb_data);
+        }
+
+        if (ret != ret_ok) {
+            parser->error = hpack_parser_error_bomb;
+            return ret_deny;
+        }
+    }
+
+    return ret_ok;
+}
+
+
+/**
+ * @cond INTERNAL
+ * Returns how many octets a string can take without exceeding the limits of
+ * the parser, given that its field has already @a used some of them. Sets
+ * @a error to the limit it would exceed.
+ * @endcond
+ */
+static inline uint32_t
+string_budget (hpack_header_parser_t       *parser,
+               uint32_t                     used,
+               hpack_header_parser_error_t *error)
+{
+    uint64_t total;
+    uint32_t budget = HPACK_HUFFMAN_NO_LIMIT;
+
+    *error = hpack_parser_error_none;
+
+    if (parser->limits.max_string_len != 0) {
+        budget = parser->limits.max_string_len;
+        *error = hpack_parser_error_string_too_long;
+    }
+
+    if (parser->limits.max_header_list_size != 0) {
+        total = parser->block_size + used;
+
+        if (total >= parser->limits.max_header_list_size) {
+            budget = 0;
+            *error = hpack_parser_error_header_list_size;
+        } else if (parser->limits.max_header_list_size - total < budget) {
+            budget = parser->limits.max_header_list_size - total;
+            *error = hpack_parser_error_header_list_size;
+        }
+    }
+
+    return budget;
+}
+
+
+/**
+ * @cond INTERNAL
+ * Accounts an emitted Header Field in the current Header Block, and checks
+ * the limits of the parser.
+ * @endcond
+ */
+static inline ret_t
+account_field (hpack_header_parser_t *parser,
+               hpack_header_field_t  *field)
+{
+    parser->block_fields          += 1;
+    parser->block_size            += field->name.len + field->value.len + HPACK_HEADER_ENTRY_OVERHEAD;
+    parser->counters.decoded_len  += field->name.len + field->value.len;
+
+    if (parser->stats != NULL) {
+        parser->stats->fields      += 1;
+        parser->stats->decoded_len += field->name.len + field->value.len;
+    }
+
+    if (unlikely ((parser->limits.max_fields != 0) &&
+                  (parser->block_fields > parser->limits.max_fields)))
+    {
+        parser->error = hpack_parser_error_too_many_fields;
+        return ret_deny;
+    }
+
+    if (unlikely ((parser->limits.max_header_list_size != 0) &&
+                  (parser->block_size > parser->limits.max_header_list_size)))
+    {
+        parser->error = hpack_parser_error_header_list_size;
+        return ret_deny;
+    }
+
+    return ret_ok;
+}
+
+
+/**
+ * @cond INTERNAL
+ * Tags an emitted Header Field with the atom of its name.
+ * @endcond
+ */
+static inline void
+tag_atom (hpack_header_parser_t *parser,
+          hpack_header_field_t  *field)
+{
+    if ((parser->atoms == NULL) || (field->atom != HPACK_ATOM_NONE))
+        return;
+
+    if ((field->static_idx != 0) && (field->static_idx <= STATIC_ENTRIES)) {
+        field->atom = hpack_atoms_static (parser->atoms, field->static_idx);
+        return;
+    }
+
+    hpack_atoms_lookup (parser->atoms, &field->name, &field->atom);
+}
+
+
+/** Serialize the decoding context of a Header Parser
+ *
+ * Appends the decoding context of the @a parser to @a out, so it can be restored
+ * by [hpack_header_parser_restore](@ref hpack_header_parser_restore), for
+ * instance to move a connection to a different process.
+ *
+ * The snapshot is versioned and portable:
+ *
+ @verbatim
+   +------------------+-------------+-----------+
+   | Magic "HPCK" (32)| Version (8) | Flags (8) |
+   +------------------+-------------+-----------+
+   | Header Table (see hpack_header_table_snapshot)  |
+   +-------------------+------------------------------+
+   | Num. refs (8)     | HPACK Index (8) x Num. refs  |  Reference Set
+   +-------------------+------------------------------+
+   | Num. refs (8)     | HPACK Index (8) x Num. refs  |  References not emitted yet
+   +-------------------+------------------------------+
+ @endverbatim
+ *
+ * The only flag of a decoding context is bit 0, set when the current Header
+ * Block is finished. Bit 1 marks the [encoding contexts](@ref hpack_header_encoder_snapshot),
+ * which share the format from version 2 on. Version 1 snapshots can still be
+ * restored.
+ *
+ * A table attached to a [shared dictionary](@ref hpack_header_dict_t) is
+ * serialized with its content, and it is restored as a private table.
+ *
+ * @param[in]  parser  Parser to serialize.
+ * @param[out] out     Buffer to append the snapshot to.
+ *
+ * @return Result of the operation.
+ * @retval ret_nomem  Not enough memory to grow @a out.
+ * @retval ret_ok     The snapshot was appended.
+ */
+ret_t
+hpack_header_parser_snapshot (hpack_header_parser_t *parser,
+                              chula_buffer_t        *out)
+{
+    ret_t                          ret;
+    hpack_header_parser_context_t *context = &parser->context;
+
+    chula_buffer_add      (out, HPACK_SNAPSHOT_MAGIC, HPACK_SNAPSHOT_MAGIC_LEN);
+    chula_buffer_add_char (out, HPACK_SNAPSHOT_VERSION);
+    chula_buffer_add_char (out, context->finished ? HPACK_SNAPSHOT_FINISHED : 0);
+
+    ret = hpack_header_table_snapshot (&context->table, out);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    ret  = hpack_header_table_snapshot_set (&context->table, context->reference_set, out);
+    ret += hpack_header_table_snapshot_set (&context->table, context->ref_not_emitted, out);
+    if (unlikely (ret != ret_ok)) return ret_nomem;
+
+    return ret_ok;
+}
+
+
+/** Restore the decoding context of a Header Parser
+ *
+ * Replaces the decoding context of the @a parser with the one serialized by
+ * [hpack_header_parser_snapshot](@ref hpack_header_parser_snapshot). The
+ * registered store and Huffman cache are kept.
+ *
+ * @param[in,out] parser    Parser to restore.
+ * @param[in]     buf       Buffer with the snapshot.
+ * @param[in]     offset    Offset of the snapshot in @a buf.
+ * @param[out]    consumed  How many octets were consumed.
+ *
+ * @return Result of the operation.
+ * @retval ret_deny   The snapshot is from an unsupported version.
+ * @retval ret_error  The snapshot is truncated, corrupted or of an encoder.
+ * @retval ret_ok     The decoding context was restored.
+ */
+ret_t
+hpack_header_parser_restore (hpack_header_parser_t *parser,
+                             chula_buffer_t        *buf,
+                             unsigned int           offset,
+                             unsigned int          *consumed)
+{
+    ret_t                          ret;
+    uint8_t                        version;
+    uint8_t                        flags;
+    unsigned int                   con     = 0;
+    unsigned int                   n       = offset;
+    hpack_header_parser_context_t *context = &parser->context;
+
+    *consumed = 0;
+
+    if (unlikely ((buf->len < offset + HPACK_SNAPSHOT_MAGIC_LEN + 2) ||
+                  (memcmp (buf->buf + n, HPACK_SNAPSHOT_MAGIC, HPACK_SNAPSHOT_MAGIC_LEN) != 0)))
+        return ret_error;
+    n += HPACK_SNAPSHOT_MAGIC_LEN;
+
+    version = buf->buf[n++];
+    if (unlikely ((version < 1) || (version > HPACK_SNAPSHOT_VERSION)))
+        return ret_deny;
+
+    flags = buf->buf[n++];
+    if (unlikely (flags & HPACK_SNAPSHOT_ENCODER))
+        return ret_error;
+
+    context->finished = flags & HPACK_SNAPSHOT_FINISHED;
+
+    block_reset (parser);
+
+    ret = hpack_header_table_restore (&context->table, buf, n, &con);
+    if (unlikely (ret != ret_ok)) return ret;
+    n += con;
+
+    ret  = hpack_header_table_restore_set (&context->table, context->reference_set, buf, &n);
+    ret += hpack_header_table_restore_set (&context->table, context->ref_not_emitted, buf, &n);
+    if (unlikely (ret != ret_ok)) return ret_error;
+
+    hpack_header_table_iter_init (&context->iter_not_emitted, context->ref_not_emitted);
+
+    *consumed = n - offset;
+    return ret_ok;
+}
+
+
 /**
  * @cond INTERNAL
  * Adds a Header Field to the Header Table and takes care of the evictions by
@@ -213,33 +715,62 @@ add_field_process_evictions (hpack_header_parser_context_t *context,
  * Not only returns the string, but also whether it was Huffman encoded and how
  * many bytes were consumed to decode the String Representation.
  *
+ * Huffman encoded strings are decoded through the parser's
+ * [cache](@ref hpack_huffman_cache_t) when there is one, unless they are
+ * sensitive: values of fields never indexed are not kept around.
+ *
+ * If the parser validates strings, raw strings are checked while copied and
+ * Huffman encoded strings once decoded.
+ *
+ * Strings exceeding the [limits](@ref hpack_header_parser_limits_t) of the
+ * parser are rejected as soon as their length is known, and Huffman encoded
+ * strings stop being decoded when they reach them.
+ *
+ * @param[in]  parser    Parser decoding the string.
  * @param[in]  buf       Buffer with String Representation.
  * @param[in]  offset    Offset of the String Representation in the @a buf.
+ * @param[in]  is_name   Whether the string is a name or a value.
+ * @param[in]  sensitive Whether the string must not be cached.
+ * @param[in]  used      Octets of the header list size already used by the field.
  * @param[out] string    Destination of decoded string.
  * @param[out] huffman   If it was huffman encoded.
  * @param[out] consumed  How many octects were consumed.
  *
  * @return Result of the operation.
  * @retval ret_eagain  Try again when there's more data in the buffer.
+ * @retval ret_deny    The string did not pass the validation or exceeds the limits.
  * @retval ret_ok      String parsed successfully.
  * @retval ret_nomem   Not enough memory to allocate the @a string
  * @endcond
  */
 static ret_t
-parse_string (chula_buffer_t       *buf,
-              unsigned int          offset,
-              chula_buffer_t       *string,
-              bool                 *huffman,
-              unsigned int         *consumed)
+parse_string (hpack_header_parser_t *parser,
+              chula_buffer_t        *buf,
+              unsigned int           offset,
+              bool                   is_name,
+              bool                   sensitive,
+              uint32_t               used,
+              chula_buffer_t        *string,
+              bool                  *huffman,
+              unsigned int          *consumed)
 {
     ret_t        ret;
     uint32_t     n    = offset;
     unsigned int con  = 0;
     unsigned int len  = 0;
+    uint32_t     prev = string->len;
+    uint32_t     budget;
+    uint32_t     min_len;
+
+    hpack_header_parser_error_t limit_error;
 
     /* Unless we process the full string we haven't consumed any bytes. */
     *consumed = 0;
 
+    /* The string may start in the next chunk. */
+    if (unlikely (n >= buf->len))
+        return ret_eagain;
+
     *huffman = ((uint8_t)buf->buf[n]) & 0x80;
 
     /* Decode the length of the string. */
@@ -247,6 +778,17 @@ parse_string (chula_buffer_t       *buf,
     if (unlikely (ret != ret_ok)) return ret_error;
     n += con;
 
+    /* Reject strings that cannot fit before waiting for them. Huffman codes
+     * are 30 bits long at most.
+     */
+    budget  = string_budget (parser, used, &limit_error);
+    min_len = *huffman ? (uint32_t)(((uint64_t) len * 8) / 30) : len;
+
+    if (unlikely (min_len > budget)) {
+        parser->error = limit_error;
+        return ret_deny;
+    }
+
     /** @todo FIX this, because a Huffman encoded string does not need to fulfil this criteria. */
     if (buf->len < n + len) {
         return ret_eagain;
@@ -257,16 +799,45 @@ parse_string (chula_buffer_t       *buf,
         hpack_huffman_decode_context_t context = HUFFMAN_DEC_CTX_INIT;
         chula_buffer_t                 in      = CHULA_BUF_INIT_FAKE_LEN (buf->buf+n, len);
 
-        ret = hpack_huffman_decode (&in, string, &context);
+        context.limit = budget;
+
+        if ((parser->huffman_cache != NULL) && (! sensitive)) {
+            ret = hpack_huffman_cache_decode (parser->huffman_cache, &in, string, budget);
+        } else {
+            ret = hpack_huffman_decode (&in, string, &context);
+        }
+
+        if (unlikely (ret == ret_deny)) {
+            parser->error = limit_error;
+            return ret_deny;
+        }
         if (unlikely (ret != ret_ok)) return ret_error;
-        n += len;
+
+        if (parser->validate) {
+            ret = is_name ?
+                hpack_validate_name  (string->buf + prev, string->len - prev) :
+                hpack_validate_value (string->buf + prev, string->len - prev);
+        }
     }
-    else{
+    else if (parser->validate) {
+        ret = is_name ?
+            hpack_validate_copy_name  (string, buf->buf + n, len) :
+            hpack_validate_copy_value (string, buf->buf + n, len);
+        if (unlikely (ret == ret_nomem)) return ret_error;
+    }
+    else {
         ret = chula_buffer_add (string, (const char *)buf->buf + n, len);
         if (unlikely (ret != ret_ok)) return ret_error;
-        n += len;
     }
 
+    if (unlikely (ret == ret_deny)) {
+        parser->error = is_name ? hpack_parser_error_invalid_name :
+                                  hpack_parser_error_invalid_value;
+        return ret_deny;
+    }
+
+    n += len;
+
     /* Return */
     *consumed = (n - offset);
     return ret_ok;
@@ -304,6 +875,9 @@ parse_string (chula_buffer_t       *buf,
  * If the representation already existed in the reference set returned @a field
  * will be empty.
  *
+ * Static Table entries are returned [borrowing](@ref hpack_header_field_borrow)
+ * the static memory, and tagged with their [index](@ref hpack_header_table_static_t).
+ *
  * Not only returns the Header Field referenced by the Indexed Representation,
  * but also how many bytes were consumed to decode the Representation.
  *
@@ -313,6 +887,7 @@ parse_string (chula_buffer_t       *buf,
  * @param[in]     offset    Offset of the Indexed Representation in the @a buf.
  * @param[in,out] context   Decoding context for the Indexed Representation.
  * @param[out]    field     Field referenced by the Index.
+ * @param[out]    index     Index of the referenced entry once processed.
  * @param[out]    consumed  How many octects were consumed.
  *
  * @return Result of the operation.
@@ -323,6 +898,7 @@ parse_indexed (chula_buffer_t                *buf,
                unsigned int                   offset,
                hpack_header_parser_context_t *context,
                hpack_header_field_t          *field,
+               unsigned int                  *index,
                unsigned int                  *consumed)
 {
     ret_t        ret;
@@ -339,7 +915,7 @@ parse_indexed (chula_buffer_t                *buf,
     if (ret != ret_ok) return ret_error;
 
     /* Invalid index requested. */
-    if (num > STATIC_ENTRIES + context->table.num_headers) {
+    if ((num == 0) || (num > STATIC_ENTRIES + context->table.num_headers)) {
         /** @todo This may means that we have to purge the context, review HPACK specs */
         return ret_error;
     }
@@ -350,24 +926,40 @@ parse_indexed (chula_buffer_t                *buf,
         ret += hpack_header_table_set_remove (&context->table, context->ref_not_emitted, num);
         if (ret_ok != ret) return ret;
 
+        *index    = num;
         *consumed = con;
         return ret_ok;
     }
 
     field->flags.rep = rep_indexed;
 
-    /* Get referred index. */
-    ret = hpack_header_table_get (&context->table, num, false, field, &is_static);
+    /* Get referred index. Static entries are emitted straight from the Static
+     * Table, without copying them.
+     */
+    is_static = num > context->table.num_headers;
+
+    if (is_static) {
+        ret = hpack_header_table_get_static (&context->table, num, field);
+    } else {
+        ret = hpack_header_table_get (&context->table, num, false, field, &is_static);
+    }
     if (ret_ok != ret) return ret;
 
     /* If it's a static entry it must be added to Header Table. */
     if (is_static) {
-        /* We don't need to check if it could be added because we know that all
-         * static entries fit in the Header Table.
-         */
-        ret = add_field_process_evictions (context, field, NULL);
+        bool added;
+
+        /* It may not fit if the maximum size was shrunk by a context update. */
+        ret = add_field_process_evictions (context, field, &added);
         if (ret_ok != ret) return ret;
 
+        /* Emitted, but there is no entry to reference. */
+        if (! added) {
+            *index    = num;
+            *consumed = con;
+            return ret_ok;
+        }
+
         /* Since it has now been added it has a new index which will be used in the reference set. */
         num = 1;
     }
@@ -376,6 +968,7 @@ parse_indexed (chula_buffer_t                *buf,
     hpack_header_table_set_add (&context->table, context->reference_set, num);
     hpack_header_table_set_remove (&context->table, context->ref_not_emitted, num);
 
+    *index    = num;
     *consumed = con;
     return ret_ok;
 }
@@ -472,9 +1065,9 @@ parse_indexed (chula_buffer_t                *buf,
  *
  * @pre @a field is expected to be empty when the function is called.
  *
+ * @param[in,out] parser    Parser with the decoding context for the Literal Representation.
  * @param[in]     buf       Buffer with Literal Representation.
  * @param[in]     offset    Offset of the Literal Representation in the @a buf.
- * @param[in,out] context   Decoding context for the Literal Representation.
  * @param[out]    field     Field to return the Header Pair.
  * @param[out]    consumed  How many octects were consumed.
  *
@@ -482,28 +1075,31 @@ parse_indexed (chula_buffer_t                *buf,
  * @endcond
  */
 static inline ret_t
-parse_header_pair (chula_buffer_t                *buf,
+parse_header_pair (hpack_header_parser_t         *parser,
+                   chula_buffer_t                *buf,
                    unsigned int                   offset,
-                   hpack_header_parser_context_t *context,
                    hpack_header_field_t          *field,
                    unsigned int                  *consumed)
 {
-    ret_t          ret;
-    unsigned int   n    = offset;
-    unsigned int   con  = 0;
-    uint32_t       len  = 0;
-    bool           huffman;
+    ret_t                          ret;
+    unsigned int                   n       = offset;
+    unsigned int                   con     = 0;
+    uint32_t                       len     = 0;
+    int                            prefix;
+    bool                           huffman;
+    bool                           never_indexed;
+    hpack_header_parser_context_t *context = &parser->context;
 
     /* Unless everything goes OK we haven't consumed any bytes. */
     *consumed = 0;
 
+    /* We have 2 possible prefixes 6 and 4. */
+    prefix        = buf->buf[n] & 0xC0? 6 : 4;
+    never_indexed = (buf->buf[n] & 0xF0) == 0x10;
+
     /* If The Name is indexed */
-    if (buf->buf[n] & 0x0F) {
+    if (buf->buf[n] & ((1 << prefix) - 1)) {
         bool is_static;
-        int  prefix;
-
-        /* We have 2 possible prefixes 6 and 4. */
-        prefix = buf->buf[n] & 0xC0? 6 : 4;
 
         /* Decode the Index. */
         ret = hpack_integer_decode (prefix, (unsigned char *)buf->buf+n, buf->len-n, &len, &con);
@@ -515,11 +1111,17 @@ parse_header_pair (chula_buffer_t                *buf,
         field->flags.name = is_static? is_indexed_static : is_indexed_ht;
         if (ret != ret_ok) return ret;
 
+        /* Names from the Static Table do not need to be looked up. */
+        if ((is_static) && (parser->atoms != NULL)) {
+            field->atom = hpack_atoms_static (parser->atoms, len - context->table.num_headers);
+        }
+
     } else {
         n += 1;
 
         /* Get the Name in String Representation from the buffer. */
-        ret = parse_string (buf, n, &field->name, &huffman, &con);
+        ret = parse_string (parser, buf, n, true, false, HPACK_HEADER_ENTRY_OVERHEAD,
+                            &field->name, &huffman, &con);
         if (ret != ret_ok) return ret;
 
         field->flags.name = huffman? is_new_huffman : is_new;
@@ -527,7 +1129,8 @@ parse_header_pair (chula_buffer_t                *buf,
     }
 
     /* The Value always comes as a String Representation. */
-    ret = parse_string (buf, n, &field->value, &huffman, &con);
+    ret = parse_string (parser, buf, n, false, never_indexed, HPACK_HEADER_ENTRY_OVERHEAD + field->name.len,
+                        &field->value, &huffman, &con);
     if (ret != ret_ok) return ret;
     n += con;
 
@@ -595,6 +1198,10 @@ parse_context_update (chula_buffer_t                *buf,
     ret = hpack_integer_decode (4, (unsigned char *)buf->buf + offset, buf->len - offset, &num, &con);
     if (ret != ret_ok) return ret_error;
 
+    /* Checked before it is narrowed to the table size type */
+    if (unlikely (num > SETTINGS_HEADER_TABLE_SIZE))
+        return ret_error;
+
     /* Set the new size and get the set of evicted elements. */
     ret = hpack_header_table_set_max (&context->table, num, evicted_set);
     if (ret != ret_ok) return ret_error;
@@ -717,6 +1324,8 @@ final_reference_set_process (hpack_header_parser_context_t *context,
  * @param[out]    consumed  How many octects were consumed.
  *
  * @return Result of the header processing.
+ * @retval ret_deny  A string did not pass the [validation](@ref hpack_header_parser_set_validation),
+ *                   or the Header Block exceeds the [limits](@ref hpack_header_parser_set_limits).
  */
 ret_t
 hpack_header_parser_field (hpack_header_parser_t *parser,
@@ -727,14 +1336,35 @@ hpack_header_parser_field (hpack_header_parser_t *parser,
 {
     ret_t          ret;
     bool           do_indexing;
-    unsigned char  c              = buf->buf[offset];
+    unsigned int   index;
+    uint32_t       evicted;
+    unsigned char  c;
+    uint32_t       evictions      = parser->context.table.evictions;
 
     /* Field is empty unless we emit a header. */
     hpack_header_field_clean (field);
+    parser->error = hpack_parser_error_none;
 
     /* If there's no more data it means we have to proceed with the Reference Set Emission. */
-    if (offset == buf->len)
-        return (final_reference_set_process (&parser->context, field, consumed));
+    if (offset == buf->len) {
+        ret = final_reference_set_process (&parser->context, field, consumed);
+        if (ret != ret_ok) return ret;
+
+        tag_atom (parser, field);
+
+        ret = account_field (parser, field);
+        if (ret != ret_ok) return ret;
+
+        return check_counters (parser);
+    }
+
+    /* Only read past the end check: faked buffers are not NUL terminated */
+    c = buf->buf[offset];
+
+    /* A new Header Block starts */
+    if (parser->context.finished) {
+        block_reset (parser);
+    }
 
     /** @todo It's not nice to be setting @a context.finished on every iteration */
     parser->context.finished = false;
@@ -744,15 +1374,23 @@ hpack_header_parser_field (hpack_header_parser_t *parser,
     if ((c & 0xE0) == 0x20) {
         /* Context update */
         ret = parse_context_update (buf, offset, &parser->context, consumed);
-        return ret;
+        if (ret != ret_ok) return ret;
+
+        if (c != 0x30)
+            parser->counters.size_updates += 1;
     }
     else if (c & 0x80u) {
         /* Indexed header field: 1st bit set */
-        ret = parse_indexed (buf, offset, &parser->context, field, consumed);
+        ret = parse_indexed (buf, offset, &parser->context, field, &index, consumed);
         if (ret != ret_ok) return ret;
+
+        if (index == parser->last_ref)
+            parser->counters.repeated_refs += 1;
+
+        parser->last_ref = index;
     }
     else {
-        ret = parse_header_pair (buf, offset, &parser->context, field, consumed);
+        ret = parse_header_pair (parser, buf, offset, field, consumed);
         if (ret != ret_ok) return ret;
 
         /* Add to header table
@@ -772,6 +1410,10 @@ hpack_header_parser_field (hpack_header_parser_t *parser,
                 /* Add to the reference set and remove from the not emitted set. */
                 hpack_header_table_set_add (&parser->context.table, parser->context.reference_set, 1);
                 hpack_header_table_set_remove (&parser->context.table, parser->context.ref_not_emitted, 1);
+
+                /* The previously referenced entry has moved one position. */
+                if (parser->last_ref != 0)
+                    parser->last_ref += 1;
             }
 
         } else {
@@ -779,7 +1421,22 @@ hpack_header_parser_field (hpack_header_parser_t *parser,
         }
     }
 
-    return ret_ok;
+    evicted = parser->context.table.evictions - evictions;
+
+    parser->counters.wire_len  += *consumed;
+    parser->counters.evictions += evicted;
+
+    if (parser->stats != NULL)
+        stats_representation (parser->stats, c, field, *consumed, evicted);
+
+    if (! hpack_header_field_is_empty (field)) {
+        tag_atom (parser, field);
+
+        ret = account_field (parser, field);
+        if (ret != ret_ok) return ret;
+    }
+
+    return check_counters (parser);
 }
 
 
@@ -833,9 +1490,17 @@ hpack_header_parser_all (hpack_header_parser_t *parser,
                          unsigned int          *consumed)
 {
     ret_t                 ret;
-    hpack_header_field_t field;
+    hpack_header_field_t *field = &parser->scratch;
+
+    HPACK_PROBE2 (parser_block_start, parser, buf->len - offset);
 
-    hpack_header_field_init (&field);
+    /* Each call decodes a whole Header Block. An empty one still emits the
+     * Reference Set, so it cannot wait for its first octet to start.
+     */
+    if (parser->context.finished) {
+        block_reset (parser);
+        parser->context.finished = false;
+    }
 
     /* Parse raw header
      */
@@ -843,7 +1508,7 @@ hpack_header_parser_all (hpack_header_parser_t *parser,
         unsigned int         con   = 0;
 
         /* Parse a single header field */
-        ret = hpack_header_parser_field (parser, buf, offset, &field, &con);
+        ret = hpack_header_parser_field (parser, buf, offset, field, &con);
 
         /* Exit: When we have finished processing all the data + the Reference
          * Header Set. re_eof signals just that and we must actually exit with
@@ -866,13 +1531,16 @@ hpack_header_parser_all (hpack_header_parser_t *parser,
          * that must be emitted (non empty).
          */
         if ((parser->store) &&
-            (! hpack_header_field_is_empty(&field)))
+            (! hpack_header_field_is_empty(field)))
         {
-            ret = hpack_header_store_emit (parser->store, &field);
-            if (ret != ret_ok) return ret;
+            ret = hpack_header_store_emit (parser->store, field);
+            if (ret != ret_ok) break;
         }
     }
 
-    hpack_header_field_mrproper (&field);
+    HPACK_PROBE3 (parser_block_end, parser, ret, *consumed);
+
+    /* Keep the buffers of the scratch field for the next Header Block */
+    hpack_header_field_clean (field);
     return ret;
 }
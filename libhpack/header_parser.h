@@ -56,6 +56,10 @@
 #include <libhpack/header_field.h>
 #include <libhpack/header_table.h>
 #include <libhpack/header_store.h>
+#include <libhpack/huffman_cache.h>
+#include <libhpack/atom.h>
+#include <libhpack/validate.h>
+#include <libhpack/stats.h>
 #include <libhpack/bitmap_set.h>
 
 
@@ -70,12 +74,89 @@ typedef struct {
     bool                 finished;         /**< Marks when we will receive no more data to decode. */
 } hpack_header_parser_context_t;
 
+/**
+ * Reason why a Header Block was rejected.
+ */
+typedef enum {
+    hpack_parser_error_none = 0,       /**< No error. */
+    hpack_parser_error_invalid_name,   /**< Name with uppercase or non-token octets. */
+    hpack_parser_error_invalid_value,  /**< Value with NUL, CR or LF octets. */
+    hpack_parser_error_header_list_size, /**< Header Block over the maximum header list size. */
+    hpack_parser_error_too_many_fields,  /**< Header Block with too many fields. */
+    hpack_parser_error_string_too_long,  /**< Name or value over the maximum string length. */
+    hpack_parser_error_bomb,             /**< Header Block tripped a decoding bomb threshold. */
+} hpack_header_parser_error_t;
+
+/**
+ * Resource limits of a Header Block. Zero means no limit.
+ */
+typedef struct {
+    uint32_t max_header_list_size; /**< SETTINGS_MAX_HEADER_LIST_SIZE: name + value + 32 of all emitted fields. */
+    uint32_t max_fields;           /**< Maximum number of emitted fields. */
+    uint32_t max_string_len;       /**< Maximum decoded length of a name or a value. */
+} hpack_header_parser_limits_t;
+
+/**
+ * Counters of the current Header Block, to spot decoding bombs.
+ */
+typedef struct {
+    uint32_t evictions;      /**< Header Table entries evicted. */
+    uint32_t size_updates;   /**< Maximum Header Table Size updates. */
+    uint64_t wire_len;       /**< Octets of the Header Block decoded so far. */
+    uint64_t decoded_len;    /**< Octets of the emitted names and values. */
+    uint32_t repeated_refs;  /**< Indexed Representations of the entry referenced by the previous one. */
+} hpack_header_parser_counters_t;
+
+/**
+ * Decoding bomb counters, to report which threshold tripped.
+ */
+typedef enum {
+    hpack_parser_counter_evictions     = 1,
+    hpack_parser_counter_size_updates  = 1 << 1,
+    hpack_parser_counter_ratio         = 1 << 2,
+    hpack_parser_counter_repeated_refs = 1 << 3,
+} hpack_header_parser_counter_t;
+
+/**
+ * Decoding bomb thresholds of each Header Block. Zero means no threshold.
+ */
+typedef struct {
+    uint32_t max_evictions;      /**< Maximum Header Table entries evicted. */
+    uint32_t max_size_updates;   /**< Maximum Header Table Size updates. */
+    uint32_t max_ratio;          /**< Maximum ratio of decoded octets to wire octets. */
+    uint32_t ratio_slack;        /**< Decoded octets allowed before checking the ratio. */
+    uint32_t max_repeated_refs;  /**< Maximum repeated Indexed Representations. */
+} hpack_header_parser_thresholds_t;
+
+/**
+ * Function called when a threshold trips. The parser goes on decoding if it
+ * returns @c ret_ok, and rejects the Header Block otherwise.
+ */
+typedef ret_t (*hpack_header_parser_bomb_func_t) (const hpack_header_parser_counters_t *counters,
+                                                  hpack_header_parser_counter_t         counter,
+                                                  void                                 *data);
+
 /**
  * Header Parser Structure.
  */
 typedef struct {
-    hpack_header_parser_context_t context;  /**< Decoding context. */
-    hpack_header_store_t          *store;   /**< Storage to return decoded fields. */
+    hpack_header_parser_context_t      context;       /**< Decoding context. */
+    hpack_header_store_t              *store;         /**< Storage to return decoded fields. */
+    hpack_huffman_cache_t             *huffman_cache; /**< Optional cache of Huffman decoded strings. */
+    hpack_atoms_t                     *atoms;         /**< Optional atoms to tag the emitted fields with. */
+    bool                               validate;      /**< Whether literal names and values are validated. */
+    hpack_header_parser_error_t        error;         /**< Why the last field was rejected. */
+    hpack_header_parser_limits_t       limits;        /**< Resource limits of each Header Block. */
+    uint64_t                           block_size;    /**< Header list size of the current Header Block. */
+    uint32_t                           block_fields;  /**< Fields emitted in the current Header Block. */
+    hpack_header_parser_counters_t     counters;      /**< Decoding bomb counters of the current Header Block. */
+    hpack_header_parser_thresholds_t   thresholds;    /**< Decoding bomb thresholds. */
+    hpack_header_parser_bomb_func_t    bomb_func;     /**< Called when a threshold trips. */
+    void                              *bomb_data;     /**< Argument for @a bomb_func. */
+    uint8_t                            tripped;       /**< Counters that already tripped in the current Header Block. */
+    uint32_t                           last_ref;      /**< Index of the previous Indexed Representation. */
+    hpack_stats_t                     *stats;         /**< Optional compression statistics to update. */
+    hpack_header_field_t               scratch;       /**< Field decoded by hpack_header_parser_all(), reused across Header Blocks. */
 } hpack_header_parser_t;
 
 
@@ -86,6 +167,33 @@ ret_t hpack_header_parser_mrproper  (hpack_header_parser_t **parser);
 ret_t hpack_header_parser_reg_store (hpack_header_parser_t  *parser,
                                      hpack_header_store_t   *store);
 
+ret_t hpack_header_parser_set_huffman_cache (hpack_header_parser_t *parser,
+                                             hpack_huffman_cache_t *cache);
+
+ret_t hpack_header_parser_set_atoms (hpack_header_parser_t *parser,
+                                     hpack_atoms_t         *atoms);
+
+ret_t hpack_header_parser_set_validation (hpack_header_parser_t *parser,
+                                          bool                   validate);
+
+ret_t hpack_header_parser_set_limits (hpack_header_parser_t              *parser,
+                                      const hpack_header_parser_limits_t *limits);
+
+ret_t hpack_header_parser_set_bomb_detection (hpack_header_parser_t                  *parser,
+                                              const hpack_header_parser_thresholds_t *thresholds,
+                                              hpack_header_parser_bomb_func_t         func,
+                                              void                                   *data);
+
+ret_t hpack_header_parser_set_stats (hpack_header_parser_t *parser,
+                                     hpack_stats_t         *stats);
+
+ret_t hpack_header_parser_snapshot (hpack_header_parser_t  *parser,
+                                    chula_buffer_t         *out);
+ret_t hpack_header_parser_restore  (hpack_header_parser_t  *parser,
+                                    chula_buffer_t         *buf,
+                                    unsigned int            offset,
+                                    unsigned int           *consumed);
+
 ret_t hpack_header_parser_field     (hpack_header_parser_t  *parser,
                                      chula_buffer_t         *buf,
                                      unsigned int            offset,
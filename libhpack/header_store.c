@@ -36,10 +36,21 @@
 typedef hpack_header_store_entry_t entry_t;
 
 static ret_t
-entry_new (entry_t **e)
+entry_new (hpack_header_store_t *store,
+           entry_t             **e)
 {
     entry_t *obj;
 
+    /* Reuse the entry of a cleaned field, and its buffers */
+    if (! chula_list_empty (&store->spare)) {
+        obj = list_entry (store->spare.next, entry_t, entry);
+        chula_list_del (&obj->entry);
+        INIT_LIST_HEAD (&obj->entry);
+
+        *e = obj;
+        return ret_ok;
+    }
+
     obj = (entry_t *) malloc (sizeof(entry_t));
     if (unlikely (obj == NULL)) return ret_nomem;
 
@@ -65,10 +76,9 @@ add (hpack_header_store_t *store,
     ret_t    ret;
     entry_t *e;
 
-    ret = entry_new (&e);
+    ret = entry_new (store, &e);
     if (unlikely (ret != ret_ok)) return ret;
 
-    hpack_header_field_init (&e->field);
     hpack_header_field_copy (&e->field, field);
 
     chula_list_add_tail (&e->entry, &store->headers);
@@ -96,11 +106,52 @@ hpack_header_store_add (hpack_header_store_t *store,
     return add(store, field);
 }
 
+ret_t
+hpack_header_store_add_borrowed (hpack_header_store_t *store,
+                                 const chula_buffer_t *name,
+                                 const chula_buffer_t *value)
+{
+    ret_t    ret;
+    entry_t *e;
+
+    ret = entry_new (store, &e);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    /* The caller keeps owning name and value */
+    hpack_header_field_borrow (&e->field, name, value);
+
+    chula_list_add_tail (&e->entry, &store->headers);
+    return ret_ok;
+}
+
+/* Takes name and value over without copying them. They must have been
+ * allocated by chula, not faked. In exchange, the caller gets the empty
+ * buffers of the entry, which may already have room for the next field.
+ */
+ret_t
+hpack_header_store_adopt (hpack_header_store_t *store,
+                          chula_buffer_t       *name,
+                          chula_buffer_t       *value)
+{
+    ret_t    ret;
+    entry_t *e;
+
+    ret = entry_new (store, &e);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    chula_buffer_swap_buffers (&e->field.name,  name);
+    chula_buffer_swap_buffers (&e->field.value, value);
+
+    chula_list_add_tail (&e->entry, &store->headers);
+    return ret_ok;
+}
+
 
 ret_t
 hpack_header_store_init (hpack_header_store_t *store)
 {
     INIT_LIST_HEAD (&store->headers);
+    INIT_LIST_HEAD (&store->spare);
     store->emit = emit;
     return ret_ok;
 }
@@ -116,6 +167,30 @@ hpack_header_store_mrproper (hpack_header_store_t *store)
         entry_free(e);
     }
 
+    list_for_each_safe (i, tmp, &store->spare) {
+        entry_t *e = list_entry(i, entry_t, entry);
+        entry_free(e);
+    }
+
+    return ret_ok;
+}
+
+/* Empties the store, keeping the entries and their buffers for the next
+ * fields added to it.
+ */
+ret_t
+hpack_header_store_clean (hpack_header_store_t *store)
+{
+    chula_list_t *i, *tmp;
+
+    list_for_each_safe (i, tmp, &store->headers) {
+        entry_t *e = list_entry(i, entry_t, entry);
+
+        hpack_header_field_clean (&e->field);
+        chula_list_del (&e->entry);
+        chula_list_add_tail (&e->entry, &store->spare);
+    }
+
     return ret_ok;
 }
 
@@ -50,7 +50,8 @@ typedef ret_t (*hpack_header_store_emit_f) (hpack_header_store_t *store, hpack_h
 /* Classes */
 struct hpack_header_store {
     chula_list_t              headers;
-    hpack_header_store_emit_f emit;
+    hpack_header_store_emit_f emit;    /* Static Table fields borrow read-only buffers: copy them to keep or modify them */
+    chula_list_t              spare;   /* Entries of cleaned fields, reused with their buffers */
 };
 
 typedef struct {
@@ -63,11 +64,18 @@ typedef struct {
 
 ret_t hpack_header_store_init     (hpack_header_store_t *store);
 ret_t hpack_header_store_mrproper (hpack_header_store_t *store);
+ret_t hpack_header_store_clean    (hpack_header_store_t *store);
 
 ret_t hpack_header_store_add      (hpack_header_store_t *store,
                                    hpack_header_field_t *field);
 ret_t hpack_header_store_emit     (hpack_header_store_t *store,
                                    hpack_header_field_t *field);
+ret_t hpack_header_store_add_borrowed (hpack_header_store_t *store,
+                                       const chula_buffer_t *name,
+                                       const chula_buffer_t *value);
+ret_t hpack_header_store_adopt    (hpack_header_store_t *store,
+                                   chula_buffer_t       *name,
+                                   chula_buffer_t       *value);
 
 ret_t hpack_header_store_get_n    (hpack_header_store_t  *store,
                                    uint32_t               num,
@@ -121,6 +121,8 @@
 #include <libhpack/macros.h>
 #include <libhpack/header_table.h>
 #include <libhpack/header_field.h>
+#include <libhpack/header_dict.h>
+#include "probes-internal.h"
 
 
 /** Static Table Entry without a value
@@ -257,6 +259,55 @@ static ret_t header_data_get_chula (hpack_headers_data_cb_t *h_data, uint16_t of
 static ret_t header_data_add       (hpack_headers_data_cb_t *h_data, char *data, unsigned int data_size);
 
 
+/**
+ * Point the circular buffers to the memory of the table.
+ */
+static void
+header_table_point_storage (hpack_header_table_t *table)
+{
+    table->headers_offsets.buffer = (uint16_t *) table->storage;
+    table->headers_data.buffer    = (table->storage == NULL) ? NULL :
+        table->storage + HPACK_MAX_HEADER_TABLE_ENTRIES * sizeof(uint16_t);
+}
+
+
+/**
+ * Make the circular buffers writable before an entry is added. The memory of
+ * the table is allocated the first time, and the entries of the shared
+ * dictionary are copied into it if the table was reading them (copy-on-write).
+ *
+ * Since the table did not write its buffers while it was shared, the heads,
+ * tails and sizes are already right: only the buffers have to be copied.
+ *
+ * @param[in,out] table  Table to write to.
+ *
+ * @return Result of the operation.
+ * @retval ret_nomem  There's no memory for the circular buffers.
+ * @retval ret_ok     The buffers can be written.
+ */
+static ret_t
+header_table_own (hpack_header_table_t *table)
+{
+    if (likely ((table->shared == NULL) && (table->storage != NULL)))
+        return ret_ok;
+
+    if (table->storage == NULL) {
+        table->storage = (char *) malloc (HPACK_HEADER_TABLE_STORAGE);
+        if (unlikely (table->storage == NULL))
+            return ret_nomem;
+    }
+
+    if ((table->shared != NULL) && (table->shared->table.storage != NULL)) {
+        memcpy (table->storage, table->shared->table.storage, HPACK_HEADER_TABLE_STORAGE);
+    }
+
+    hpack_header_dict_unref (&table->shared);
+    header_table_point_storage (table);
+
+    return ret_ok;
+}
+
+
 /**
  * Evict 1 Header Field from the Header Table.
  * Since it's a FIFO you'll alway remove the oldest element which is the one at the Head.
@@ -286,6 +337,7 @@ header_table_evict (hpack_header_table_t *table,
     if (unlikely (0 == table->num_headers))
         return ret_ok;
 
+    /* Evicting only moves the heads: a shared dictionary can still be read. */
     evicted = table->headers_offsets.head;
 
     /* Both elements must belong to the same header field. */
@@ -307,8 +359,11 @@ header_table_evict (hpack_header_table_t *table,
                           HPACK_CB_HEADER_DATA_MASK);
 
     --table->num_headers;
+    ++table->evictions;
     table->used_data -= info.name_length + info.value_length + HPACK_HEADER_ENTRY_OVERHEAD;
 
+    HPACK_PROBE3 (table_evict, table, info.name_length + info.value_length, table->num_headers);
+
     /* Return */
     *ret_evicted = evicted;
     return ret_ok;
@@ -383,7 +438,7 @@ header_data_get (hpack_headers_data_cb_t *h_data,
     if (unlikely(num_bytes > HPACK_CB_HEADER_DATA_SIZE))
         return ret_error;
 
-    to_end = HPACK_CB_HEADER_DATA_SIZE - offset - h_data->head;
+    to_end = HPACK_CB_HEADER_DATA_SIZE - offset;
 
     memcpy (dst, h_data->buffer + offset, MIN(to_end,num_bytes));
 
@@ -429,7 +484,7 @@ header_data_get_chula (hpack_headers_data_cb_t *h_data,
     if (unlikely(num_bytes > HPACK_CB_HEADER_DATA_SIZE))
         return ret_error;
 
-    to_end = HPACK_CB_HEADER_DATA_SIZE - offset - h_data->head;
+    to_end = HPACK_CB_HEADER_DATA_SIZE - offset;
 
     ret = chula_buffer_add (dst, h_data->buffer + offset, MIN(to_end,num_bytes));
 
@@ -525,6 +580,10 @@ hpack_header_table_mrproper (hpack_header_table_t *table)
     ret = hpack_header_table_clear (table);
     if (unlikely (ret != ret_ok)) return ret;
 
+    free (table->storage);
+    table->storage = NULL;
+    header_table_point_storage (table);
+
     return ret_ok;
 }
 
@@ -544,6 +603,11 @@ hpack_header_table_init (hpack_header_table_t *table)
 {
     ret_t ret;
 
+    table->shared      = NULL;
+    table->storage     = NULL;
+    table->num_headers = 0;
+    table->evictions   = 0;
+
     ret = hpack_header_table_clear (table);
     if (unlikely (ret != ret_ok)) return ret;
 
@@ -556,6 +620,8 @@ hpack_header_table_init (hpack_header_table_t *table)
  * Clears all the header field entries, but does not change the Maximum header
  * size field.
  *
+ * If the table was attached to a shared dictionary it is released.
+ *
  * @param[out] table  Header Table to empty.
  *
  * @return Result of the operation.
@@ -564,6 +630,10 @@ hpack_header_table_init (hpack_header_table_t *table)
 ret_t
 hpack_header_table_clear (hpack_header_table_t *table)
 {
+    hpack_header_dict_unref (&table->shared);
+    header_table_point_storage (table);
+
+    table->evictions           += table->num_headers;
     table->num_headers          = 0;
     table->used_data            = 0;
     table->headers_offsets.head = 0;
@@ -591,7 +661,8 @@ hpack_header_table_clear (hpack_header_table_t *table)
  * @param[out]    evicted_set  Set with all the evicted indexes.
  *
  * @return The result of the operation.
- * @retval ret_ok     Currently this is the only possible result.
+ * @retval ret_ok     The field was added, or everything was evicted.
+ * @retval ret_nomem  There's no memory for the entries of the table.
  * @retval ret_error  There's been an error, which is impossible.
  */
 ret_t
@@ -635,6 +706,10 @@ hpack_header_table_add (hpack_header_table_t *table,
     if (unlikely (header_offs_is_full (&table->headers_offsets)))
         return ret_error;
 
+    /* The table diverges from the shared dictionary. */
+    ret = header_table_own (table);
+    if (unlikely (ret != ret_ok)) return ret;
+
     /* Now we add the Header_Field to the Header Table (offset and the data). */
 
     /* We can never fail because we made sure we had space to store everything,
@@ -650,17 +725,17 @@ hpack_header_table_add (hpack_header_table_t *table,
     info.name_length = field->name.len;
     info.value_length = field->value.len;
     info.flags = field->flags;
+    info.static_idx = field->static_idx;
 
     /* Store the info, followed by the name and the value. No '\0' is stored. */
     ret += header_data_add (&table->headers_data, (char *)&info, sizeof(info));
-    ret += header_data_add (&table->headers_data, (char *)field->name.buf , info.name_length);
+
+    if (0 < info.name_length)
+        ret += header_data_add (&table->headers_data, (char *)field->name.buf , info.name_length);
 
     if (0 < info.value_length)
         ret += header_data_add (&table->headers_data, (char *)field->value.buf, info.value_length);
 
-    if (unlikely (ret != ret_ok))
-        return ret_error;
-
     /* If there was an error, which is impossible because we checked that we
      * could add all the data, undo add.
      */
@@ -704,11 +779,17 @@ hpack_header_table_set_max (hpack_header_table_t *table,
     hpack_set_init (evicted_set, false);
 
     /* The table can never be larger than HTTP/2's SETTINGS_HEADER_TABLE_SIZE */
-    if (unlikely(max) > SETTINGS_HEADER_TABLE_SIZE)
+    if (unlikely (max > SETTINGS_HEADER_TABLE_SIZE))
         return ret_error;
 
+    HPACK_PROBE3 (table_resize, table, table->max_data, max);
+
     /* Encoder is not going to work with Header Table */
     if (0 == max) {
+        /* Everything is evicted, as when an entry does not fit. */
+        if (table->num_headers > 0)
+            hpack_set_init (evicted_set, true);
+
         hpack_header_table_clear (table);
 
     /* Decrease and lose data. Evict entries until we don't use more than the new max. */
@@ -770,6 +851,7 @@ hpack_header_table_get_set_idx (hpack_header_table_t *table,
     header_data_get (&table->headers_data, offset, (char *)&info, sizeof(info));
 
     f->flags = info.flags;
+    f->static_idx = 0;
 
     /* Get the name data */
     header_cb_move (offset, sizeof(info), HPACK_CB_HEADER_DATA_SIZE, HPACK_CB_HEADER_DATA_MASK);
@@ -778,6 +860,9 @@ hpack_header_table_get_set_idx (hpack_header_table_t *table,
     if (only_name || (ret_ok != ret ))
         return ret;
 
+    /* The Static Table entry is the name and the value */
+    f->static_idx = info.static_idx;
+
     /* Get the value data if there's data in it. */
     if (0 < info.value_length) {
         header_cb_move (offset, info.name_length, HPACK_CB_HEADER_DATA_SIZE, HPACK_CB_HEADER_DATA_MASK);
@@ -789,6 +874,158 @@ hpack_header_table_get_set_idx (hpack_header_table_t *table,
 
 
 
+/** Get an entry from the Static Table without copying it
+ *
+ * Makes the Header Field [borrow](@ref hpack_header_field_borrow) the name and
+ * value of a Static Table entry, so there is neither copying nor memory
+ * allocation. The field is tagged with the Static Table index it comes from.
+ *
+ * @param[in]  table  Header Table to resolve the HPACK index with.
+ * @param[in]  n      HPACK index of the entry, it must be of the Static Table.
+ * @param[out] f      Header Field to point to the entry.
+ *
+ * @return The result of the operation.
+ * @retval ret_not_found  The index is not of the Static Table.
+ * @retval ret_ok         The field points to the entry.
+ */
+ret_t
+hpack_header_table_get_static (hpack_header_table_t *table,
+                               uint16_t              n,
+                               hpack_header_field_t *f)
+{
+    static const chula_buffer_t empty = CHULA_BUF_INIT_FAKE("");
+
+    if (unlikely ((n <= table->num_headers) ||
+                  (n > STATIC_ENTRIES + table->num_headers)))
+        return ret_not_found;
+
+    /* Adjust index. */
+    n -= table->num_headers + 1;
+
+    hpack_header_field_borrow (f, &static_table[n].name,
+                               static_table[n].value.buf ? &static_table[n].value : &empty);
+
+    f->flags      = static_table[n].flags;
+    f->static_idx = n + 1;
+
+    return ret_ok;
+}
+
+
+/** Get the name of a Static Table entry
+ *
+ * @param[in]  n  Static Table index, from 1 to STATIC_ENTRIES.
+ *
+ * @return The name of the entry, NULL if the index is out of range.
+ */
+const chula_buffer_t *
+hpack_header_table_static_name (uint16_t n)
+{
+    if (unlikely ((n < 1) || (n > STATIC_ENTRIES)))
+        return NULL;
+
+    return &static_table[n-1].name;
+}
+
+
+/**
+ * @cond INTERNAL
+ * Compares octets of the Header Data Circular Buffer, starting at an offset,
+ * with a Chula Buffer.
+ * @endcond
+ */
+static bool
+header_data_equals (hpack_headers_data_cb_t *h_data,
+                    uint16_t                 offset,
+                    const chula_buffer_t    *buf)
+{
+    unsigned int to_end = HPACK_CB_HEADER_DATA_SIZE - offset;
+
+    if (buf->len == 0)
+        return true;
+
+    if (buf->len <= to_end)
+        return (memcmp (h_data->buffer + offset, buf->buf, buf->len) == 0);
+
+    return ((memcmp (h_data->buffer + offset, buf->buf, to_end) == 0) &&
+            (memcmp (h_data->buffer, buf->buf + to_end, buf->len - to_end) == 0));
+}
+
+
+/** Find a Header Field in the Header Table and the Static Table
+ *
+ * Looks for an entry with the @a name and @a value, or else for the first one
+ * with the @a name. The Header Table is searched from the newest entry, and
+ * then the Static Table. Entries are compared in place, without copying them.
+ *
+ * @param[in]  table      Header Table to search.
+ * @param[in]  name       Name of the Header Field.
+ * @param[in]  value      Value of the Header Field.
+ * @param[out] n          HPACK index of the entry.
+ * @param[out] name_only  Whether the entry has the name but not the value.
+ *
+ * @return The result of the operation.
+ * @retval ret_not_found  No entry has the name.
+ * @retval ret_ok         An entry was found.
+ */
+ret_t
+hpack_header_table_find (hpack_header_table_t *table,
+                         const chula_buffer_t *name,
+                         const chula_buffer_t *value,
+                         uint16_t             *n,
+                         bool                 *name_only)
+{
+    uint16_t                        offset;
+    hpack_header_table_field_info_t info;
+
+    *n         = 0;
+    *name_only = true;
+
+    for (uint16_t i = 1; i <= table->num_headers; i++) {
+        offset = table->headers_offsets.buffer[INDEX_SWITCH_HT_HPACK(table, i)];
+        header_data_get (&table->headers_data, offset, (char *)&info, sizeof(info));
+
+        if (info.name_length != name->len)
+            continue;
+
+        header_cb_move (offset, sizeof(info), HPACK_CB_HEADER_DATA_SIZE, HPACK_CB_HEADER_DATA_MASK);
+        if (! header_data_equals (&table->headers_data, offset, name))
+            continue;
+
+        if (info.value_length == value->len) {
+            header_cb_move (offset, info.name_length, HPACK_CB_HEADER_DATA_SIZE, HPACK_CB_HEADER_DATA_MASK);
+            if (header_data_equals (&table->headers_data, offset, value)) {
+                *n         = i;
+                *name_only = false;
+                return ret_ok;
+            }
+        }
+
+        if (*n == 0)
+            *n = i;
+    }
+
+    for (uint16_t i = 0; i < STATIC_ENTRIES; i++) {
+        if (chula_buffer_cmp_buf (&static_table[i].name, (chula_buffer_t *) name) != 0)
+            continue;
+
+        if ((static_table[i].value.len == value->len) &&
+            ((value->len == 0) ||
+             (memcmp (static_table[i].value.buf, value->buf, value->len) == 0)))
+        {
+            *n         = table->num_headers + i + 1;
+            *name_only = false;
+            return ret_ok;
+        }
+
+        if (*n == 0)
+            *n = table->num_headers + i + 1;
+    }
+
+    return (*n != 0) ? ret_ok : ret_not_found;
+}
+
+
 /** Get an entry from the Header Table and the Static Table
  *
  * Get a Header Field data from the Header Table or Static Table using an HPACK
@@ -823,7 +1060,7 @@ hpack_header_table_get (hpack_header_table_t *table,
     if (unlikely ((f == NULL) || (is_static == NULL)))
         return ret_error;
 
-    if (n > STATIC_ENTRIES + table->num_headers)
+    if ((n == 0) || (n > STATIC_ENTRIES + table->num_headers))
         return ret_not_found;
 
     *is_static = n > table->num_headers;
@@ -857,6 +1094,290 @@ hpack_header_table_get (hpack_header_table_t *table,
 }
 
 
+/**
+ * @cond INTERNAL
+ * Read a 16 bits big endian integer from a snapshot.
+ * @endcond
+ */
+static inline uint16_t
+snapshot_get_uint16 (const uint8_t *p)
+{
+    return (uint16_t) ((p[0] << 8) | p[1]);
+}
+
+
+/** Serialize the Header Table
+ *
+ * Appends the content of the Header Table to @a out, in the portable format used
+ * by [parser snapshots](@ref hpack_header_parser_snapshot):
+ *
+ @verbatim
+   +-----------------+-----------------+
+   |  Max size (16)  | Num entries (16)|
+   +-----------------+-----------------+--------------+------+-------+
+   | Name length (16)| Value length(16)|  Flags (8)   | Name | Value |  x Num entries
+   +-----------------+-----------------+--------------+------+-------+
+ @endverbatim
+ *
+ * Integers are big endian and entries go from the oldest to the newest one. The
+ * flags octet is the name type (2 bits), followed by the value type (2 bits) and
+ * the representation (3 bits), starting from the least significant bit.
+ *
+ * Entries are copied straight from the circular buffers to @a out.
+ *
+ * @param[in]  table  Header Table to serialize.
+ * @param[out] out    Buffer to append the serialized table to.
+ *
+ * @return Result of the operation.
+ * @retval ret_nomem  Not enough memory to grow @a out.
+ * @retval ret_ok     The table was serialized.
+ */
+ret_t
+hpack_header_table_snapshot (hpack_header_table_t *table,
+                             chula_buffer_t       *out)
+{
+    ret_t                           ret;
+    uint16_t                        offset;
+    hpack_header_table_field_info_t info;
+
+    /* The size includes HPACK's entry overhead, so everything will fit. */
+    ret = chula_buffer_ensure_addlen (out, 4 + table->used_data);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    chula_buffer_add_uint16be (out, table->max_data);
+    chula_buffer_add_uint16be (out, table->num_headers);
+
+    for (uint16_t i  = table->headers_offsets.head;
+                  i != table->headers_offsets.tail;
+                  i  = (i + 1) & HPACK_CB_HEADER_OFFSETS_MASK)
+    {
+        offset = table->headers_offsets.buffer[i];
+        header_data_get (&table->headers_data, offset, (char *)&info, sizeof(info));
+
+        chula_buffer_add_uint16be (out, info.name_length);
+        chula_buffer_add_uint16be (out, info.value_length);
+        chula_buffer_add_char     (out, info.flags.name | (info.flags.value << 2) | (info.flags.rep << 4));
+
+        /* Name and value are stored together. */
+        header_cb_move (offset, sizeof(info), HPACK_CB_HEADER_DATA_SIZE, HPACK_CB_HEADER_DATA_MASK);
+        ret = header_data_get_chula (&table->headers_data, offset, out, info.name_length + info.value_length);
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    return ret_ok;
+}
+
+
+/** Restore a serialized Header Table
+ *
+ * Replaces the content of the Header Table by the one serialized by
+ * [hpack_header_table_snapshot](@ref hpack_header_table_snapshot). Names and
+ * values are copied directly from @a buf into the table.
+ *
+ * @param[out] table     Header Table to restore.
+ * @param[in]  buf       Buffer with the serialized table.
+ * @param[in]  offset    Offset of the serialized table in @a buf.
+ * @param[out] consumed  How many octets were consumed.
+ *
+ * @return Result of the operation.
+ * @retval ret_error  The serialized table is truncated or corrupted.
+ * @retval ret_ok     The table was restored.
+ */
+ret_t
+hpack_header_table_restore (hpack_header_table_t *table,
+                            chula_buffer_t       *buf,
+                            unsigned int          offset,
+                            unsigned int         *consumed)
+{
+    ret_t                 ret;
+    uint16_t              max;
+    uint16_t              num;
+    uint16_t              name_len;
+    uint16_t              value_len;
+    uint8_t               flags;
+    hpack_set_t           evicted_set;
+    hpack_header_field_t  field;
+    const uint8_t        *p                = buf->buf + offset;
+    const uint8_t        *end              = buf->buf + buf->len;
+
+    *consumed = 0;
+
+    if (unlikely (end - p < 4))
+        return ret_error;
+
+    max = snapshot_get_uint16 (p);
+    num = snapshot_get_uint16 (p + 2);
+    p += 4;
+
+    hpack_header_table_clear (table);
+
+    ret = hpack_header_table_set_max (table, max, evicted_set);
+    if (unlikely (ret != ret_ok)) return ret_error;
+
+    /* Restored entries are not tagged */
+    hpack_header_field_init (&field);
+
+    for (uint16_t i=0; i < num; i++) {
+        if (unlikely (end - p < 5))
+            return ret_error;
+
+        name_len  = snapshot_get_uint16 (p);
+        value_len = snapshot_get_uint16 (p + 2);
+        flags     = p[4];
+        p += 5;
+
+        if (unlikely (end - p < name_len + value_len))
+            return ret_error;
+
+        chula_buffer_fake (&field.name,  (const char *)p, name_len);
+        chula_buffer_fake (&field.value, (const char *)p + name_len, value_len);
+
+        field.flags.name  = flags & 0x3;
+        field.flags.value = (flags >> 2) & 0x3;
+        field.flags.rep   = (flags >> 4) & 0x7;
+
+        ret = hpack_header_table_add (table, &field, evicted_set);
+        if (unlikely (ret != ret_ok)) return ret_error;
+
+        /* The entries fitted in the original table. */
+        if (unlikely (! hpack_set_is_empty (evicted_set)))
+            return ret_error;
+
+        p += name_len + value_len;
+    }
+
+    *consumed = p - (buf->buf + offset);
+    return ret_ok;
+}
+
+
+/** Serialize a set of Header Table entries
+ *
+ * Appends the set to @a out as a count followed by the HPACK index of each
+ * entry, one octet each (there are never more than 127 entries). It comes
+ * after the table in the snapshots of the [parser](@ref hpack_header_parser_snapshot)
+ * and the [encoder](@ref hpack_header_encoder_snapshot).
+ *
+ * @param[in]  table  Header Table the set refers to.
+ * @param[in]  set    Set to serialize.
+ * @param[out] out    Buffer to append the serialized set to.
+ *
+ * @return Result of the operation.
+ */
+ret_t
+hpack_header_table_snapshot_set (hpack_header_table_t *table,
+                                 hpack_set_t           set,
+                                 chula_buffer_t       *out)
+{
+    ret_t                ret;
+    int                  idx;
+    uint8_t              num  = 0;
+    uint32_t             pos  = out->len;
+    hpack_set_iterator_t iter;
+
+    ret = chula_buffer_ensure_addlen (out, 1 + table->num_headers);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    chula_buffer_add_char (out, 0);
+
+    hpack_header_table_iter_init (&iter, set);
+    while ((idx = hpack_header_table_iter_next (table, &iter)) != -1) {
+        chula_buffer_add_char (out, (char) idx);
+        num++;
+    }
+
+    out->buf[pos] = num;
+    return ret_ok;
+}
+
+
+/** Restore a set of Header Table entries
+ *
+ * Replaces the content of @a set with the one serialized by
+ * [hpack_header_table_snapshot_set](@ref hpack_header_table_snapshot_set).
+ * The Header Table has to be restored first.
+ *
+ * @param[in]     table   Header Table the set refers to.
+ * @param[out]    set     Set to restore.
+ * @param[in]     buf     Buffer with the serialized set.
+ * @param[in,out] offset  Offset of the serialized set in @a buf, moved past it.
+ *
+ * @return Result of the operation.
+ * @retval ret_error  The serialized set is truncated or refers to missing entries.
+ * @retval ret_ok     The set was restored.
+ */
+ret_t
+hpack_header_table_restore_set (hpack_header_table_t *table,
+                                hpack_set_t           set,
+                                chula_buffer_t       *buf,
+                                unsigned int         *offset)
+{
+    uint8_t num;
+    uint8_t idx;
+
+    hpack_header_table_set_clear (set);
+
+    if (unlikely (*offset >= buf->len))
+        return ret_error;
+
+    num = buf->buf[(*offset)++];
+    if (unlikely (buf->len - *offset < num))
+        return ret_error;
+
+    for (uint8_t i=0; i < num; i++) {
+        idx = buf->buf[(*offset)++];
+        if (unlikely ((idx < 1) || (idx > table->num_headers)))
+            return ret_error;
+
+        hpack_header_table_set_add (table, set, idx);
+    }
+
+    return ret_ok;
+}
+
+
+/** Start the Header Table from a shared dictionary
+ *
+ * The table is emptied and then it gets the same entries and maximum size the
+ * @a dict has. The entries are not copied until an entry is added to the table,
+ * and a table that did not have memory for its entries yet does not get it
+ * until then either. The table keeps a reference to the dictionary while it
+ * uses it.
+ *
+ * The dictionary becomes immutable.
+ *
+ * @param[in,out] table  Header Table to attach the dictionary to.
+ * @param[in]     dict   Shared dictionary.
+ *
+ * @return Result of the operation.
+ * @retval ret_ok  Currently this is the only possible result.
+ */
+ret_t
+hpack_header_table_attach_dict (hpack_header_table_t *table,
+                                hpack_header_dict_t  *dict)
+{
+    hpack_header_table_clear (table);
+
+    hpack_header_dict_freeze (dict);
+    hpack_header_dict_ref (dict);
+
+    table->headers_offsets.head = dict->table.headers_offsets.head;
+    table->headers_offsets.tail = dict->table.headers_offsets.tail;
+    table->headers_data.head    = dict->table.headers_data.head;
+    table->headers_data.tail    = dict->table.headers_data.tail;
+    table->num_headers          = dict->table.num_headers;
+    table->used_data            = dict->table.used_data;
+    table->max_data             = dict->table.max_data;
+    table->shared               = dict;
+
+    /* Read from the dictionary until the first entry is added */
+    table->headers_offsets.buffer = dict->table.headers_offsets.buffer;
+    table->headers_data.buffer    = dict->table.headers_data.buffer;
+
+    return ret_ok;
+}
+
+
 /** Returns the next existing element in the set
  *
  * Gets the next HPACK index from the Set continuing where it left of in the
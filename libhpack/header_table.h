@@ -73,6 +73,7 @@ typedef struct {
     uint16_t                   name_length;   /**< Octects used for the name. */
     uint16_t                   value_length;  /**< Octects used for the value. */
     hpack_header_field_flags_t flags;         /**< Flags for the header. */
+    uint8_t                    static_idx;    /**< Static Table entry of the field, 0 if none. */
 } hpack_header_table_field_info_t;
 
 
@@ -81,9 +82,9 @@ typedef struct {
  * header entry in the header's data array.
  */
 typedef struct {
-    uint16_t buffer[HPACK_MAX_HEADER_TABLE_ENTRIES];  /**< Array of offsets for the Header Entries. */
-    uint16_t head;                                    /**< Head of the Circular Buffer. */
-    uint16_t tail;                                    /**< Tail of the Circular Buffer. */
+    uint16_t *buffer;  /**< Array of HPACK_MAX_HEADER_TABLE_ENTRIES offsets for the Header Entries. */
+    uint16_t  head;    /**< Head of the Circular Buffer. */
+    uint16_t  tail;    /**< Tail of the Circular Buffer. */
 } hpack_headers_offs_cb_t;
 
 
@@ -91,11 +92,21 @@ typedef struct {
  * Structure for the Circular Buffer used to store the data of the Header Fields.
  */
 typedef struct {
-    char     buffer[HPACK_CB_HEADER_DATA_SIZE];  /**< Header Fields information. */
-    uint16_t head;                               /**< Head of the Circular Buffer. */
-    uint16_t tail;                               /**< Tail of the Circular Buffer. */
+    char     *buffer;  /**< HPACK_CB_HEADER_DATA_SIZE octets of Header Fields information. */
+    uint16_t  head;    /**< Head of the Circular Buffer. */
+    uint16_t  tail;    /**< Tail of the Circular Buffer. */
 } hpack_headers_data_cb_t;
 
+/**
+ * Octets allocated for the buffers of both Circular Buffers: the offsets
+ * followed by the data.
+ */
+#define HPACK_HEADER_TABLE_STORAGE \
+    (HPACK_MAX_HEADER_TABLE_ENTRIES * sizeof(uint16_t) + HPACK_CB_HEADER_DATA_SIZE)
+
+
+/* Forward declaration */
+typedef struct hpack_header_dict hpack_header_dict_t;
 
 /**
  * Structure for the whole Header Table.
@@ -108,6 +119,11 @@ typedef struct {
                                              *   is regarding the Maximum Table Size and not the actual
                                              *   bytes used). */
     uint16_t                max_data;         /**< Maximum Table Size as specified in HPACK */
+    uint32_t                evictions;        /**< Header Fields evicted since the table was initialized. */
+    hpack_header_dict_t    *shared;           /**< Dictionary the entries are read from until the
+                                             *   table is modified (copy-on-write). */
+    char                   *storage;          /**< Memory of the Circular Buffers. It is allocated when
+                                             *   the first entry is added. */
 } hpack_header_table_t;
 
 
@@ -116,6 +132,75 @@ typedef struct {
  */
 #define STATIC_ENTRIES 61u
 
+/**
+ * Static Table entries, as found in [hpack_header_field_t.static_idx](@ref hpack_header_field_t)
+ * of fields that are exactly a Static Table entry (name and value).
+ */
+typedef enum {
+    hpack_static_none                        = 0,
+    hpack_static_authority                   = 1,
+    hpack_static_method_get                  = 2,
+    hpack_static_method_post                 = 3,
+    hpack_static_path_root                   = 4,
+    hpack_static_path_index_html             = 5,
+    hpack_static_scheme_http                 = 6,
+    hpack_static_scheme_https                = 7,
+    hpack_static_status_200                  = 8,
+    hpack_static_status_204                  = 9,
+    hpack_static_status_206                  = 10,
+    hpack_static_status_304                  = 11,
+    hpack_static_status_400                  = 12,
+    hpack_static_status_404                  = 13,
+    hpack_static_status_500                  = 14,
+    hpack_static_accept_charset              = 15,
+    hpack_static_accept_encoding             = 16,
+    hpack_static_accept_language             = 17,
+    hpack_static_accept_ranges               = 18,
+    hpack_static_accept                      = 19,
+    hpack_static_access_control_allow_origin = 20,
+    hpack_static_age                         = 21,
+    hpack_static_allow                       = 22,
+    hpack_static_authorization               = 23,
+    hpack_static_cache_control               = 24,
+    hpack_static_content_disposition         = 25,
+    hpack_static_content_encoding            = 26,
+    hpack_static_content_language            = 27,
+    hpack_static_content_length              = 28,
+    hpack_static_content_location            = 29,
+    hpack_static_content_range               = 30,
+    hpack_static_content_type                = 31,
+    hpack_static_cookie                      = 32,
+    hpack_static_date                        = 33,
+    hpack_static_etag                        = 34,
+    hpack_static_expect                      = 35,
+    hpack_static_expires                     = 36,
+    hpack_static_from                        = 37,
+    hpack_static_host                        = 38,
+    hpack_static_if_match                    = 39,
+    hpack_static_if_modified_since           = 40,
+    hpack_static_if_none_match               = 41,
+    hpack_static_if_range                    = 42,
+    hpack_static_if_unmodified_since         = 43,
+    hpack_static_last_modified               = 44,
+    hpack_static_link                        = 45,
+    hpack_static_location                    = 46,
+    hpack_static_max_forwards                = 47,
+    hpack_static_proxy_authenticate          = 48,
+    hpack_static_proxy_authorization         = 49,
+    hpack_static_range                       = 50,
+    hpack_static_referer                     = 51,
+    hpack_static_refresh                     = 52,
+    hpack_static_retry_after                 = 53,
+    hpack_static_server                      = 54,
+    hpack_static_set_cookie                  = 55,
+    hpack_static_strict_transport_security   = 56,
+    hpack_static_transfer_encoding           = 57,
+    hpack_static_user_agent                  = 58,
+    hpack_static_vary                        = 59,
+    hpack_static_via                         = 60,
+    hpack_static_www_authenticate            = 61
+} hpack_header_table_static_t;
+
 ret_t hpack_header_table_new         (hpack_header_table_t **table);
 ret_t hpack_header_table_free        (hpack_header_table_t  *table);
 
@@ -125,7 +210,15 @@ ret_t hpack_header_table_clear       (hpack_header_table_t  *table);
 ret_t hpack_header_table_set_max     (hpack_header_table_t  *table, uint16_t max, hpack_set_t evicted_set);
 ret_t hpack_header_table_add         (hpack_header_table_t  *table, hpack_header_field_t *field, hpack_set_t evicted_set);
 ret_t hpack_header_table_get         (hpack_header_table_t  *table, uint16_t n, bool only_name, hpack_header_field_t *f, bool *is_static);
+ret_t hpack_header_table_get_static (hpack_header_table_t  *table, uint16_t n, hpack_header_field_t *f);
+ret_t hpack_header_table_find        (hpack_header_table_t  *table, const chula_buffer_t *name, const chula_buffer_t *value, uint16_t *n, bool *name_only);
+const chula_buffer_t *hpack_header_table_static_name (uint16_t n);
 ret_t hpack_header_table_get_set_idx (hpack_header_table_t  *table, uint16_t n, bool only_name, hpack_header_field_t *f);
+ret_t hpack_header_table_attach_dict (hpack_header_table_t  *table, hpack_header_dict_t *dict);
+ret_t hpack_header_table_snapshot    (hpack_header_table_t  *table, chula_buffer_t *out);
+ret_t hpack_header_table_restore     (hpack_header_table_t  *table, chula_buffer_t *buf, unsigned int offset, unsigned int *consumed);
+ret_t hpack_header_table_snapshot_set (hpack_header_table_t *table, hpack_set_t set, chula_buffer_t *out);
+ret_t hpack_header_table_restore_set  (hpack_header_table_t *table, hpack_set_t set, chula_buffer_t *buf, unsigned int *offset);
 void  hpack_header_table_repr        (hpack_header_table_t  *table, chula_buffer_t *output);
 
 /** Get the current size of the Header Table. */
@@ -117,10 +117,17 @@ hpack_huffman_encode (chula_buffer_t *in,
  * function, there is no need to pre-allocate memory for the
  * uncompressed output.
  *
+ * The output never grows more than the @a context's limit, which is
+ * decreased by the number of decoded octets. The output buffer is
+ * reserved just once, so memory usage is bounded by the input length
+ * and the limit.
+ *
  * @param      in           Buffer with the information to uncompress
  * @param[out] out          Buffer to uncompress the information to
  * @param[out] context      Context object for the Huffman decoding
  * @retval     ret_ok       Buffer successfully uncompressed
+ * @retval     ret_deny     The decoded string exceeds the limit
+ * @retval     ret_error    Invalid Huffman encoded string
  */
 ret_t
 hpack_huffman_decode (chula_buffer_t                 *in,
@@ -130,16 +137,21 @@ hpack_huffman_decode (chula_buffer_t                 *in,
     ret_t                         ret;
     uint8_t                       c;
     uint32_t                      n;
+    uint64_t                      max;
     const hpack_huffman_decode_t *t;
 
-    for (n=0; n < in->len; n++) {
-        /* Memory management */
-        if (out->size - out->len < 8) {
-            ret = chula_buffer_ensure_addlen (out, in->len * 2);
-            if (unlikely(ret != ret_ok))
-                return ret;
-        }
+    /* Memory management: Codes are 5 bits long at least, so every
+     * half byte decodes one symbol at most.
+     */
+    max = (uint64_t) in->len * 2;
+    if (max > context->limit)
+        max = context->limit;
 
+    ret = chula_buffer_ensure_addlen (out, max);
+    if (unlikely(ret != ret_ok))
+        return ret;
+
+    for (n=0; n < in->len; n++) {
         /* Decoding */
         c = ((uint8_t)in->buf[n]) >> 4;
         for (int halfbyte = 0; halfbyte < 2; ++halfbyte) {
@@ -148,8 +160,12 @@ hpack_huffman_decode (chula_buffer_t                 *in,
                 return ret_error;
             }
             if(t->flags & HPACK_HUFFMAN_SYMBOL) {
-                ret = chula_buffer_add_char (out, t->sym);
-                if (unlikely (ret != ret_ok)) return ret;
+                if (unlikely (context->limit == 0)) {
+                    out->buf[out->len] = '\0';
+                    return ret_deny;
+                }
+                out->buf[out->len++] = t->sym;
+                context->limit--;
             }
             context->state  = t->state;
             context->accept = (t->flags & HPACK_HUFFMAN_ACCEPTED) != 0;
@@ -157,5 +173,7 @@ hpack_huffman_decode (chula_buffer_t                 *in,
         }
     }
 
+    out->buf[out->len] = '\0';
+
     return ret_ok;
 }
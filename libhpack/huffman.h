@@ -53,12 +53,16 @@ typedef enum {
     HPACK_HUFFMAN_SYMBOL   = 1 << 1,
 } hpack_huffman_decode_flag;
 
+/** No limit on the number of decoded octets */
+#define HPACK_HUFFMAN_NO_LIMIT UINT32_MAX
+
 typedef struct {
-    uint8_t state;
-    uint8_t accept;
+    uint8_t  state;
+    uint8_t  accept;
+    uint32_t limit;   /**< Octets that can still be decoded. */
 } hpack_huffman_decode_context_t;
 
-#define HUFFMAN_DEC_CTX_INIT {.state = 0, .accept = 1}
+#define HUFFMAN_DEC_CTX_INIT {.state = 0, .accept = 1, .limit = HPACK_HUFFMAN_NO_LIMIT}
 
 typedef struct {
     int16_t state;
@@ -0,0 +1,248 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file      huffman_cache.c
+ * @brief     Cache of Huffman decoded strings.
+ *
+ * Entries are kept in a fixed size hash table indexed by the CRC32 of the
+ * encoded octets, and in a LRU list that is used to evict the least recently
+ * used entries once the cache goes over its size limit. The size accounted for
+ * each entry includes both strings and the entry structure itself.
+ *
+ * @date      October, 2026
+ */
+
+#include "huffman_cache.h"
+#include "huffman.h"
+#include "macros.h"
+
+typedef hpack_huffman_cache_entry_t entry_t;
+
+#define ENTRY_SIZE(e) (sizeof(entry_t) + (e)->encoded.len + (e)->decoded.len)
+#define BUCKET(c,h)   (&(c)->buckets[(h) & (HPACK_HUFFMAN_CACHE_BUCKETS - 1)])
+
+
+static void
+entry_free (hpack_huffman_cache_t *cache,
+            entry_t               *e)
+{
+    cache->size -= ENTRY_SIZE(e);
+
+    chula_list_del (&e->bucket);
+    chula_list_del (&e->lru);
+
+    chula_buffer_mrproper (&e->encoded);
+    chula_buffer_mrproper (&e->decoded);
+    free (e);
+}
+
+
+ret_t
+hpack_huffman_cache_init (hpack_huffman_cache_t *cache)
+{
+    for (int i=0; i < HPACK_HUFFMAN_CACHE_BUCKETS; i++) {
+        INIT_LIST_HEAD (&cache->buckets[i]);
+    }
+    INIT_LIST_HEAD (&cache->lru);
+
+    cache->size     = 0;
+    cache->max_size = HPACK_HUFFMAN_CACHE_MAX_SIZE;
+    cache->min_len  = HPACK_HUFFMAN_CACHE_MIN_LEN;
+    cache->hits     = 0;
+    cache->misses   = 0;
+
+    return ret_ok;
+}
+
+
+ret_t
+hpack_huffman_cache_clear (hpack_huffman_cache_t *cache)
+{
+    chula_list_t *i, *tmp;
+
+    list_for_each_safe (i, tmp, &cache->lru) {
+        entry_free (cache, list_entry (i, entry_t, lru));
+    }
+
+    return ret_ok;
+}
+
+
+ret_t
+hpack_huffman_cache_mrproper (hpack_huffman_cache_t *cache)
+{
+    return hpack_huffman_cache_clear (cache);
+}
+
+HPACK_ADD_FUNC_NEW(huffman_cache);
+HPACK_ADD_FUNC_FREE(huffman_cache);
+
+
+/** Evict least recently used entries until @a needed octets fit.
+ */
+static void
+evict (hpack_huffman_cache_t *cache,
+       uint32_t               needed)
+{
+    while ((! chula_list_empty (&cache->lru)) &&
+           (cache->size + needed > cache->max_size))
+    {
+        entry_free (cache, list_entry (cache->lru.prev, entry_t, lru));
+    }
+}
+
+
+ret_t
+hpack_huffman_cache_configure (hpack_huffman_cache_t *cache,
+                               uint32_t               max_size,
+                               uint32_t               min_len)
+{
+    cache->max_size = max_size;
+    cache->min_len  = min_len;
+
+    evict (cache, 0);
+    return ret_ok;
+}
+
+
+static ret_t
+insert (hpack_huffman_cache_t *cache,
+        crc_t                  hash,
+        chula_buffer_t        *encoded,
+        const char            *decoded,
+        uint32_t               decoded_len)
+{
+    ret_t     ret;
+    entry_t  *e;
+    uint32_t  size = sizeof(entry_t) + encoded->len + decoded_len;
+
+    /* It would not fit, even with an empty cache. */
+    if (size > cache->max_size)
+        return ret_ok;
+
+    evict (cache, size);
+
+    e = (entry_t *) malloc (sizeof(entry_t));
+    if (unlikely (e == NULL)) return ret_nomem;
+
+    chula_buffer_init (&e->encoded);
+    chula_buffer_init (&e->decoded);
+
+    ret  = chula_buffer_add (&e->encoded, (const char *)encoded->buf, encoded->len);
+    ret |= chula_buffer_add (&e->decoded, decoded, decoded_len);
+    if (unlikely (ret != ret_ok)) {
+        chula_buffer_mrproper (&e->encoded);
+        chula_buffer_mrproper (&e->decoded);
+        free (e);
+        return ret_nomem;
+    }
+
+    e->hash = hash;
+    chula_list_add (&e->bucket, BUCKET(cache, hash));
+    chula_list_add (&e->lru, &cache->lru);
+
+    cache->size += ENTRY_SIZE(e);
+    return ret_ok;
+}
+
+
+/** Decode a Huffman encoded string using the cache
+ *
+ * Works like [hpack_huffman_decode](@ref hpack_huffman_decode) for a complete
+ * string: the decoded string is appended to @a out. Strings shorter than the
+ * cache's minimum length skip the cache altogether.
+ *
+ * @param[in,out] cache  Cache to look the string up in, and to store it in.
+ * @param[in]     in     Huffman encoded octets.
+ * @param[out]    out    Buffer where the decoded string is appended.
+ * @param[in]     limit  Maximum length of the decoded string, or
+ *                       HPACK_HUFFMAN_NO_LIMIT.
+ *
+ * @return Result of the operation.
+ * @retval ret_ok     String decoded successfully.
+ * @retval ret_deny   The decoded string is longer than @a limit.
+ * @retval ret_error  Invalid Huffman encoded string.
+ * @retval ret_nomem  Not enough memory.
+ */
+ret_t
+hpack_huffman_cache_decode (hpack_huffman_cache_t *cache,
+                            chula_buffer_t        *in,
+                            chula_buffer_t        *out,
+                            uint32_t               limit)
+{
+    ret_t                          ret;
+    crc_t                          hash;
+    entry_t                       *e;
+    uint32_t                       out_len;
+    hpack_huffman_decode_context_t context = HUFFMAN_DEC_CTX_INIT;
+
+    context.limit = limit;
+
+    /* Short strings are cheaper to decode than to look up. */
+    if (in->len < cache->min_len) {
+        return hpack_huffman_decode (in, out, &context);
+    }
+
+    hash = crc32_sz ((char *)in->buf, in->len);
+
+    list_for_each_entry (e, BUCKET(cache, hash), bucket) {
+        if ((e->hash != hash) ||
+            (e->encoded.len != in->len) ||
+            (memcmp (e->encoded.buf, in->buf, in->len) != 0))
+            continue;
+
+        /* Hit: Move it to the front of the LRU list. */
+        chula_list_del (&e->lru);
+        chula_list_add (&e->lru, &cache->lru);
+
+        cache->hits++;
+
+        if (unlikely (e->decoded.len > limit))
+            return ret_deny;
+
+        return chula_buffer_add_buffer (out, &e->decoded);
+    }
+
+    /* Miss: Decode and remember the result. */
+    cache->misses++;
+    out_len = out->len;
+
+    ret = hpack_huffman_decode (in, out, &context);
+    if (ret != ret_ok) return ret;
+
+    /* The string is decoded already: not being able to cache it is no
+     * reason to fail. It will be a miss again next time.
+     */
+    insert (cache, hash, in, (const char *)out->buf + out_len, out->len - out_len);
+    return ret_ok;
+}
@@ -0,0 +1,107 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file      huffman_cache.h
+ * @brief     Cache of Huffman decoded strings.
+ *
+ * Many Huffman encoded strings (user-agents, accept headers, cookies) are
+ * received over and over again, on the same and on different connections.
+ * This cache stores the result of decoding them keyed on the encoded octets,
+ * so a repeated string only costs a hash lookup and a copy.
+ *
+ * The cache is not thread safe. It is meant to be owned by a single thread and
+ * shared by all the [Header Parsers](@ref hpack_header_parser_t) running on it.
+ *
+ * @date      October, 2026
+ */
+
+#ifndef LIBHPACK_HUFFMAN_CACHE_H
+#define LIBHPACK_HUFFMAN_CACHE_H
+
+#if !defined(HPACK_H_INSIDE) && !defined (HPACK_COMPILATION)
+# error "Only <libhpack/libhpack.h> can be included directly."
+#endif
+
+#include <libchula/libchula.h>
+#include <libhpack/huffman.h>
+
+/** Number of hash buckets. It must be a power of two. */
+#define HPACK_HUFFMAN_CACHE_BUCKETS   256
+
+/** Default amount of octets the cache can hold. */
+#define HPACK_HUFFMAN_CACHE_MAX_SIZE  (64 * 1024)
+
+/** Default minimum encoded length for a string to be cached. */
+#define HPACK_HUFFMAN_CACHE_MIN_LEN   16
+
+/**
+ * Cache entry. It is linked in both its hash bucket and the LRU list.
+ */
+typedef struct {
+    chula_list_t   bucket;   /**< Entry in the hash bucket list. */
+    chula_list_t   lru;      /**< Entry in the LRU list. */
+    crc_t          hash;     /**< Hash of the encoded string. */
+    chula_buffer_t encoded;  /**< Huffman encoded octets (key). */
+    chula_buffer_t decoded;  /**< Decoded string. */
+} hpack_huffman_cache_entry_t;
+
+/**
+ * Huffman decoded string cache.
+ */
+typedef struct {
+    chula_list_t buckets[HPACK_HUFFMAN_CACHE_BUCKETS]; /**< Hash buckets. */
+    chula_list_t lru;                                  /**< Entries, most recently used first. */
+    uint32_t     size;                                 /**< Octets currently held by the cache. */
+    uint32_t     max_size;                             /**< Maximum octets the cache can hold. */
+    uint32_t     min_len;                              /**< Shorter encoded strings are not cached. */
+    uint64_t     hits;                                 /**< Lookups served from the cache. */
+    uint64_t     misses;                               /**< Lookups that required decoding. */
+} hpack_huffman_cache_t;
+
+
+ret_t hpack_huffman_cache_new       (hpack_huffman_cache_t **cache);
+ret_t hpack_huffman_cache_free      (hpack_huffman_cache_t  *cache);
+ret_t hpack_huffman_cache_init      (hpack_huffman_cache_t  *cache);
+ret_t hpack_huffman_cache_mrproper  (hpack_huffman_cache_t  *cache);
+ret_t hpack_huffman_cache_clear     (hpack_huffman_cache_t  *cache);
+
+ret_t hpack_huffman_cache_configure (hpack_huffman_cache_t  *cache,
+                                     uint32_t                max_size,
+                                     uint32_t                min_len);
+
+ret_t hpack_huffman_cache_decode    (hpack_huffman_cache_t  *cache,
+                                     chula_buffer_t         *in,
+                                     chula_buffer_t         *out,
+                                     uint32_t                limit);
+
+#endif /* LIBHPACK_HUFFMAN_CACHE_H */
@@ -37,17 +37,25 @@
 
 #include <libchula/libchula.h>
 
+#include <libhpack/atom.h>
 #include <libhpack/bitmap_set.h>
+#include <libhpack/decode_service.h>
+#include <libhpack/header_dict.h>
 #include <libhpack/header_field.h>
 #include <libhpack/header_parser.h>
 #include <libhpack/header_store.h>
 #include <libhpack/header_table.h>
 #include <libhpack/header_encoder.h>
 #include <libhpack/huffman.h>
+#include <libhpack/huffman_cache.h>
 #include <libhpack/huffman_tables.h>
 #include <libhpack/integer.h>
 #include <libhpack/libhpack.h>
 #include <libhpack/macros.h>
+#include <libhpack/pressure.h>
+#include <libhpack/sensitive.h>
+#include <libhpack/stats.h>
+#include <libhpack/validate.h>
 #include <libhpack/hpack-ret.h>
 
 #undef HPACK_H_INSIDE
@@ -47,6 +47,13 @@
 
 #define HPACK_NEW_OBJ(klass,...)   CHULA_GEN_NEW_OBJ(hpack,klass,##__VA_ARGS__)
 
+/* Hint that some memory is about to be read */
+#if defined(__GNUC__)
+# define HPACK_PREFETCH(p)         __builtin_prefetch(p)
+#else
+# define HPACK_PREFETCH(p)         do {} while (0)
+#endif
+
 #define SETTINGS_HEADER_TABLE_SIZE       4096
 
 /* By doing this we can optimize the circular buffer calculations of
@@ -57,4 +64,13 @@
 #define HPACK_CB_HEADER_DATA_SIZE        SETTINGS_HEADER_TABLE_SIZE
 #define HPACK_CB_HEADER_DATA_MASK       (HPACK_CB_HEADER_DATA_SIZE -1)
 
+/* Snapshots of compression contexts
+ */
+#define HPACK_SNAPSHOT_MAGIC            "HPCK"
+#define HPACK_SNAPSHOT_MAGIC_LEN         4
+#define HPACK_SNAPSHOT_VERSION           2  /* 2: encoding contexts */
+#define HPACK_SNAPSHOT_FINISHED          1  /* Flags */
+#define HPACK_SNAPSHOT_ENCODER          (1 << 1)
+#define HPACK_SNAPSHOT_RESIZE           (1 << 2)
+
 #endif /* HPACK_MACROS_H */
@@ -0,0 +1,287 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file      pressure.c
+ * @brief     Header Table sizes under memory pressure.
+ *
+ * The watermarks leave a gap between shrinking and growing back, so memory
+ * hovering around one of them does not resize the tables over and over.
+ *
+ * @date      October, 2026
+ */
+
+#include "pressure.h"
+#include "macros.h"
+
+typedef hpack_pressure_entry_t entry_t;
+
+
+/** Size an encoder will have once the scheduled changes are emitted.
+ */
+static uint16_t
+encoder_size (hpack_header_encoder_t *enc)
+{
+    return enc->resize ? enc->resize_to : enc->table.max_data;
+}
+
+static ret_t
+entry_shrink (hpack_pressure_t *pressure,
+              entry_t          *e)
+{
+    if (e->enc != NULL) {
+        e->size = encoder_size (e->enc);
+
+        /* Already small enough */
+        if (e->size <= pressure->size)
+            return ret_ok;
+
+        return hpack_header_encoder_set_table_size (e->enc, pressure->size);
+    }
+
+    e->func (e->parser, pressure->size, e->data);
+    return ret_ok;
+}
+
+static ret_t
+entry_grow (entry_t *e)
+{
+    if (e->enc != NULL) {
+        /* Changed while under pressure */
+        if (encoder_size (e->enc) >= e->size)
+            return ret_ok;
+
+        return hpack_header_encoder_set_table_size (e->enc, e->size);
+    }
+
+    e->func (e->parser, e->size, e->data);
+    return ret_ok;
+}
+
+static ret_t
+entry_add (hpack_pressure_t       *pressure,
+           hpack_header_encoder_t *enc,
+           hpack_header_parser_t  *parser,
+           hpack_pressure_func_t   func,
+           void                   *data)
+{
+    entry_t *e;
+
+    e = (entry_t *) malloc (sizeof(entry_t));
+    if (unlikely (e == NULL))
+        return ret_nomem;
+
+    e->enc    = enc;
+    e->parser = parser;
+    e->func   = func;
+    e->data   = data;
+    e->size   = SETTINGS_HEADER_TABLE_SIZE;
+
+    chula_list_add (&e->entry, &pressure->entries);
+
+    /* It joins a process already under pressure */
+    if (pressure->shrunk) {
+        return entry_shrink (pressure, e);
+    }
+
+    return ret_ok;
+}
+
+static ret_t
+entry_remove (hpack_pressure_t *pressure,
+              void             *obj)
+{
+    entry_t *e;
+
+    list_for_each_entry (e, &pressure->entries, entry) {
+        if ((e->enc == obj) || (e->parser == obj)) {
+            chula_list_del (&e->entry);
+            free (e);
+            return ret_ok;
+        }
+    }
+
+    return ret_not_found;
+}
+
+
+ret_t
+hpack_pressure_init (hpack_pressure_t *pressure)
+{
+    INIT_LIST_HEAD (&pressure->entries);
+
+    pressure->high    = 0;
+    pressure->low     = 0;
+    pressure->size    = 0;
+    pressure->shrunk  = false;
+    pressure->shrinks = 0;
+
+    return ret_ok;
+}
+
+
+ret_t
+hpack_pressure_mrproper (hpack_pressure_t *pressure)
+{
+    chula_list_t *i, *tmp;
+
+    list_for_each_safe (i, tmp, &pressure->entries) {
+        chula_list_del (i);
+        free (list_entry (i, entry_t, entry));
+    }
+
+    return ret_ok;
+}
+
+HPACK_ADD_FUNC_NEW(pressure);
+HPACK_ADD_FUNC_FREE(pressure);
+
+
+/** Set the watermarks
+ *
+ * Nothing is resized until the watermarks are set.
+ *
+ * @param[in,out] pressure  Registry.
+ * @param[in]     high      Memory in use above which the tables are shrunk.
+ * @param[in]     low       Memory in use below which the tables grow back.
+ * @param[in]     size      Header Table size under pressure.
+ *
+ * @return Result of the operation.
+ * @retval ret_error  The low watermark is over the high one, or the size is
+ *                    greater than SETTINGS_HEADER_TABLE_SIZE.
+ * @retval ret_ok     Configured successfully.
+ */
+ret_t
+hpack_pressure_configure (hpack_pressure_t *pressure,
+                          uint64_t          high,
+                          uint64_t          low,
+                          uint16_t          size)
+{
+    if (unlikely ((low > high) || (size > SETTINGS_HEADER_TABLE_SIZE)))
+        return ret_error;
+
+    pressure->high = high;
+    pressure->low  = low;
+    pressure->size = size;
+
+    return ret_ok;
+}
+
+
+ret_t
+hpack_pressure_add_encoder (hpack_pressure_t       *pressure,
+                            hpack_header_encoder_t *enc)
+{
+    return entry_add (pressure, enc, NULL, NULL, NULL);
+}
+
+
+/** Register a decoder
+ *
+ * @param[in,out] pressure  Registry.
+ * @param[in]     parser    Decoder.
+ * @param[in]     func      Function called with the Header Table size the
+ *                          decoder should advertise to its peer.
+ * @param[in]     data      Argument for @a func.
+ *
+ * @return Result of the operation.
+ */
+ret_t
+hpack_pressure_add_decoder (hpack_pressure_t      *pressure,
+                            hpack_header_parser_t *parser,
+                            hpack_pressure_func_t  func,
+                            void                  *data)
+{
+    if (unlikely (func == NULL))
+        return ret_error;
+
+    return entry_add (pressure, NULL, parser, func, data);
+}
+
+
+ret_t
+hpack_pressure_remove_encoder (hpack_pressure_t       *pressure,
+                               hpack_header_encoder_t *enc)
+{
+    return entry_remove (pressure, enc);
+}
+
+
+ret_t
+hpack_pressure_remove_decoder (hpack_pressure_t      *pressure,
+                               hpack_header_parser_t *parser)
+{
+    return entry_remove (pressure, parser);
+}
+
+
+/** Report the memory in use
+ *
+ * Shrinks the Header Tables of all the registered encoders and decoders when
+ * @a in_use goes over the high watermark, and lets them grow back once it
+ * goes under the low one.
+ *
+ * @param[in,out] pressure  Registry.
+ * @param[in]     in_use    Memory in use, in whatever unit the watermarks are.
+ *
+ * @return Result of the operation.
+ */
+ret_t
+hpack_pressure_update (hpack_pressure_t *pressure,
+                       uint64_t          in_use)
+{
+    ret_t    ret;
+    entry_t *e;
+
+    if (pressure->high == 0)
+        return ret_ok;
+
+    if ((! pressure->shrunk) && (in_use > pressure->high)) {
+        pressure->shrunk   = true;
+        pressure->shrinks += 1;
+
+        list_for_each_entry (e, &pressure->entries, entry) {
+            ret = entry_shrink (pressure, e);
+            if (unlikely (ret != ret_ok)) return ret;
+        }
+    }
+    else if ((pressure->shrunk) && (in_use < pressure->low)) {
+        pressure->shrunk = false;
+
+        list_for_each_entry (e, &pressure->entries, entry) {
+            ret = entry_grow (e);
+            if (unlikely (ret != ret_ok)) return ret;
+        }
+    }
+
+    return ret_ok;
+}
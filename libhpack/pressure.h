@@ -0,0 +1,122 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file      pressure.h
+ * @brief     Header Table sizes under memory pressure.
+ *
+ * A registry of the encoders and decoders of a process. When the memory in
+ * use crosses a high watermark, the Header Tables of all of them are shrunk,
+ * and once it goes back under a low watermark they grow back to their
+ * previous size.
+ *
+ * Encoders resize their own table and emit the change at the start of their
+ * next Header Block. The table of a decoder belongs to the peer encoder, so
+ * decoders are told the size through a function: the application is expected
+ * to advertise it with SETTINGS_HEADER_TABLE_SIZE, and the peer to emit the
+ * size change.
+ *
+ * The registry is not thread safe. It is meant to be updated from the thread
+ * running the encoders and decoders registered in it.
+ *
+ * @date      October, 2026
+ */
+
+#ifndef LIBHPACK_PRESSURE_H
+#define LIBHPACK_PRESSURE_H
+
+#if !defined(HPACK_H_INSIDE) && !defined (HPACK_COMPILATION)
+# error "Only <libhpack/libhpack.h> can be included directly."
+#endif
+
+#include <libchula/libchula.h>
+#include <libhpack/header_encoder.h>
+#include <libhpack/header_parser.h>
+
+/**
+ * Function telling the application the Header Table size a decoder should
+ * advertise.
+ */
+typedef void (*hpack_pressure_func_t) (hpack_header_parser_t *parser,
+                                       uint16_t               size,
+                                       void                  *data);
+
+/**
+ * Registered encoder or decoder.
+ */
+typedef struct {
+    chula_list_t            entry;   /**< Entry in the registry list. */
+    hpack_header_encoder_t *enc;     /**< Encoder, or NULL. */
+    hpack_header_parser_t  *parser;  /**< Decoder, or NULL. */
+    hpack_pressure_func_t   func;    /**< Function for the decoder. */
+    void                   *data;    /**< Argument for @a func. */
+    uint16_t                size;    /**< Size to go back to when the pressure is gone. */
+} hpack_pressure_entry_t;
+
+/**
+ * Memory pressure registry.
+ */
+typedef struct {
+    chula_list_t entries;  /**< Registered encoders and decoders. */
+    uint64_t     high;     /**< Memory in use above which the tables are shrunk. */
+    uint64_t     low;      /**< Memory in use below which the tables grow back. */
+    uint16_t     size;     /**< Header Table size under pressure. */
+    bool         shrunk;   /**< Whether the tables are shrunk. */
+    uint32_t     shrinks;  /**< Times the tables were shrunk. */
+} hpack_pressure_t;
+
+
+ret_t hpack_pressure_new            (hpack_pressure_t **pressure);
+ret_t hpack_pressure_free           (hpack_pressure_t  *pressure);
+ret_t hpack_pressure_init           (hpack_pressure_t  *pressure);
+ret_t hpack_pressure_mrproper       (hpack_pressure_t  *pressure);
+
+ret_t hpack_pressure_configure      (hpack_pressure_t  *pressure,
+                                     uint64_t           high,
+                                     uint64_t           low,
+                                     uint16_t           size);
+
+ret_t hpack_pressure_add_encoder    (hpack_pressure_t       *pressure,
+                                     hpack_header_encoder_t *enc);
+ret_t hpack_pressure_add_decoder    (hpack_pressure_t       *pressure,
+                                     hpack_header_parser_t  *parser,
+                                     hpack_pressure_func_t   func,
+                                     void                   *data);
+ret_t hpack_pressure_remove_encoder (hpack_pressure_t       *pressure,
+                                     hpack_header_encoder_t *enc);
+ret_t hpack_pressure_remove_decoder (hpack_pressure_t       *pressure,
+                                     hpack_header_parser_t  *parser);
+
+ret_t hpack_pressure_update         (hpack_pressure_t  *pressure,
+                                     uint64_t           in_use);
+
+#endif /* LIBHPACK_PRESSURE_H */
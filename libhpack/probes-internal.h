@@ -0,0 +1,72 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file      probes-internal.h
+ * @brief     Static tracepoints (USDT).
+ *
+ * The probes are only compiled in when the library is configured with
+ * `-DENABLE_USDT=ON`. Otherwise they expand to nothing, so they have no
+ * cost at all. All of them belong to the `libhpack` provider:
+ *
+ * | Probe                | Arguments                                   |
+ * |----------------------|---------------------------------------------|
+ * | parser_block_start   | parser, octets available                    |
+ * | parser_block_end     | parser, ret_t, octets consumed              |
+ * | table_evict          | table, name + value length, entries left    |
+ * | table_resize         | table, previous max. size, new max. size    |
+ * | encoder_render_start | encoder                                     |
+ * | encoder_render_end   | encoder, ret_t, octets rendered             |
+ *
+ * See tools/bpftrace for some scripts using them.
+ *
+ * @date      October, 2026
+ */
+
+#ifndef LIBHPACK_PROBES_INTERNAL_H
+#define LIBHPACK_PROBES_INTERNAL_H
+
+#include "config.h"
+
+#ifdef HPACK_USDT
+# include <sys/sdt.h>
+# define HPACK_PROBE1(name,a1)       DTRACE_PROBE1(libhpack, name, a1)
+# define HPACK_PROBE2(name,a1,a2)    DTRACE_PROBE2(libhpack, name, a1, a2)
+# define HPACK_PROBE3(name,a1,a2,a3) DTRACE_PROBE3(libhpack, name, a1, a2, a3)
+#else
+/* The arguments are not evaluated, sizeof() just marks them as used. */
+# define HPACK_PROBE1(name,a1)       do { (void) sizeof(a1); } while (0)
+# define HPACK_PROBE2(name,a1,a2)    do { (void) sizeof(a1); (void) sizeof(a2); } while (0)
+# define HPACK_PROBE3(name,a1,a2,a3) do { (void) sizeof(a1); (void) sizeof(a2); (void) sizeof(a3); } while (0)
+#endif
+
+#endif /* LIBHPACK_PROBES_INTERNAL_H */
@@ -0,0 +1,182 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file      sensitive.c
+ * @brief     Sensitive Header Field names.
+ *
+ * Names are interned in an [atoms table](@ref hpack_atoms_t). Static Table
+ * names always have an atom, so those in the set are flagged in a bit mask,
+ * while any other name only gets one when it is added to the set. Checking a
+ * name costs a single hash lookup.
+ *
+ * @date      October, 2026
+ */
+
+#include "sensitive.h"
+#include "macros.h"
+
+
+/**
+ * @cond INTERNAL
+ * Default names, used when an encoder has no set. Names are told apart by
+ * their length first.
+ * @endcond
+ */
+static bool
+is_default (const chula_buffer_t *name)
+{
+    switch (name->len) {
+    case 6:
+        return (memcmp (name->buf, "cookie", 6) == 0);
+    case 10:
+        return (memcmp (name->buf, "set-cookie", 10) == 0);
+    case 13:
+        return (memcmp (name->buf, "authorization", 13) == 0);
+    case 19:
+        return (memcmp (name->buf, "proxy-authorization", 19) == 0);
+    default:
+        return false;
+    }
+}
+
+
+/** Initialize a set of sensitive names
+ *
+ * The set starts empty, see hpack_sensitive_add_defaults().
+ *
+ * @param[out] sensitive  Set to initialize.
+ *
+ * @return Result of the operation.
+ * @retval ret_nomem  Not enough memory.
+ * @retval ret_ok     Initialized successfully.
+ */
+ret_t
+hpack_sensitive_init (hpack_sensitive_t *sensitive)
+{
+    sensitive->static_names = 0;
+    return hpack_atoms_init (&sensitive->atoms);
+}
+
+
+ret_t
+hpack_sensitive_mrproper (hpack_sensitive_t *sensitive)
+{
+    sensitive->static_names = 0;
+    return hpack_atoms_mrproper (&sensitive->atoms);
+}
+
+HPACK_ADD_FUNC_NEW(sensitive);
+HPACK_ADD_FUNC_FREE(sensitive);
+
+
+/** Add a name to the set
+ *
+ * Names are compared as they are, so they must be lowercase like the ones
+ * sent on the wire.
+ *
+ * @param[in,out] sensitive  Set of sensitive names.
+ * @param[in]     name       Name to add.
+ *
+ * @return Result of the operation.
+ * @retval ret_nomem  Not enough memory.
+ * @retval ret_error  There are no atoms left.
+ * @retval ret_ok     The name is in the set.
+ */
+ret_t
+hpack_sensitive_add (hpack_sensitive_t *sensitive,
+                     chula_buffer_t    *name)
+{
+    ret_t    ret;
+    uint16_t atom;
+
+    ret = hpack_atoms_register (&sensitive->atoms, name, &atom);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    if (atom < HPACK_ATOM_USER) {
+        sensitive->static_names |= (1ULL << atom);
+    }
+
+    return ret_ok;
+}
+
+
+/** Add the default names to the set
+ *
+ * @param[in,out] sensitive  Set of sensitive names.
+ *
+ * @return Result of the operation.
+ */
+ret_t
+hpack_sensitive_add_defaults (hpack_sensitive_t *sensitive)
+{
+    sensitive->static_names |= (1ULL << hpack_static_authorization)       |
+                               (1ULL << hpack_static_proxy_authorization) |
+                               (1ULL << hpack_static_cookie)              |
+                               (1ULL << hpack_static_set_cookie);
+    return ret_ok;
+}
+
+
+/** Check whether a name is sensitive
+ *
+ * @param[in] sensitive  Set of sensitive names, or NULL for the default ones.
+ * @param[in] name       Name to check.
+ *
+ * @return Whether the name is in the set.
+ */
+bool
+hpack_sensitive_is (hpack_sensitive_t    *sensitive,
+                    const chula_buffer_t *name)
+{
+    ret_t    ret;
+    uint16_t atom;
+
+    if (sensitive == NULL)
+        return is_default (name);
+
+    /* Nothing to look up */
+    if ((sensitive->static_names == 0) &&
+        (sensitive->atoms.next == HPACK_ATOM_USER))
+    {
+        return false;
+    }
+
+    ret = hpack_atoms_lookup (&sensitive->atoms, (chula_buffer_t *) name, &atom);
+    if (ret != ret_ok)
+        return false;
+
+    if (atom >= HPACK_ATOM_USER)
+        return true;
+
+    return (sensitive->static_names & (1ULL << atom)) != 0;
+}
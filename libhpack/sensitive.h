@@ -0,0 +1,81 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file      sensitive.h
+ * @brief     Sensitive Header Field names.
+ *
+ * Values of sensitive Header Fields (credentials, session cookies) must not
+ * end up in a Header Table where an attacker able to inject headers could
+ * probe them through the compressed size of their requests. The encoder
+ * always emits them as Literal Header Fields never Indexed, which also tells
+ * intermediaries to forward them the same way.
+ *
+ * A set of sensitive names can be shared by many encoders, but names must not
+ * be added while it is in use. Encoders without a set use the default names:
+ * `authorization`, `proxy-authorization`, `cookie` and `set-cookie`.
+ *
+ * @date      October, 2026
+ */
+
+#ifndef LIBHPACK_SENSITIVE_H
+#define LIBHPACK_SENSITIVE_H
+
+#if !defined(HPACK_H_INSIDE) && !defined (HPACK_COMPILATION)
+# error "Only <libhpack/libhpack.h> can be included directly."
+#endif
+
+#include <libchula/libchula.h>
+#include <libhpack/atom.h>
+
+/**
+ * Set of sensitive Header Field names.
+ */
+typedef struct {
+    hpack_atoms_t atoms;         /**< Interned names: the Static Table ones and those in the set. */
+    uint64_t      static_names;  /**< Static Table names in the set, one bit per atom. */
+} hpack_sensitive_t;
+
+
+ret_t hpack_sensitive_new          (hpack_sensitive_t **sensitive);
+ret_t hpack_sensitive_free         (hpack_sensitive_t  *sensitive);
+ret_t hpack_sensitive_init         (hpack_sensitive_t  *sensitive);
+ret_t hpack_sensitive_mrproper     (hpack_sensitive_t  *sensitive);
+
+ret_t hpack_sensitive_add          (hpack_sensitive_t  *sensitive,
+                                    chula_buffer_t     *name);
+ret_t hpack_sensitive_add_defaults (hpack_sensitive_t  *sensitive);
+
+bool  hpack_sensitive_is           (hpack_sensitive_t    *sensitive,
+                                    const chula_buffer_t *name);
+
+#endif /* LIBHPACK_SENSITIVE_H */
@@ -0,0 +1,149 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file      stats.c
+ * @brief     Compression statistics.
+ *
+ * @date      October, 2026
+ */
+
+#include "stats.h"
+#include "macros.h"
+
+
+/** Statistics initializer
+ *
+ * @param[out] stats  Statistics to initialize.
+ *
+ * @return Result of the initialization.
+ * @retval ret_ok  Currently this is the only possible result.
+ */
+ret_t
+hpack_stats_init (hpack_stats_t *stats)
+{
+    memset (stats, 0, sizeof(hpack_stats_t));
+    return ret_ok;
+}
+
+
+ret_t
+hpack_stats_mrproper (hpack_stats_t *stats)
+{
+    UNUSED (stats);
+    return ret_ok;
+}
+
+HPACK_ADD_FUNC_NEW(stats);
+HPACK_ADD_FUNC_FREE(stats);
+
+
+/** Set all the counters back to zero
+ *
+ * @param[out] stats  Statistics to reset.
+ *
+ * @return Result of the operation.
+ * @retval ret_ok  Currently this is the only possible result.
+ */
+ret_t
+hpack_stats_reset (hpack_stats_t *stats)
+{
+    return hpack_stats_init (stats);
+}
+
+
+/** Accumulate statistics
+ *
+ * Adds the counters of @a other to @a stats, for instance to aggregate
+ * per-connection statistics.
+ *
+ * @param[in,out] stats  Statistics to add to.
+ * @param[in]     other  Statistics to add.
+ *
+ * @return Result of the operation.
+ * @retval ret_ok  Currently this is the only possible result.
+ */
+ret_t
+hpack_stats_add (hpack_stats_t *stats,
+                 hpack_stats_t *other)
+{
+    for (int i=0; i <= rep_never_indx; i++) {
+        stats->reps[i] += other->reps[i];
+    }
+
+    stats->fields          += other->fields;
+    stats->strings_huffman += other->strings_huffman;
+    stats->strings_raw     += other->strings_raw;
+    stats->wire_len        += other->wire_len;
+    stats->decoded_len     += other->decoded_len;
+    stats->evictions       += other->evictions;
+    stats->size_updates    += other->size_updates;
+
+    return ret_ok;
+}
+
+
+/** Human readable representation of the statistics
+ *
+ * @param[in]  stats   Statistics to represent.
+ * @param[out] output  Buffer to append the representation to.
+ *
+ * @return Result of the operation.
+ * @retval ret_ok     The representation was appended.
+ * @retval ret_nomem  Not enough memory to grow @a output.
+ */
+ret_t
+hpack_stats_repr (hpack_stats_t  *stats,
+                  chula_buffer_t *output)
+{
+    ret_t ret;
+
+    ret = chula_buffer_add_va (output,
+                               "fields=%llu indexed=%llu inc_indexed=%llu wo_indexing=%llu never_indexed=%llu\n"
+                               "strings: huffman=%llu raw=%llu\n"
+                               "octets: wire=%llu decoded=%llu\n"
+                               "table: evictions=%llu size_updates=%llu\n",
+                               (unsigned long long) stats->fields,
+                               (unsigned long long) stats->reps[rep_indexed],
+                               (unsigned long long) stats->reps[rep_inc_indexed],
+                               (unsigned long long) stats->reps[rep_wo_indexing],
+                               (unsigned long long) stats->reps[rep_never_indx],
+                               (unsigned long long) stats->strings_huffman,
+                               (unsigned long long) stats->strings_raw,
+                               (unsigned long long) stats->wire_len,
+                               (unsigned long long) stats->decoded_len,
+                               (unsigned long long) stats->evictions,
+                               (unsigned long long) stats->size_updates);
+    if (unlikely (ret != ret_ok)) return ret_nomem;
+
+    return ret_ok;
+}
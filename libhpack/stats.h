@@ -0,0 +1,83 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file      stats.h
+ * @brief     Compression statistics.
+ *
+ * A statistics object can be registered in any number of
+ * [Header Parsers](@ref hpack_header_parser_t) and
+ * [Header Encoders](@ref hpack_header_encoder_t). They update it as they go
+ * with a handful of additions per Header Field, so it is cheap enough to be
+ * left on in production. Sharing one object among the parsers of a thread
+ * aggregates them; using one per connection keeps them apart.
+ *
+ * @date      October, 2026
+ */
+
+#ifndef LIBHPACK_STATS_H
+#define LIBHPACK_STATS_H
+
+#if !defined(HPACK_H_INSIDE) && !defined (HPACK_COMPILATION)
+# error "Only <libhpack/libhpack.h> can be included directly."
+#endif
+
+#include <libchula/libchula.h>
+#include <libhpack/header_field.h>
+
+/**
+ * Compression statistics.
+ */
+typedef struct {
+    uint64_t reps[rep_never_indx + 1]; /**< Representations, by [type](@ref hpack_header_field_representation_t). */
+    uint64_t fields;                   /**< Header Fields emitted or rendered. */
+    uint64_t strings_huffman;          /**< Huffman encoded literal strings. */
+    uint64_t strings_raw;              /**< Literal strings without encoding. */
+    uint64_t wire_len;                 /**< Octets of Header Blocks. */
+    uint64_t decoded_len;              /**< Octets of the names and values of the Header Fields. */
+    uint64_t evictions;                /**< Header Table entries evicted. */
+    uint64_t size_updates;             /**< Maximum Header Table Size updates. */
+} hpack_stats_t;
+
+
+ret_t hpack_stats_new      (hpack_stats_t **stats);
+ret_t hpack_stats_free     (hpack_stats_t  *stats);
+ret_t hpack_stats_init     (hpack_stats_t  *stats);
+ret_t hpack_stats_mrproper (hpack_stats_t  *stats);
+ret_t hpack_stats_reset    (hpack_stats_t  *stats);
+
+ret_t hpack_stats_add      (hpack_stats_t  *stats,
+                            hpack_stats_t  *other);
+ret_t hpack_stats_repr     (hpack_stats_t  *stats,
+                            chula_buffer_t *output);
+
+#endif /* LIBHPACK_STATS_H */
@@ -0,0 +1,450 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file      validate.c
+ * @brief     Validation of Header Field names and values.
+ *
+ * Every kernel walks the string once, optionally copying it to a destination
+ * at the same time. The vector kernels only recognize the common octets of
+ * each class (`[a-z0-9-]` in names, anything but NUL, CR and LF in values);
+ * blocks with any other octet are rechecked with the scalar table.
+ *
+ * @date      October, 2026
+ */
+
+#include "config.h"
+#include "validate.h"
+
+#if defined(HAVE_EMMINTRIN_H) && defined(__SSE2__)
+# include <emmintrin.h>
+# define VALIDATE_SSE2
+#endif
+
+#if defined(HAVE_IMMINTRIN_H) && defined(HAVE_AVX2_TARGET)
+# include <immintrin.h>
+# define VALIDATE_AVX2
+#endif
+
+
+/** Validation kernel: checks @a len octets of @a src, and copies them to @a dst
+ *  if it is not NULL. Returns false if any of them is not allowed.
+ */
+typedef bool (*kernel_func_t) (uint8_t *dst, const uint8_t *src, uint32_t len);
+
+/** Allowed octets in Header Field names: lowercase RFC 7230 tchar. */
+static const uint8_t name_chars[256] = {
+    ['0' ... '9'] = 1,
+    ['a' ... 'z'] = 1,
+    ['!'] = 1, ['#'] = 1, ['$'] = 1, ['%'] = 1, ['&'] = 1, ['\''] = 1,
+    ['*'] = 1, ['+'] = 1, ['-'] = 1, ['.'] = 1, ['^'] = 1, ['_'] = 1,
+    ['`'] = 1, ['|'] = 1, ['~'] = 1,
+};
+
+
+/* Scalar kernels
+ */
+static bool
+name_scalar (uint8_t *dst, const uint8_t *src, uint32_t len)
+{
+    uint8_t bad = 0;
+
+    for (uint32_t i=0; i < len; i++) {
+        bad |= name_chars[src[i]] ^ 1;
+        if (dst) dst[i] = src[i];
+    }
+
+    return (bad == 0);
+}
+
+static bool
+value_scalar (uint8_t *dst, const uint8_t *src, uint32_t len)
+{
+    bool bad = false;
+
+    for (uint32_t i=0; i < len; i++) {
+        bad |= ((src[i] == '\0') | (src[i] == '\r') | (src[i] == '\n'));
+        if (dst) dst[i] = src[i];
+    }
+
+    return (! bad);
+}
+
+
+/* SSE2 kernels
+ */
+#ifdef VALIDATE_SSE2
+static bool
+name_sse2 (uint8_t *dst, const uint8_t *src, uint32_t len)
+{
+    uint32_t      i;
+    const __m128i lo_alpha = _mm_set1_epi8 ('a' - 1);
+    const __m128i hi_alpha = _mm_set1_epi8 ('z' + 1);
+    const __m128i lo_digit = _mm_set1_epi8 ('0' - 1);
+    const __m128i hi_digit = _mm_set1_epi8 ('9' + 1);
+    const __m128i dash     = _mm_set1_epi8 ('-');
+
+    /* Signed comparisons: octets over 0x7F are negative, so they
+     * never fall in any of the ranges.
+     */
+    for (i=0; i + 16 <= len; i += 16) {
+        __m128i v     = _mm_loadu_si128 ((const __m128i *)(src + i));
+        __m128i alpha = _mm_and_si128 (_mm_cmpgt_epi8 (v, lo_alpha), _mm_cmplt_epi8 (v, hi_alpha));
+        __m128i digit = _mm_and_si128 (_mm_cmpgt_epi8 (v, lo_digit), _mm_cmplt_epi8 (v, hi_digit));
+        __m128i ok    = _mm_or_si128 (_mm_or_si128 (alpha, digit), _mm_cmpeq_epi8 (v, dash));
+
+        if (dst) _mm_storeu_si128 ((__m128i *)(dst + i), v);
+
+        if (unlikely (_mm_movemask_epi8 (ok) != 0xFFFF)) {
+            if (! name_scalar (NULL, src + i, 16))
+                return false;
+        }
+    }
+
+    return name_scalar (dst ? dst + i : NULL, src + i, len - i);
+}
+
+static bool
+value_sse2 (uint8_t *dst, const uint8_t *src, uint32_t len)
+{
+    uint32_t      i;
+    __m128i       bad = _mm_setzero_si128();
+    const __m128i nul = _mm_setzero_si128();
+    const __m128i cr  = _mm_set1_epi8 ('\r');
+    const __m128i lf  = _mm_set1_epi8 ('\n');
+
+    for (i=0; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128 ((const __m128i *)(src + i));
+
+        bad = _mm_or_si128 (bad, _mm_cmpeq_epi8 (v, nul));
+        bad = _mm_or_si128 (bad, _mm_cmpeq_epi8 (v, cr));
+        bad = _mm_or_si128 (bad, _mm_cmpeq_epi8 (v, lf));
+
+        if (dst) _mm_storeu_si128 ((__m128i *)(dst + i), v);
+    }
+
+    if (_mm_movemask_epi8 (bad) != 0)
+        return false;
+
+    return value_scalar (dst ? dst + i : NULL, src + i, len - i);
+}
+#endif /* VALIDATE_SSE2 */
+
+
+/* AVX2 kernels
+ */
+#ifdef VALIDATE_AVX2
+__attribute__((target("avx2")))
+static bool
+name_avx2 (uint8_t *dst, const uint8_t *src, uint32_t len)
+{
+    uint32_t      i;
+    const __m256i lo_alpha = _mm256_set1_epi8 ('a' - 1);
+    const __m256i hi_alpha = _mm256_set1_epi8 ('z' + 1);
+    const __m256i lo_digit = _mm256_set1_epi8 ('0' - 1);
+    const __m256i hi_digit = _mm256_set1_epi8 ('9' + 1);
+    const __m256i dash     = _mm256_set1_epi8 ('-');
+
+    for (i=0; i + 32 <= len; i += 32) {
+        __m256i v     = _mm256_loadu_si256 ((const __m256i *)(src + i));
+        __m256i alpha = _mm256_and_si256 (_mm256_cmpgt_epi8 (v, lo_alpha), _mm256_cmpgt_epi8 (hi_alpha, v));
+        __m256i digit = _mm256_and_si256 (_mm256_cmpgt_epi8 (v, lo_digit), _mm256_cmpgt_epi8 (hi_digit, v));
+        __m256i ok    = _mm256_or_si256 (_mm256_or_si256 (alpha, digit), _mm256_cmpeq_epi8 (v, dash));
+
+        if (dst) _mm256_storeu_si256 ((__m256i *)(dst + i), v);
+
+        if (unlikely ((uint32_t) _mm256_movemask_epi8 (ok) != 0xFFFFFFFF)) {
+            if (! name_scalar (NULL, src + i, 32))
+                return false;
+        }
+    }
+
+    return name_scalar (dst ? dst + i : NULL, src + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static bool
+value_avx2 (uint8_t *dst, const uint8_t *src, uint32_t len)
+{
+    uint32_t      i;
+    __m256i       bad = _mm256_setzero_si256();
+    const __m256i nul = _mm256_setzero_si256();
+    const __m256i cr  = _mm256_set1_epi8 ('\r');
+    const __m256i lf  = _mm256_set1_epi8 ('\n');
+
+    for (i=0; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256 ((const __m256i *)(src + i));
+
+        bad = _mm256_or_si256 (bad, _mm256_cmpeq_epi8 (v, nul));
+        bad = _mm256_or_si256 (bad, _mm256_cmpeq_epi8 (v, cr));
+        bad = _mm256_or_si256 (bad, _mm256_cmpeq_epi8 (v, lf));
+
+        if (dst) _mm256_storeu_si256 ((__m256i *)(dst + i), v);
+    }
+
+    if (_mm256_movemask_epi8 (bad) != 0)
+        return false;
+
+    return value_scalar (dst ? dst + i : NULL, src + i, len - i);
+}
+#endif /* VALIDATE_AVX2 */
+
+
+/* Run-time dispatch
+ */
+static bool name_auto  (uint8_t *dst, const uint8_t *src, uint32_t len);
+static bool value_auto (uint8_t *dst, const uint8_t *src, uint32_t len);
+
+/* Resolved by the first validation, from whichever thread does it: always
+ * accessed atomically. Threads resolving them at the same time store the
+ * same kernels.
+ */
+static kernel_func_t         name_kernel  = name_auto;
+static kernel_func_t         value_kernel = value_auto;
+static hpack_validate_impl_t kernel_impl  = hpack_validate_impl_auto;
+
+#define kernel_get(k)    __atomic_load_n (&(k), __ATOMIC_ACQUIRE)
+#define kernel_set(k,v)  __atomic_store_n (&(k), (v), __ATOMIC_RELEASE)
+
+static bool
+name_auto (uint8_t *dst, const uint8_t *src, uint32_t len)
+{
+    hpack_validate_set_impl (hpack_validate_impl_auto);
+    return kernel_get (name_kernel) (dst, src, len);
+}
+
+static bool
+value_auto (uint8_t *dst, const uint8_t *src, uint32_t len)
+{
+    hpack_validate_set_impl (hpack_validate_impl_auto);
+    return kernel_get (value_kernel) (dst, src, len);
+}
+
+
+/** Select the validation kernels
+ *
+ * By default the fastest kernels supported by the CPU are picked the first
+ * time a string is validated. This function is mostly useful for testing and
+ * benchmarking each one of them.
+ *
+ * The kernels are shared by every parser of the process: do not call it while
+ * Header Blocks are being decoded by other threads.
+ *
+ * @param[in] impl  Kernels to use.
+ *
+ * @return Result of the operation.
+ * @retval ret_not_found  The kernels are not supported by the build or the CPU.
+ * @retval ret_ok         The kernels are in use.
+ */
+ret_t
+hpack_validate_set_impl (hpack_validate_impl_t impl)
+{
+    if (impl == hpack_validate_impl_auto) {
+#ifdef VALIDATE_AVX2
+        if (hpack_validate_set_impl (hpack_validate_impl_avx2) == ret_ok)
+            return ret_ok;
+#endif
+#ifdef VALIDATE_SSE2
+        if (hpack_validate_set_impl (hpack_validate_impl_sse2) == ret_ok)
+            return ret_ok;
+#endif
+        return hpack_validate_set_impl (hpack_validate_impl_scalar);
+    }
+
+    switch (impl) {
+    case hpack_validate_impl_scalar:
+        kernel_set (name_kernel,  name_scalar);
+        kernel_set (value_kernel, value_scalar);
+        break;
+#ifdef VALIDATE_SSE2
+    case hpack_validate_impl_sse2:
+        kernel_set (name_kernel,  name_sse2);
+        kernel_set (value_kernel, value_sse2);
+        break;
+#endif
+#ifdef VALIDATE_AVX2
+    case hpack_validate_impl_avx2:
+        if (! __builtin_cpu_supports ("avx2"))
+            return ret_not_found;
+        kernel_set (name_kernel,  name_avx2);
+        kernel_set (value_kernel, value_avx2);
+        break;
+#endif
+    default:
+        return ret_not_found;
+    }
+
+    kernel_set (kernel_impl, impl);
+    return ret_ok;
+}
+
+
+/** Kernels in use
+ *
+ * @return The kernels used to validate strings. They are resolved if they
+ * haven't been picked yet.
+ */
+hpack_validate_impl_t
+hpack_validate_get_impl (void)
+{
+    if (kernel_get (kernel_impl) == hpack_validate_impl_auto)
+        hpack_validate_set_impl (hpack_validate_impl_auto);
+
+    return kernel_get (kernel_impl);
+}
+
+
+/**
+ * @cond INTERNAL
+ * Checks, and optionally copies, a name. A leading colon is only
+ * allowed when it is followed by a token (pseudo-header).
+ * @endcond
+ */
+static bool
+check_name (uint8_t *dst, const uint8_t *str, uint32_t len)
+{
+    if (unlikely (len == 0))
+        return false;
+
+    if (str[0] == ':') {
+        if (unlikely (len == 1))
+            return false;
+
+        if (dst) *dst++ = ':';
+        str++;
+        len--;
+    }
+
+    return kernel_get (name_kernel) (dst, str, len);
+}
+
+
+/** Validate a Header Field name
+ *
+ * @param[in] str  Name to check.
+ * @param[in] len  Length of the name.
+ *
+ * @return Result of the validation.
+ * @retval ret_deny  The name is empty or it contains forbidden octets.
+ * @retval ret_ok    The name is valid.
+ */
+ret_t
+hpack_validate_name (const uint8_t *str, uint32_t len)
+{
+    return check_name (NULL, str, len) ? ret_ok : ret_deny;
+}
+
+
+/** Validate a Header Field value
+ *
+ * @param[in] str  Value to check.
+ * @param[in] len  Length of the value.
+ *
+ * @return Result of the validation.
+ * @retval ret_deny  The value contains NUL, CR or LF.
+ * @retval ret_ok    The value is valid.
+ */
+ret_t
+hpack_validate_value (const uint8_t *str, uint32_t len)
+{
+    return kernel_get (value_kernel) (NULL, str, len) ? ret_ok : ret_deny;
+}
+
+
+/** Append and validate a Header Field name
+ *
+ * Appends @a str to @a buf while it is checked. If it turns out to be
+ * invalid, the length of @a buf is not modified.
+ *
+ * @param[out] buf  Buffer to append the name to.
+ * @param[in]  str  Name to check.
+ * @param[in]  len  Length of the name.
+ *
+ * @return Result of the operation.
+ * @retval ret_nomem  Not enough memory to grow @a buf.
+ * @retval ret_deny   The name is not valid.
+ * @retval ret_ok     The name was appended.
+ */
+ret_t
+hpack_validate_copy_name (chula_buffer_t *buf,
+                          const uint8_t  *str,
+                          uint32_t        len)
+{
+    ret_t ret;
+
+    ret = chula_buffer_ensure_addlen (buf, len);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    if (unlikely (! check_name (buf->buf + buf->len, str, len))) {
+        buf->buf[buf->len] = '\0';
+        return ret_deny;
+    }
+
+    buf->len += len;
+    buf->buf[buf->len] = '\0';
+    return ret_ok;
+}
+
+
+/** Append and validate a Header Field value
+ *
+ * Appends @a str to @a buf while it is checked. If it turns out to be
+ * invalid, the length of @a buf is not modified.
+ *
+ * @param[out] buf  Buffer to append the value to.
+ * @param[in]  str  Value to check.
+ * @param[in]  len  Length of the value.
+ *
+ * @return Result of the operation.
+ * @retval ret_nomem  Not enough memory to grow @a buf.
+ * @retval ret_deny   The value is not valid.
+ * @retval ret_ok     The value was appended.
+ */
+ret_t
+hpack_validate_copy_value (chula_buffer_t *buf,
+                           const uint8_t  *str,
+                           uint32_t        len)
+{
+    ret_t ret;
+
+    ret = chula_buffer_ensure_addlen (buf, len);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    if (unlikely (! kernel_get (value_kernel) (buf->buf + buf->len, str, len))) {
+        buf->buf[buf->len] = '\0';
+        return ret_deny;
+    }
+
+    buf->len += len;
+    buf->buf[buf->len] = '\0';
+    return ret_ok;
+}
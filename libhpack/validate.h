@@ -0,0 +1,83 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file      validate.h
+ * @brief     Validation of Header Field names and values.
+ *
+ * Header Field names must be lowercase tokens (RFC 7230 tchar), optionally
+ * prefixed by a colon for pseudo-headers. Values must not contain NUL, CR or
+ * LF octets.
+ *
+ * The checks have SSE2 and AVX2 kernels, selected at run time, and a scalar
+ * fallback. The copy functions check the string in the same pass that
+ * appends it to the destination buffer.
+ *
+ * @date      October, 2026
+ */
+
+#ifndef LIBHPACK_VALIDATE_H
+#define LIBHPACK_VALIDATE_H
+
+#if !defined(HPACK_H_INSIDE) && !defined (HPACK_COMPILATION)
+# error "Only <libhpack/libhpack.h> can be included directly."
+#endif
+
+#include <libchula/libchula.h>
+
+/**
+ * Validation kernels.
+ */
+typedef enum {
+    hpack_validate_impl_auto = 0,  /**< Fastest kernel supported by the CPU. */
+    hpack_validate_impl_scalar,    /**< Portable fallback. */
+    hpack_validate_impl_sse2,      /**< 16 octets per step. */
+    hpack_validate_impl_avx2,      /**< 32 octets per step. */
+} hpack_validate_impl_t;
+
+
+ret_t hpack_validate_set_impl   (hpack_validate_impl_t  impl);
+hpack_validate_impl_t hpack_validate_get_impl (void);
+
+ret_t hpack_validate_name       (const uint8_t         *str,
+                                 uint32_t               len);
+ret_t hpack_validate_value      (const uint8_t         *str,
+                                 uint32_t               len);
+
+ret_t hpack_validate_copy_name  (chula_buffer_t        *buf,
+                                 const uint8_t         *str,
+                                 uint32_t               len);
+ret_t hpack_validate_copy_value (chula_buffer_t        *buf,
+                                 const uint8_t         *str,
+                                 uint32_t               len);
+
+#endif /* LIBHPACK_VALIDATE_H */
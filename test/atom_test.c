@@ -0,0 +1,195 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <libhpack/libhpack.h>
+#include <libchula-qa/libchula-qa.h>
+#include <libchula-qa/testing_macros-internal.h>
+
+
+START_TEST (static_names) {
+    ret_t          ret;
+    hpack_atoms_t  atoms;
+    uint16_t       atom;
+    chula_buffer_t name;
+
+    ret = hpack_atoms_init (&atoms);
+    ch_assert (ret == ret_ok);
+
+    /* Names repeated in the Static Table share the atom */
+    ch_assert (hpack_atoms_static (&atoms, hpack_static_status_404) == hpack_static_status_200);
+    ch_assert (hpack_atoms_static (&atoms, hpack_static_method_post) == hpack_static_method_get);
+    ch_assert (hpack_atoms_static (&atoms, hpack_static_cookie) == hpack_static_cookie);
+    ch_assert (hpack_atoms_static (&atoms, STATIC_ENTRIES + 1) == HPACK_ATOM_NONE);
+
+    chula_buffer_fake_str (&name, ":status");
+    ret = hpack_atoms_lookup (&atoms, &name, &atom);
+    ch_assert (ret == ret_ok);
+    ch_assert (atom == hpack_static_status_200);
+
+    chula_buffer_fake_str (&name, "www-authenticate");
+    ret = hpack_atoms_lookup (&atoms, &name, &atom);
+    ch_assert (ret == ret_ok);
+    ch_assert (atom == hpack_static_www_authenticate);
+
+    chula_buffer_fake_str (&name, "x-request-id");
+    ret = hpack_atoms_lookup (&atoms, &name, &atom);
+    ch_assert (ret == ret_not_found);
+    ch_assert (atom == HPACK_ATOM_NONE);
+
+    hpack_atoms_mrproper (&atoms);
+}
+END_TEST
+
+START_TEST (register_names) {
+    ret_t          ret;
+    hpack_atoms_t *atoms;
+    uint16_t       atom;
+    uint16_t       first;
+    chula_buffer_t name    = CHULA_BUF_INIT;
+    chula_buffer_t path;
+
+    ret = hpack_atoms_new (&atoms);
+    ch_assert (ret == ret_ok);
+
+    /* Known names keep their atom */
+    chula_buffer_add_str (&name, "user-agent");
+    ret = hpack_atoms_register (atoms, &name, &atom);
+    ch_assert (ret == ret_ok);
+    ch_assert (atom == hpack_static_user_agent);
+
+    /* Enough names to make the table grow */
+    for (int i=0; i<500; i++) {
+        chula_buffer_clean (&name);
+        chula_buffer_add_va (&name, "x-custom-%d", i);
+
+        ret = hpack_atoms_register (atoms, &name, &atom);
+        ch_assert (ret == ret_ok);
+        ch_assert (atom == HPACK_ATOM_USER + i);
+    }
+
+    chula_buffer_clean (&name);
+    chula_buffer_add_str (&name, "x-custom-0");
+    ret = hpack_atoms_register (atoms, &name, &first);
+    ch_assert (ret == ret_ok);
+    ch_assert (first == HPACK_ATOM_USER);
+
+    chula_buffer_clean (&name);
+    chula_buffer_add_str (&name, "x-custom-499");
+    ret = hpack_atoms_lookup (atoms, &name, &atom);
+    ch_assert (ret == ret_ok);
+    ch_assert (atom == HPACK_ATOM_USER + 499);
+
+    chula_buffer_fake_str (&path, ":path");
+    ret = hpack_atoms_lookup (atoms, &path, &atom);
+    ch_assert (ret == ret_ok);
+    ch_assert (atom == hpack_static_path_root);
+
+    hpack_atoms_free (atoms);
+    chula_buffer_mrproper (&name);
+}
+END_TEST
+
+START_TEST (parser) {
+    ret_t                  ret;
+    chula_buffer_t         raw;
+    chula_buffer_t         name;
+    hpack_header_parser_t *parser;
+    hpack_header_field_t   field;
+    hpack_atoms_t          atoms;
+    uint16_t               custom;
+    unsigned int           consumed = 0;
+    unsigned int           offset   = 0;
+
+    hpack_atoms_init (&atoms);
+    chula_buffer_fake_str (&name, "custom-key");
+    hpack_atoms_register (&atoms, &name, &custom);
+
+    hpack_header_parser_new (&parser);
+    hpack_header_parser_set_atoms (parser, &atoms);
+    hpack_header_field_init (&field);
+
+    /* :method: GET (indexed), :path: /sample/path (indexed name),
+     * custom-key: custom-header (literal)
+     */
+    chula_buffer_fake_str (&raw, "\x82\x05\x0c\x2f\x73\x61\x6d\x70\x6c\x65\x2f\x70\x61\x74\x68"
+                                 "\x40\x0a\x63\x75\x73\x74\x6f\x6d\x2d\x6b\x65\x79\x0d\x63\x75\x73\x74\x6f\x6d\x2d\x68\x65\x61\x64\x65\x72");
+
+    ret = hpack_header_parser_field (parser, &raw, offset, &field, &consumed);
+    ch_assert (ret == ret_ok);
+    ch_assert (field.atom == hpack_static_method_get);
+    offset += consumed;
+
+    ret = hpack_header_parser_field (parser, &raw, offset, &field, &consumed);
+    ch_assert (ret == ret_ok);
+    ch_assert_str_eq (field.name.buf, ":path");
+    ch_assert (field.atom == hpack_static_path_root);
+    offset += consumed;
+
+    ret = hpack_header_parser_field (parser, &raw, offset, &field, &consumed);
+    ch_assert (ret == ret_ok);
+    ch_assert_str_eq (field.name.buf, "custom-key");
+    ch_assert (field.atom == custom);
+    offset += consumed;
+
+    /* Without atoms fields are not tagged */
+    hpack_header_parser_set_atoms (parser, NULL);
+    chula_buffer_fake_str (&raw, "\x87");
+
+    ret = hpack_header_parser_field (parser, &raw, 0, &field, &consumed);
+    ch_assert (ret == ret_ok);
+    ch_assert (field.atom == HPACK_ATOM_NONE);
+
+    hpack_header_field_mrproper (&field);
+    hpack_header_parser_mrproper (&parser);
+    hpack_atoms_mrproper (&atoms);
+}
+END_TEST
+
+
+int
+atoms (void)
+{
+    Suite *s1 = suite_create("Atoms");
+    check_add (s1, static_names);
+    check_add (s1, register_names);
+    check_add (s1, parser);
+    run_test (s1);
+}
+
+int
+atom_tests (void)
+{
+    int ret;
+
+    ret = atoms();
+    return ret;
+}
@@ -0,0 +1,218 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <sched.h>
+
+#include <libhpack/libhpack.h>
+#include <libchula-qa/libchula-qa.h>
+#include <libchula-qa/testing_macros-internal.h>
+
+#define NUM_LANES  8
+#define NUM_BLOCKS 64
+
+typedef struct {
+    hpack_header_parser_t *parser;
+    hpack_header_store_t   store;
+    hpack_decode_lane_t    lane;
+    uint32_t               expected;
+    uint32_t               errors;
+    uint32_t              *done;
+} conn_t;
+
+
+START_TEST (init_mrproper) {
+    ret_t                  ret;
+    hpack_decode_service_t service;
+    hpack_decode_lane_t    lane[2];
+    hpack_header_parser_t *parser;
+
+    hpack_header_parser_new (&parser);
+
+    ret = hpack_decode_service_init (&service, 0, 1);
+    ch_assert (ret == ret_ok);
+    ch_assert (service.num_workers > 0);
+
+    ret = hpack_decode_service_add_lane (&service, &lane[0], parser);
+    ch_assert (ret == ret_ok);
+
+    /* Over max_lanes */
+    ret = hpack_decode_service_add_lane (&service, &lane[1], parser);
+    ch_assert (ret == ret_deny);
+
+    ret = hpack_decode_service_remove_lane (&service, &lane[0]);
+    ch_assert (ret == ret_ok);
+    ret = hpack_decode_service_add_lane (&service, &lane[1], parser);
+    ch_assert (ret == ret_ok);
+    hpack_decode_service_remove_lane (&service, &lane[1]);
+
+    ret = hpack_decode_service_mrproper (&service);
+    ch_assert (ret == ret_ok);
+    ch_assert (service.workers == NULL);
+
+    hpack_header_parser_mrproper (&parser);
+}
+END_TEST
+
+
+static void
+decoded (hpack_decode_job_t *job)
+{
+    ret_t                 ret;
+    char                  seq[16];
+    hpack_header_field_t *field;
+    conn_t               *conn = job->data;
+
+    /* Blocks decoded out of order break the decoding context */
+    snprintf (seq, sizeof(seq), "%u", conn->expected++);
+
+    ret = hpack_header_store_get_n (&conn->store, 1, &field);
+    if ((job->ret != ret_ok) ||
+        (job->consumed != job->block->len) ||
+        (ret != ret_ok) ||
+        (field->value.len != strlen(seq)) ||
+        (strncmp ((char *) field->value.buf, seq, field->value.len) != 0) ||
+        (hpack_header_store_get_n (&conn->store, 2, &field) != ret_not_found))
+    {
+        conn->errors++;
+    }
+
+    hpack_header_store_clean (&conn->store);
+    __atomic_add_fetch (conn->done, 1, __ATOMIC_RELEASE);
+}
+
+START_TEST (serialized) {
+    ret_t                   ret;
+    hpack_decode_service_t  service;
+    hpack_header_encoder_t  enc;
+    uint32_t                done = 0;
+    chula_buffer_t          name = CHULA_BUF_INIT_FAKE("x-seq");
+    chula_buffer_t          value = CHULA_BUF_INIT;
+    static conn_t           conns[NUM_LANES];
+    static chula_buffer_t   blocks[NUM_LANES][NUM_BLOCKS];
+    static hpack_decode_job_t jobs[NUM_LANES][NUM_BLOCKS];
+
+    ret = hpack_decode_service_init (&service, 4, NUM_LANES);
+    ch_assert (ret == ret_ok);
+
+    /* Each Header Block depends on the decoding context left by the
+     * previous one of the same connection.
+     */
+    for (int l=0; l < NUM_LANES; l++) {
+        conn_t *conn = &conns[l];
+
+        hpack_header_encoder_init (&enc);
+
+        for (int b=0; b < NUM_BLOCKS; b++) {
+            chula_buffer_clean (&value);
+            chula_buffer_add_va (&value, "%d", b);
+
+            hpack_header_encoder_clean (&enc);
+            hpack_header_encoder_add (&enc, &name, &value);
+
+            chula_buffer_init (&blocks[l][b]);
+            ret = hpack_header_encoder_render (&enc, &blocks[l][b]);
+            ch_assert (ret == ret_ok);
+
+            jobs[l][b].block = &blocks[l][b];
+            jobs[l][b].func  = decoded;
+            jobs[l][b].data  = conn;
+        }
+
+        hpack_header_encoder_mrproper (&enc);
+
+        conn->expected = 0;
+        conn->errors   = 0;
+        conn->done     = &done;
+        hpack_header_store_init (&conn->store);
+        hpack_header_parser_new (&conn->parser);
+        hpack_header_parser_reg_store (conn->parser, &conn->store);
+
+        ret = hpack_decode_service_add_lane (&service, &conn->lane, conn->parser);
+        ch_assert (ret == ret_ok);
+    }
+
+    /* Connections interleaved */
+    for (int b=0; b < NUM_BLOCKS; b++) {
+        for (int l=0; l < NUM_LANES; l++) {
+            ret = hpack_decode_service_submit (&service, &conns[l].lane, &jobs[l][b]);
+            ch_assert (ret == ret_ok);
+        }
+    }
+
+    while (__atomic_load_n (&done, __ATOMIC_ACQUIRE) < NUM_LANES * NUM_BLOCKS) {
+        sched_yield();
+    }
+
+    for (int l=0; l < NUM_LANES; l++) {
+        conn_t *conn = &conns[l];
+
+        ch_assert (conn->expected == NUM_BLOCKS);
+        ch_assert (conn->errors == 0);
+
+        /* The worker may not have released the lane yet */
+        while ((ret = hpack_decode_service_remove_lane (&service, &conn->lane)) == ret_eagain) {
+            sched_yield();
+        }
+        ch_assert (ret == ret_ok);
+
+        hpack_header_parser_mrproper (&conn->parser);
+        hpack_header_store_mrproper (&conn->store);
+
+        for (int b=0; b < NUM_BLOCKS; b++) {
+            chula_buffer_mrproper (&blocks[l][b]);
+        }
+    }
+
+    hpack_decode_service_mrproper (&service);
+    chula_buffer_mrproper (&value);
+}
+END_TEST
+
+
+int
+decode_service (void)
+{
+    Suite *s1 = suite_create("Decode service");
+    check_add (s1, init_mrproper);
+    check_add (s1, serialized);
+    run_test (s1);
+}
+
+int
+decode_service_tests (void)
+{
+    int ret;
+
+    ret = decode_service();
+    return ret;
+}
@@ -34,6 +34,8 @@
 #include <libchula-qa/libchula-qa.h>
 #include <libchula-qa/testing_macros-internal.h>
 
+extern chula_mem_mgr_t mem_mgr;
+
 
 START_TEST (init_mrproper) {
     ret_t                  ret;
@@ -62,6 +64,51 @@ START_TEST (add) {
 }
 END_TEST
 
+START_TEST (adopt) {
+    ret_t                  ret;
+    hpack_header_encoder_t enc;
+    hpack_header_field_t  *field;
+    hpack_header_field_t  *reused;
+    chula_buffer_t         name  = CHULA_BUF_INIT;
+    chula_buffer_t         value = CHULA_BUF_INIT;
+    chula_buffer_t         fake  = CHULA_BUF_INIT_FAKE("x-fake");
+    uint8_t               *mem;
+
+    hpack_header_encoder_init (&enc);
+
+    chula_buffer_add_str (&name,  "custom-key");
+    chula_buffer_add_str (&value, "custom-value");
+    mem = value.buf;
+
+    /* The buffers change hands */
+    ret = hpack_header_encoder_adopt (&enc, &name, &value);
+    ch_assert (ret == ret_ok);
+    ch_assert (name.len  == 0);
+    ch_assert (value.len == 0);
+
+    ret = hpack_header_store_get_n (&enc.store, 1, &field);
+    ch_assert (ret == ret_ok);
+    ch_assert (field->value.buf == mem);
+    ch_assert_str_eq (field->name.buf, "custom-key");
+
+    /* The entry and its buffers are reused once the encoder is cleaned */
+    hpack_header_encoder_clean (&enc);
+
+    ret = hpack_header_encoder_add (&enc, &fake, &fake);
+    ch_assert (ret == ret_ok);
+
+    ret = hpack_header_store_get_n (&enc.store, 1, &reused);
+    ch_assert (ret == ret_ok);
+    ch_assert (reused == field);
+    ch_assert (reused->value.buf == mem);
+    ch_assert_str_eq (reused->value.buf, "x-fake");
+
+    hpack_header_encoder_mrproper (&enc);
+    chula_buffer_mrproper (&name);
+    chula_buffer_mrproper (&value);
+}
+END_TEST
+
 START_TEST (encode1) {
     ret_t                  ret;
     hpack_header_encoder_t enc;
@@ -83,6 +130,786 @@ START_TEST (encode1) {
 }
 END_TEST
 
+START_TEST (clean) {
+    ret_t                  ret;
+    hpack_header_encoder_t enc;
+    chula_buffer_t         buf1  = CHULA_BUF_INIT;
+    chula_buffer_t         buf2  = CHULA_BUF_INIT;
+    chula_buffer_t         name  = CHULA_BUF_INIT_FAKE("name");
+    chula_buffer_t         value = CHULA_BUF_INIT_FAKE("value");
+
+    hpack_header_encoder_init (&enc);
+
+    /* Without indexing, same fields render the same Header Block */
+    hpack_header_encoder_set_policy (&enc, hpack_header_encoder_policy_never, NULL);
+
+    for (int i=0; i<2; i++) {
+        chula_buffer_t *buf = (i == 0) ? &buf1 : &buf2;
+
+        ret = hpack_header_encoder_add (&enc, &name, &value);
+        ch_assert (ret == ret_ok);
+
+        ret = hpack_header_encoder_render (&enc, buf);
+        ch_assert (ret == ret_ok);
+
+        ret = hpack_header_encoder_clean (&enc);
+        ch_assert (ret == ret_ok);
+    }
+
+    ch_assert (buf1.len == buf2.len);
+    ch_assert (memcmp (buf1.buf, buf2.buf, buf1.len) == 0);
+
+    hpack_header_encoder_mrproper (&enc);
+    chula_buffer_mrproper (&buf1);
+    chula_buffer_mrproper (&buf2);
+}
+END_TEST
+
+START_TEST (render_iov) {
+    ret_t                       ret;
+    unsigned int                consumed = 0;
+    hpack_header_encoder_t      enc;
+    hpack_header_encoder_iov_t  iov;
+    hpack_header_parser_t      *parser;
+    hpack_header_store_t        store;
+    hpack_header_field_t       *field;
+    chula_buffer_t              block    = CHULA_BUF_INIT;
+    chula_buffer_t              name     = CHULA_BUF_INIT_FAKE("name");
+    chula_buffer_t              value    = CHULA_BUF_INIT_FAKE("value");
+    chula_buffer_t              cookie   = CHULA_BUF_INIT_FAKE("cookie");
+    chula_buffer_t              crumbs   = CHULA_BUF_INIT_FAKE("a3fWa; expires=Wed, 21 Oct 2015 07:28:00 GMT");
+
+    hpack_header_encoder_init (&enc);
+    hpack_header_encoder_iov_init (&iov);
+
+    ret = hpack_header_encoder_add (&enc, &name, &value);
+    ch_assert (ret == ret_ok);
+    ret = hpack_header_encoder_add_ref (&enc, &cookie, &crumbs);
+    ch_assert (ret == ret_ok);
+    ret = hpack_header_encoder_add (&enc, &name, &value);
+    ch_assert (ret == ret_ok);
+
+    ret = hpack_header_encoder_render_iov (&enc, &iov);
+    ch_assert (ret == ret_ok);
+
+    /* Encoded, referenced and encoded again */
+    ch_assert (iov.len == 3);
+    ch_assert (iov.iov[1].iov_base == crumbs.buf);
+    ch_assert (iov.iov[1].iov_len  == crumbs.len);
+
+    for (unsigned int n=0; n < iov.len; n++) {
+        chula_buffer_add (&block, iov.iov[n].iov_base, iov.iov[n].iov_len);
+    }
+    ch_assert (block.len == iov.total);
+
+    /* It decodes to the same fields */
+    hpack_header_store_init (&store);
+    hpack_header_parser_new (&parser);
+    hpack_header_parser_reg_store (parser, &store);
+
+    ret = hpack_header_parser_all (parser, &block, 0, &consumed);
+    ch_assert (ret == ret_ok);
+    ch_assert (consumed == block.len);
+
+    ret = hpack_header_store_get_n (&store, 2, &field);
+    ch_assert (ret == ret_ok);
+    ch_assert (chula_buffer_cmp_buf (&field->name, &cookie) == 0);
+    ch_assert (chula_buffer_cmp_buf (&field->value, &crumbs) == 0);
+
+    hpack_header_parser_mrproper (&parser);
+    hpack_header_store_mrproper (&store);
+    hpack_header_encoder_iov_mrproper (&iov);
+    hpack_header_encoder_mrproper (&enc);
+    chula_buffer_mrproper (&block);
+}
+END_TEST
+
+START_TEST (render_frames) {
+    ret_t                          ret;
+    unsigned int                   consumed = 0;
+    hpack_header_encoder_t         enc[2];
+    hpack_header_encoder_frames_t  frames;
+    hpack_header_parser_t         *parser;
+    hpack_header_store_t           store;
+    hpack_header_field_t          *field;
+    chula_buffer_t                 payloads[16];
+    chula_buffer_t                 block    = CHULA_BUF_INIT;
+    chula_buffer_t                 retry    = CHULA_BUF_INIT;
+    chula_buffer_t                 joined   = CHULA_BUF_INIT;
+    chula_buffer_t                 name     = CHULA_BUF_INIT_FAKE("custom-key");
+    chula_buffer_t                 value    = CHULA_BUF_INIT_FAKE("custom-value");
+
+    hpack_header_store_init (&store);
+    hpack_header_parser_new (&parser);
+    hpack_header_parser_reg_store (parser, &store);
+
+    /* Two encoders with the same fields render the same Header Block */
+    for (int e=0; e<2; e++) {
+        hpack_header_encoder_init (&enc[e]);
+
+        for (int i=0; i<3; i++) {
+            ret = hpack_header_encoder_add (&enc[e], &name, &value);
+            ch_assert (ret == ret_ok);
+        }
+    }
+
+    ret = hpack_header_encoder_render (&enc[0], &block);
+    ch_assert (ret == ret_ok);
+
+    for (int i=0; i<16; i++) {
+        chula_buffer_init (&payloads[i]);
+    }
+
+    frames.payloads = payloads;
+    frames.max_len  = 7;
+
+    /* Not enough payloads: nothing is written */
+    frames.num = 1;
+
+    ret = hpack_header_encoder_render_frames (&enc[1], &frames);
+    ch_assert (ret == ret_deny);
+    ch_assert (payloads[0].len == 0);
+
+    /* The Header Block is kept for the retry */
+    ret = hpack_header_encoder_render (&enc[1], &retry);
+    ch_assert (ret == ret_ok);
+    ch_assert (chula_buffer_cmp_buf (&retry, &block) == 0);
+
+    ret = hpack_header_parser_all (parser, &retry, 0, &consumed);
+    ch_assert (ret == ret_ok);
+    ch_assert (consumed == retry.len);
+
+    for (uint32_t n=1; n <= 3; n++) {
+        ret = hpack_header_store_get_n (&store, n, &field);
+        ch_assert (ret == ret_ok);
+        ch_assert (chula_buffer_cmp_buf (&field->name, &name) == 0);
+        ch_assert (chula_buffer_cmp_buf (&field->value, &value) == 0);
+    }
+
+    /* Next Header Block: fields are split across payloads */
+    for (int e=0; e<2; e++) {
+        hpack_header_encoder_clean (&enc[e]);
+        hpack_header_encoder_add (&enc[e], &value, &name);
+        hpack_header_encoder_add (&enc[e], &name, &value);
+    }
+
+    chula_buffer_clean (&block);
+    ret = hpack_header_encoder_render (&enc[0], &block);
+    ch_assert (ret == ret_ok);
+
+    frames.num = 1;
+    ret = hpack_header_encoder_render_frames (&enc[1], &frames);
+    ch_assert (ret == ret_deny);
+
+    /* Retried with enough of them */
+    frames.num = 16;
+    ret = hpack_header_encoder_render_frames (&enc[1], &frames);
+    ch_assert (ret == ret_ok);
+    ch_assert (frames.used == (block.len + 6) / 7);
+
+    for (unsigned int i=0; i < frames.used; i++) {
+        ch_assert ((payloads[i].len == 7) || (i == frames.used - 1));
+        chula_buffer_add_buffer (&joined, &payloads[i]);
+    }
+
+    ch_assert (chula_buffer_cmp_buf (&joined, &block) == 0);
+
+    for (int i=0; i<16; i++) {
+        chula_buffer_mrproper (&payloads[i]);
+    }
+
+    hpack_header_parser_mrproper (&parser);
+    hpack_header_store_mrproper (&store);
+    hpack_header_encoder_mrproper (&enc[0]);
+    hpack_header_encoder_mrproper (&enc[1]);
+    chula_buffer_mrproper (&block);
+    chula_buffer_mrproper (&retry);
+    chula_buffer_mrproper (&joined);
+}
+END_TEST
+
+START_TEST (render_bounded) {
+    ret_t                  ret;
+    uint32_t               prev;
+    hpack_header_encoder_t enc[2];
+    chula_buffer_t         block[2];
+    chula_buffer_t         chunks = CHULA_BUF_INIT;
+    chula_buffer_t         name   = CHULA_BUF_INIT_FAKE("custom-key");
+    chula_buffer_t         value  = CHULA_BUF_INIT;
+
+    for (int e=0; e<2; e++) {
+        hpack_header_encoder_init (&enc[e]);
+        chula_buffer_init (&block[e]);
+    }
+
+    for (int i=0; i<20; i++) {
+        chula_buffer_add_char_n (&value, 'a' + i, i * 3);
+
+        for (int e=0; e<2; e++) {
+            ret = hpack_header_encoder_add (&enc[e], &name, &value);
+            ch_assert (ret == ret_ok);
+        }
+    }
+
+    /* Two Header Blocks, the second one indexes the first */
+    for (int b=0; b<2; b++) {
+        ret = hpack_header_encoder_render (&enc[0], &block[b]);
+        ch_assert (ret == ret_ok);
+    }
+
+    /* Five octets at a time */
+    do {
+        prev = chunks.len;
+
+        ret = hpack_header_encoder_render_bounded (&enc[1], &chunks, 5);
+        ch_assert (chunks.len - prev <= 5);
+    } while (ret == ret_eagain);
+
+    ch_assert (ret == ret_ok);
+    ch_assert (chula_buffer_cmp_buf (&chunks, &block[0]) == 0);
+
+    /* A large enough budget takes a single call */
+    chula_buffer_clean (&chunks);
+
+    ret = hpack_header_encoder_render_bounded (&enc[1], &chunks, block[1].len);
+    ch_assert (ret == ret_ok);
+    ch_assert (chula_buffer_cmp_buf (&chunks, &block[1]) == 0);
+
+    for (int e=0; e<2; e++) {
+        hpack_header_encoder_mrproper (&enc[e]);
+        chula_buffer_mrproper (&block[e]);
+    }
+
+    chula_buffer_mrproper (&chunks);
+    chula_buffer_mrproper (&value);
+}
+END_TEST
+
+START_TEST (sensitive) {
+    ret_t                  ret;
+    unsigned int           consumed = 0;
+    hpack_header_encoder_t enc;
+    hpack_header_parser_t *parser;
+    hpack_header_field_t   field;
+    hpack_sensitive_t      names;
+    chula_buffer_t         buf      = CHULA_BUF_INIT;
+    chula_buffer_t         auth     = CHULA_BUF_INIT_FAKE("authorization");
+    chula_buffer_t         secret   = CHULA_BUF_INIT_FAKE("Basic QWxhZGRpbjpvcGVuIHNlc2FtZQ==");
+    chula_buffer_t         key      = CHULA_BUF_INIT_FAKE("x-api-key");
+
+    hpack_header_encoder_init (&enc);
+    hpack_header_field_init (&field);
+    hpack_header_parser_new (&parser);
+
+    /* Default names: Literal never Indexed, Static Table name (23) */
+    hpack_header_encoder_add (&enc, &auth, &secret);
+
+    ret = hpack_header_encoder_render (&enc, &buf);
+    ch_assert (ret == ret_ok);
+    ch_assert ((uint8_t) buf.buf[0] == 0x1F);
+    ch_assert ((uint8_t) buf.buf[1] == 0x08);
+    ch_assert (enc.table.num_headers == 0);
+
+    ret = hpack_header_parser_field (parser, &buf, 0, &field, &consumed);
+    ch_assert (ret == ret_ok);
+    ch_assert (field.flags.rep == rep_never_indx);
+    ch_assert (chula_buffer_cmp_buf (&field.value, &secret) == 0);
+
+    /* A set of names replaces the default ones */
+    hpack_sensitive_init (&names);
+    ret = hpack_sensitive_add (&names, &key);
+    ch_assert (ret == ret_ok);
+
+    ch_assert (  hpack_sensitive_is (&names, &key));
+    ch_assert (! hpack_sensitive_is (&names, &auth));
+
+    hpack_header_encoder_clean (&enc);
+    hpack_header_encoder_set_sensitive (&enc, &names);
+    hpack_header_encoder_add (&enc, &key, &secret);
+    hpack_header_encoder_add (&enc, &auth, &secret);
+
+    chula_buffer_clean (&buf);
+    ret = hpack_header_encoder_render (&enc, &buf);
+    ch_assert (ret == ret_ok);
+    ch_assert ((uint8_t) buf.buf[0] == 0x10);
+    ch_assert (enc.table.num_headers == 1);
+
+    hpack_header_parser_mrproper (&parser);
+    hpack_header_field_mrproper (&field);
+    hpack_header_encoder_mrproper (&enc);
+    hpack_sensitive_mrproper (&names);
+    chula_buffer_mrproper (&buf);
+}
+END_TEST
+
+
+START_TEST (table_size) {
+    ret_t                  ret;
+    unsigned int           consumed;
+    hpack_header_encoder_t enc;
+    hpack_header_parser_t *parser;
+    hpack_header_store_t   store;
+    chula_buffer_t         buf      = CHULA_BUF_INIT;
+    chula_buffer_t         name     = CHULA_BUF_INIT_FAKE("custom-key");
+    chula_buffer_t         value    = CHULA_BUF_INIT_FAKE("custom-value");
+
+    hpack_header_encoder_init (&enc);
+    hpack_header_store_init (&store);
+    hpack_header_parser_new (&parser);
+    hpack_header_parser_reg_store (parser, &store);
+
+    ret = hpack_header_encoder_set_table_size (&enc, SETTINGS_HEADER_TABLE_SIZE + 1);
+    ch_assert (ret == ret_error);
+
+    for (int i=0; i<3; i++) {
+        /* Shrunk to nothing, and then back */
+        if (i > 0) {
+            ret = hpack_header_encoder_set_table_size (&enc, (i == 1) ? 0 : SETTINGS_HEADER_TABLE_SIZE);
+            ch_assert (ret == ret_ok);
+        }
+
+        hpack_header_encoder_clean (&enc);
+        hpack_header_encoder_add (&enc, &name, &value);
+
+        chula_buffer_clean (&buf);
+        ret = hpack_header_encoder_render (&enc, &buf);
+        ch_assert (ret == ret_ok);
+
+        consumed = 0;
+        ret = hpack_header_parser_all (parser, &buf, 0, &consumed);
+        ch_assert (ret == ret_ok);
+        ch_assert (consumed == buf.len);
+        ch_assert (parser->context.table.max_data == enc.table.max_data);
+        ch_assert (parser->context.table.num_headers == enc.table.num_headers);
+    }
+
+    /* Size changes go first */
+    ch_assert ((uint8_t) buf.buf[0] == 0x2F);
+    ch_assert (enc.table.max_data == SETTINGS_HEADER_TABLE_SIZE);
+    ch_assert (enc.table.num_headers == 1);
+
+    hpack_header_parser_mrproper (&parser);
+    hpack_header_store_mrproper (&store);
+    hpack_header_encoder_mrproper (&enc);
+    chula_buffer_mrproper (&buf);
+}
+END_TEST
+
+
+START_TEST (snapshot_restore) {
+    ret_t                  ret;
+    unsigned int           consumed;
+    hpack_header_encoder_t enc;
+    hpack_header_encoder_t migrated;
+    hpack_header_parser_t *parser;
+    hpack_header_parser_t *other;
+    hpack_header_store_t   store;
+    hpack_header_field_t  *field;
+    chula_buffer_t         block[2]  = {CHULA_BUF_INIT, CHULA_BUF_INIT};
+    chula_buffer_t         snapshot  = CHULA_BUF_INIT;
+    chula_buffer_t         psnapshot = CHULA_BUF_INIT;
+    chula_buffer_t         name      = CHULA_BUF_INIT_FAKE("custom-key");
+    chula_buffer_t         value     = CHULA_BUF_INIT_FAKE("custom-value");
+    chula_buffer_t         cc        = CHULA_BUF_INIT_FAKE("cache-control");
+    chula_buffer_t         no_cache  = CHULA_BUF_INIT_FAKE("no-cache");
+
+    hpack_header_encoder_init (&enc);
+    hpack_header_encoder_init (&migrated);
+    hpack_header_store_init (&store);
+    hpack_header_parser_new (&parser);
+    hpack_header_parser_new (&other);
+    hpack_header_parser_reg_store (parser, &store);
+
+    /* First Header Block, decoded by the peer */
+    hpack_header_encoder_add (&enc, &name, &value);
+    hpack_header_encoder_add (&enc, &cc, &no_cache);
+
+    ret = hpack_header_encoder_render (&enc, &block[0]);
+    ch_assert (ret == ret_ok);
+
+    consumed = 0;
+    ret = hpack_header_parser_all (parser, &block[0], 0, &consumed);
+    ch_assert (ret == ret_ok);
+
+    /* Move the context, with a size change still to be emitted */
+    hpack_header_encoder_set_table_size (&enc, 256);
+
+    ret = hpack_header_encoder_snapshot (&enc, &snapshot);
+    ch_assert (ret == ret_ok);
+
+    ret = hpack_header_encoder_restore (&migrated, &snapshot, 0, &consumed);
+    ch_assert (ret == ret_ok);
+    ch_assert (consumed == snapshot.len);
+    ch_assert (migrated.table.num_headers == enc.table.num_headers);
+    ch_assert (hpack_header_table_set_equals (migrated.reference_set, enc.reference_set));
+    ch_assert (migrated.resize);
+    ch_assert (migrated.resize_to == 256);
+
+    /* Both render the next Header Block the same way */
+    for (int i=0; i<2; i++) {
+        hpack_header_encoder_t *e = (i == 0) ? &enc : &migrated;
+
+        hpack_header_encoder_clean (e);
+        hpack_header_encoder_add (e, &name, &value);
+
+        chula_buffer_clean (&block[i]);
+        ret = hpack_header_encoder_render (e, &block[i]);
+        ch_assert (ret == ret_ok);
+    }
+
+    ch_assert (chula_buffer_cmp_buf (&block[0], &block[1]) == 0);
+
+    /* And the peer follows */
+    hpack_header_store_clean (&store);
+
+    consumed = 0;
+    ret = hpack_header_parser_all (parser, &block[1], 0, &consumed);
+    ch_assert (ret == ret_ok);
+    ch_assert (consumed == block[1].len);
+    ch_assert (parser->context.table.max_data == 256);
+
+    ret = hpack_header_store_get_n (&store, 1, &field);
+    ch_assert (ret == ret_ok);
+    ch_assert (chula_buffer_cmp_buf (&field->name, &name) == 0);
+    ch_assert (chula_buffer_cmp_buf (&field->value, &value) == 0);
+    ch_assert (hpack_header_store_get_n (&store, 2, &field) == ret_not_found);
+
+    /* Encoding and decoding contexts are not interchangeable */
+    ret = hpack_header_parser_restore (other, &snapshot, 0, &consumed);
+    ch_assert (ret == ret_error);
+
+    hpack_header_parser_snapshot (parser, &psnapshot);
+    ret = hpack_header_encoder_restore (&migrated, &psnapshot, 0, &consumed);
+    ch_assert (ret == ret_error);
+
+    hpack_header_parser_mrproper (&parser);
+    hpack_header_parser_mrproper (&other);
+    hpack_header_store_mrproper (&store);
+    hpack_header_encoder_mrproper (&enc);
+    hpack_header_encoder_mrproper (&migrated);
+    chula_buffer_mrproper (&block[0]);
+    chula_buffer_mrproper (&block[1]);
+    chula_buffer_mrproper (&snapshot);
+    chula_buffer_mrproper (&psnapshot);
+}
+END_TEST
+
+
+START_TEST (reorder) {
+    ret_t                  ret;
+    unsigned int           consumed = 0;
+    hpack_header_encoder_t enc;
+    hpack_header_parser_t *parser;
+    hpack_header_store_t   store;
+    hpack_header_field_t  *field;
+    chula_buffer_t         buf      = CHULA_BUF_INIT;
+    const char            *fields[][2] = {
+        {"x-new",      "1"},
+        {"set-cookie", "a"},
+        {":path",      "/"},
+        {"custom-key", "a"},
+        {"x-new",      "2"},
+        {"set-cookie", "b"},
+    };
+    const char            *expected[][2] = {
+        {":path",      "/"},
+        {"custom-key", "a"},
+        {"x-new",      "1"},
+        {"x-new",      "2"},
+        {"set-cookie", "a"},
+        {"set-cookie", "b"},
+    };
+
+    hpack_header_encoder_init (&enc);
+    hpack_header_encoder_set_reorder (&enc, true);
+    hpack_header_store_init (&store);
+    hpack_header_parser_new (&parser);
+    hpack_header_parser_reg_store (parser, &store);
+
+    /* custom-key: a goes into the Header Table */
+    for (int i=0; i<2; i++) {
+        int first = (i == 0) ? 3 : 0;
+        int last  = (i == 0) ? 4 : 6;
+
+        hpack_header_encoder_clean (&enc);
+        hpack_header_store_mrproper (&store);
+        hpack_header_store_init (&store);
+
+        for (int n=first; n < last; n++) {
+            chula_buffer_t name;
+            chula_buffer_t value;
+
+            chula_buffer_fake (&name,  fields[n][0], strlen (fields[n][0]));
+            chula_buffer_fake (&value, fields[n][1], strlen (fields[n][1]));
+            hpack_header_encoder_add (&enc, &name, &value);
+        }
+
+        chula_buffer_clean (&buf);
+        ret = hpack_header_encoder_render (&enc, &buf);
+        ch_assert (ret == ret_ok);
+
+        consumed = 0;
+        ret = hpack_header_parser_all (parser, &buf, 0, &consumed);
+        ch_assert (ret == ret_ok);
+        ch_assert (consumed == buf.len);
+    }
+
+    /* Pseudo-headers, then indexed, then grouped by name */
+    for (uint32_t n=0; n < 6; n++) {
+        ret = hpack_header_store_get_n (&store, n + 1, &field);
+        ch_assert (ret == ret_ok);
+        ch_assert_str_eq (field->name.buf, expected[n][0]);
+        ch_assert_str_eq (field->value.buf, expected[n][1]);
+    }
+
+    hpack_header_parser_mrproper (&parser);
+    hpack_header_store_mrproper (&store);
+    hpack_header_encoder_mrproper (&enc);
+    chula_buffer_mrproper (&buf);
+}
+END_TEST
+
+
+START_TEST (differential) {
+    ret_t                  ret;
+    unsigned int           consumed;
+    hpack_header_encoder_t enc;
+    hpack_header_parser_t *parser;
+    hpack_header_store_t   store;
+    hpack_header_field_t  *field;
+    hpack_header_field_t  *expected;
+    chula_buffer_t         buf      = CHULA_BUF_INIT;
+    const char            *blocks[][3][2] = {
+        {{"custom-key", "a"}, {"x-a", "1"}, {"x-b", "2"}},
+        {{"custom-key", "a"}, {"x-a", "1"}, {"x-b", "2"}},
+        {{"custom-key", "a"}, {"x-a", "1"}, {"x-b", "3"}},
+        {{"x-c",        "4"}, {NULL, NULL}, {NULL, NULL}},
+    };
+
+    hpack_header_encoder_init (&enc);
+    hpack_header_encoder_set_differential (&enc, true);
+    hpack_header_store_init (&store);
+    hpack_header_parser_new (&parser);
+    hpack_header_parser_reg_store (parser, &store);
+
+    for (int i=0; i<4; i++) {
+        uint32_t num = 0;
+
+        hpack_header_encoder_clean (&enc);
+        hpack_header_store_mrproper (&store);
+        hpack_header_store_init (&store);
+
+        for (int n=0; (n < 3) && (blocks[i][n][0] != NULL); n++) {
+            chula_buffer_t name;
+            chula_buffer_t value;
+
+            chula_buffer_fake (&name,  blocks[i][n][0], strlen (blocks[i][n][0]));
+            chula_buffer_fake (&value, blocks[i][n][1], strlen (blocks[i][n][1]));
+            hpack_header_encoder_add (&enc, &name, &value);
+            num++;
+        }
+
+        chula_buffer_clean (&buf);
+        ret = hpack_header_encoder_render (&enc, &buf);
+        ch_assert (ret == ret_ok);
+
+        switch (i) {
+        case 1:
+            /* Nothing changed */
+            ch_assert (buf.len == 0);
+            break;
+        case 2:
+            /* x-b: 2 is removed from the Reference Set */
+            ch_assert ((uint8_t) buf.buf[0] == 0x81);
+            break;
+        case 3:
+            /* Cheaper to empty it */
+            ch_assert ((uint8_t) buf.buf[0] == 0x30);
+            break;
+        }
+
+        consumed = 0;
+        ret = hpack_header_parser_all (parser, &buf, 0, &consumed);
+        ch_assert (ret == ret_ok);
+        ch_assert (consumed == buf.len);
+
+        /* Emitted in the order of the store */
+        for (uint32_t n=0; n < num; n++) {
+            ret = hpack_header_store_get_n (&store, n + 1, &field);
+            ch_assert (ret == ret_ok);
+            ret = hpack_header_store_get_n (&enc.store, n + 1, &expected);
+            ch_assert (ret == ret_ok);
+            ch_assert (chula_buffer_cmp_buf (&field->name,  &expected->name)  == 0);
+            ch_assert (chula_buffer_cmp_buf (&field->value, &expected->value) == 0);
+        }
+
+        ret = hpack_header_store_get_n (&store, num + 1, &field);
+        ch_assert (ret != ret_ok);
+    }
+
+    hpack_header_parser_mrproper (&parser);
+    hpack_header_store_mrproper (&store);
+    hpack_header_encoder_mrproper (&enc);
+    chula_buffer_mrproper (&buf);
+}
+END_TEST
+
+
+START_TEST (render_batch) {
+    ret_t                        ret;
+    unsigned int                 consumed;
+    hpack_header_encoder_t       enc[2];
+    hpack_header_parser_t       *parser[2];
+    hpack_header_store_t         fields[2];
+    hpack_header_store_t         decoded;
+    hpack_header_field_t        *field;
+    hpack_header_encoder_batch_t batch[3];
+    chula_buffer_t               arena  = CHULA_BUF_INIT;
+    chula_buffer_t               name   = CHULA_BUF_INIT_FAKE("custom-key");
+    const char                  *values[] = {"stream-1", "stream-2", "stream-3"};
+
+    for (int i=0; i<2; i++) {
+        hpack_header_encoder_init (&enc[i]);
+        hpack_header_store_init (&fields[i]);
+        hpack_header_parser_new (&parser[i]);
+    }
+    hpack_header_store_init (&decoded);
+
+    /* Two streams of the first connection, one of the second */
+    for (int i=0; i<3; i++) {
+        hpack_header_field_t f;
+        chula_buffer_t       value;
+
+        chula_buffer_fake (&value, values[i], strlen (values[i]));
+        hpack_header_field_init (&f);
+        hpack_header_field_borrow (&f, &name, &value);
+
+        if (i == 1) {
+            hpack_header_encoder_add_field (&enc[1], &f);
+        } else {
+            hpack_header_store_add (&fields[i / 2], &f);
+        }
+
+        hpack_header_field_mrproper (&f);
+    }
+
+    batch[0] = (hpack_header_encoder_batch_t) {.enc = &enc[0], .fields = &fields[0]};
+    batch[1] = (hpack_header_encoder_batch_t) {.enc = &enc[1], .fields = NULL};
+    batch[2] = (hpack_header_encoder_batch_t) {.enc = &enc[0], .fields = &fields[1]};
+
+    ret = hpack_header_encoder_render_batch (batch, 3, &arena);
+    ch_assert (ret == ret_ok);
+    ch_assert (batch[0].offset == 0);
+    ch_assert (batch[2].offset + batch[2].len == arena.len);
+
+    /* The fields are given back */
+    ch_assert (hpack_header_store_get_n (&fields[1], 1, &field) == ret_ok);
+    ch_assert (hpack_header_store_get_n (&enc[0].store, 1, &field) == ret_not_found);
+
+    /* Each Header Block decodes on its own connection */
+    for (int i=0; i<3; i++) {
+        chula_buffer_t block;
+        int            conn = (i == 1) ? 1 : 0;
+
+        chula_buffer_fake (&block, (const char *) arena.buf + batch[i].offset, batch[i].len);
+
+        hpack_header_store_mrproper (&decoded);
+        hpack_header_store_init (&decoded);
+        hpack_header_parser_reg_store (parser[conn], &decoded);
+
+        consumed = 0;
+        ret = hpack_header_parser_all (parser[conn], &block, 0, &consumed);
+        ch_assert (ret == ret_ok);
+        ch_assert (consumed == block.len);
+
+        ret = hpack_header_store_get_n (&decoded, 1, &field);
+        ch_assert (ret == ret_ok);
+        ch_assert (field->value.len == strlen (values[i]));
+        ch_assert (memcmp (field->value.buf, values[i], field->value.len) == 0);
+    }
+
+    for (int i=0; i<2; i++) {
+        hpack_header_parser_mrproper (&parser[i]);
+        hpack_header_store_mrproper (&fields[i]);
+        hpack_header_encoder_mrproper (&enc[i]);
+    }
+    hpack_header_store_mrproper (&decoded);
+    chula_buffer_mrproper (&arena);
+}
+END_TEST
+
+START_TEST (render_batch_room) {
+    ret_t                        ret;
+    unsigned int                 consumed = 0;
+    hpack_header_encoder_t       enc;
+    hpack_header_parser_t       *parser;
+    hpack_header_store_t         fields;
+    hpack_header_store_t         decoded;
+    hpack_header_field_t         f;
+    hpack_header_field_t        *field;
+    hpack_header_encoder_batch_t batch;
+    hpack_set_t                  evicted;
+    chula_mem_policy_counter_t   policy;
+    chula_buffer_t               arena  = CHULA_BUF_INIT;
+    char                         value[256];
+
+    /* Octets with 30 and 28 bit long Huffman codes */
+    for (unsigned int i=0; i < sizeof(value); i++) {
+        value[i] = (i & 1) ? '\xf9' : '\x16';
+    }
+
+    hpack_header_encoder_init (&enc);
+    hpack_header_parser_new (&parser);
+    hpack_header_store_init (&fields);
+    hpack_header_store_init (&decoded);
+    hpack_header_field_init (&f);
+
+    /* Memory the encoder would otherwise get while rendering */
+    chula_buffer_add_str (&f.name, "warm-up");
+    hpack_header_table_add (&enc.table, &f, evicted);
+    hpack_header_table_add (&parser->context.table, &f, evicted);
+    chula_buffer_ensure_size (&enc.tmp, 4 * sizeof(value));
+
+    hpack_header_field_clean (&f);
+    chula_buffer_add_str (&f.name, "custom-key");
+    chula_buffer_add (&f.value, value, sizeof(value));
+    hpack_header_store_add (&fields, &f);
+
+    batch = (hpack_header_encoder_batch_t) {.enc = &enc, .fields = &fields};
+
+    /* The arena is allocated once, and never grows */
+    chula_mem_policy_counter_init (&policy);
+    chula_mem_mgr_set_policy (&mem_mgr, MEM_POLICY(&policy));
+
+    ret = hpack_header_encoder_render_batch (&batch, 1, &arena);
+
+    chula_mem_mgr_reset (&mem_mgr);
+    chula_mem_policy_counter_mrproper (&policy);
+
+    ch_assert (ret == ret_ok);
+    ch_assert (batch.len > 3 * sizeof(value));
+    ch_assert (policy.n_malloc == 1);
+    ch_assert (policy.n_realloc == 0);
+
+    hpack_header_parser_reg_store (parser, &decoded);
+    ret = hpack_header_parser_all (parser, &arena, 0, &consumed);
+    ch_assert (ret == ret_ok);
+    ch_assert (consumed == arena.len);
+
+    ret = hpack_header_store_get_n (&decoded, 1, &field);
+    ch_assert (ret == ret_ok);
+    ch_assert (field->value.len == sizeof(value));
+    ch_assert (memcmp (field->value.buf, value, sizeof(value)) == 0);
+
+    hpack_header_field_mrproper (&f);
+    hpack_header_parser_mrproper (&parser);
+    hpack_header_store_mrproper (&fields);
+    hpack_header_store_mrproper (&decoded);
+    hpack_header_encoder_mrproper (&enc);
+    chula_buffer_mrproper (&arena);
+}
+END_TEST
+
 
 int
 basics (void)
@@ -90,7 +917,19 @@ basics (void)
     Suite *s1 = suite_create("Basic header encoding");
     check_add (s1, init_mrproper);
     check_add (s1, add);
+    check_add (s1, adopt);
     check_add (s1, encode1);
+    check_add (s1, clean);
+    check_add (s1, render_iov);
+    check_add (s1, render_frames);
+    check_add (s1, render_batch);
+    check_add (s1, render_batch_room);
+    check_add (s1, render_bounded);
+    check_add (s1, sensitive);
+    check_add (s1, table_size);
+    check_add (s1, snapshot_restore);
+    check_add (s1, reorder);
+    check_add (s1, differential);
     run_test (s1);
 }
 
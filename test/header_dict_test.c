@@ -0,0 +1,215 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <libhpack/libhpack.h>
+#include <libchula-qa/libchula-qa.h>
+#include <libchula-qa/testing_macros-internal.h>
+
+
+static void
+dict_add (hpack_header_dict_t *dict, const char *name, const char *value)
+{
+    ret_t                ret;
+    hpack_header_field_t field;
+
+    hpack_header_field_init (&field);
+    chula_buffer_add (&field.name, name, strlen(name));
+    chula_buffer_add (&field.value, value, strlen(value));
+
+    ret = hpack_header_dict_add (dict, &field);
+    ch_assert (ret == ret_ok);
+
+    hpack_header_field_mrproper (&field);
+}
+
+static void
+assert_entry (hpack_header_table_t *table, uint16_t n, const char *name, const char *value)
+{
+    ret_t                ret;
+    bool                 is_static;
+    hpack_header_field_t field;
+
+    hpack_header_field_init (&field);
+
+    ret = hpack_header_table_get (table, n, false, &field, &is_static);
+    ch_assert (ret == ret_ok);
+    ch_assert (! is_static);
+    ch_assert_str_eq (field.name.buf, name);
+    ch_assert_str_eq (field.value.buf, value);
+
+    hpack_header_field_mrproper (&field);
+}
+
+
+START_TEST (build) {
+    ret_t                ret;
+    hpack_header_dict_t *dict;
+    hpack_header_field_t field;
+
+    ret = hpack_header_dict_new (&dict);
+    ch_assert (ret == ret_ok);
+    ch_assert (dict->refs == 1);
+
+    dict_add (dict, "user-agent", "libhpack");
+    dict_add (dict, "accept-encoding", "gzip, deflate");
+    ch_assert (dict->table.num_headers == 2);
+
+    hpack_header_dict_freeze (dict);
+
+    hpack_header_field_init (&field);
+    chula_buffer_add_str (&field.name, "x-late");
+
+    ret = hpack_header_dict_add (dict, &field);
+    ch_assert (ret == ret_deny);
+    ch_assert (dict->table.num_headers == 2);
+
+    hpack_header_field_mrproper (&field);
+
+    hpack_header_dict_unref (&dict);
+    ch_assert (dict == NULL);
+}
+END_TEST
+
+START_TEST (copy_on_write) {
+    ret_t                ret;
+    hpack_header_dict_t *dict;
+    hpack_header_table_t table1;
+    hpack_header_table_t table2;
+    hpack_header_field_t field;
+    hpack_set_t          evicted;
+
+    hpack_header_dict_new (&dict);
+    dict_add (dict, "user-agent", "libhpack");
+    dict_add (dict, "accept-encoding", "gzip, deflate");
+
+    hpack_header_table_init (&table1);
+    hpack_header_table_init (&table2);
+
+    ret  = hpack_header_table_attach_dict (&table1, dict);
+    ret += hpack_header_table_attach_dict (&table2, dict);
+    ch_assert (ret == ret_ok);
+    ch_assert (dict->refs == 3);
+    ch_assert (dict->frozen);
+
+    assert_entry (&table1, 1, "accept-encoding", "gzip, deflate");
+    assert_entry (&table2, 2, "user-agent", "libhpack");
+
+    /* The tables have no memory for entries of their own yet */
+    ch_assert (table1.storage == NULL);
+    ch_assert (table2.storage == NULL);
+    ch_assert (table1.headers_data.buffer == dict->table.headers_data.buffer);
+
+    /* Table 1 diverges */
+    hpack_header_field_init (&field);
+    chula_buffer_add_str (&field.name, "custom-key");
+    chula_buffer_add_str (&field.value, "custom-value");
+
+    ret = hpack_header_table_add (&table1, &field, evicted);
+    ch_assert (ret == ret_ok);
+    ch_assert (table1.shared == NULL);
+    ch_assert (table1.storage != NULL);
+    ch_assert (table1.headers_data.buffer != dict->table.headers_data.buffer);
+    ch_assert (dict->refs == 2);
+
+    assert_entry (&table1, 1, "custom-key", "custom-value");
+    assert_entry (&table1, 2, "accept-encoding", "gzip, deflate");
+    assert_entry (&table1, 3, "user-agent", "libhpack");
+
+    /* Neither Table 2 nor the dictionary changed */
+    ch_assert (table2.num_headers == 2);
+    ch_assert (table2.storage == NULL);
+    ch_assert (dict->table.num_headers == 2);
+    assert_entry (&table2, 1, "accept-encoding", "gzip, deflate");
+
+    hpack_header_field_mrproper (&field);
+    hpack_header_table_mrproper (&table1);
+    hpack_header_table_mrproper (&table2);
+    ch_assert (dict->refs == 1);
+
+    hpack_header_dict_unref (&dict);
+}
+END_TEST
+
+START_TEST (parser) {
+    ret_t                  ret;
+    chula_buffer_t         raw;
+    hpack_header_dict_t   *dict;
+    hpack_header_parser_t *parser;
+    hpack_header_field_t   field;
+    unsigned int           consumed;
+
+    hpack_header_dict_new (&dict);
+    dict_add (dict, "user-agent", "libhpack");
+
+    hpack_header_parser_new (&parser);
+    hpack_header_field_init (&field);
+
+    ret = hpack_header_table_attach_dict (&parser->context.table, dict);
+    ch_assert (ret == ret_ok);
+
+    /* Indexed: the first entry of the dictionary */
+    chula_buffer_fake_str (&raw, "\x81");
+
+    ret = hpack_header_parser_field (parser, &raw, 0, &field, &consumed);
+    ch_assert (ret == ret_ok);
+    ch_assert (consumed == 1);
+    ch_assert_str_eq (field.name.buf, "user-agent");
+    ch_assert_str_eq (field.value.buf, "libhpack");
+    ch_assert (parser->context.table.shared == dict);
+
+    hpack_header_field_mrproper (&field);
+    hpack_header_parser_mrproper (&parser);
+    ch_assert (dict->refs == 1);
+
+    hpack_header_dict_unref (&dict);
+}
+END_TEST
+
+
+int
+dict (void)
+{
+    Suite *s1 = suite_create("Header Dictionary");
+    check_add (s1, build);
+    check_add (s1, copy_on_write);
+    check_add (s1, parser);
+    run_test (s1);
+}
+
+int
+header_dict_tests (void)
+{
+    int ret;
+
+    ret = dict();
+    return ret;
+}
@@ -119,7 +119,7 @@ START_TEST (_set_max_no_table_evict_all) {
     ret = hpack_header_table_set_max (table, 0, evicted);
     ch_assert (ret == ret_ok);
 
-    hpack_set_is_full(evicted);
+    ch_assert (hpack_set_is_full (evicted));
 
     ch_assert (table->max_data == 0);
     check_table_empty (table);
@@ -417,6 +417,125 @@ START_TEST (_add_doesnt_fit) {
 }
 END_TEST
 
+START_TEST (_snapshot_restore) {
+    ret_t                  ret;
+    hpack_header_table_t  *table;
+    hpack_header_table_t  *restored;
+    hpack_set_t            evicted_set;
+    hpack_header_field_t   field;
+    hpack_header_field_t   field2;
+    chula_buffer_t         snapshot    = CHULA_BUF_INIT;
+    unsigned int           consumed    = 0;
+    bool                   is_static;
+
+    hpack_header_table_new (&table);
+    hpack_header_table_new (&restored);
+    hpack_header_field_init (&field);
+    hpack_header_field_init (&field2);
+
+    /* Enough entries to evict and wrap the circular buffers around */
+    for (int i=0; i<200; ++i) {
+        hpack_header_field_clean (&field);
+        chula_buffer_add_va (&field.name,  "custom-key-%d", i);
+        chula_buffer_add_va (&field.value, "custom-value-%d", i * 7919);
+
+        ret = hpack_header_table_add (table, &field, evicted_set);
+        ch_assert (ret_ok == ret);
+    }
+
+    ret = hpack_header_table_snapshot (table, &snapshot);
+    ch_assert (ret_ok == ret);
+
+    ret = hpack_header_table_restore (restored, &snapshot, 0, &consumed);
+    ch_assert (ret_ok == ret);
+    ch_assert (consumed == snapshot.len);
+
+    ch_assert (restored->num_headers == table->num_headers);
+    ch_assert (restored->used_data == table->used_data);
+    ch_assert (restored->max_data == table->max_data);
+
+    for (uint16_t n=1; n <= table->num_headers; ++n) {
+        hpack_header_field_clean (&field);
+        hpack_header_field_clean (&field2);
+
+        hpack_header_table_get (table, n, false, &field, &is_static);
+        hpack_header_table_get (restored, n, false, &field2, &is_static);
+        ch_assert_str_eq (field.name.buf, field2.name.buf);
+        ch_assert_str_eq (field.value.buf, field2.value.buf);
+    }
+
+    /* Truncated */
+    snapshot.len -= 1;
+    ret = hpack_header_table_restore (restored, &snapshot, 0, &consumed);
+    ch_assert (ret_error == ret);
+
+    /* Clean up */
+    chula_buffer_mrproper (&snapshot);
+    hpack_header_field_mrproper (&field);
+    hpack_header_field_mrproper (&field2);
+    hpack_header_table_free (table);
+    hpack_header_table_free (restored);
+}
+END_TEST
+
+START_TEST (_find) {
+    ret_t                  ret;
+    hpack_header_table_t  *table;
+    hpack_set_t            evicted_set;
+    hpack_header_field_t   field;
+    uint16_t               n;
+    bool                   name_only;
+    bool                   is_static;
+    chula_buffer_t         name        = CHULA_BUF_INIT_FAKE("custom-key");
+    chula_buffer_t         value       = CHULA_BUF_INIT_FAKE("custom-value");
+    chula_buffer_t         other       = CHULA_BUF_INIT_FAKE("other-value");
+    chula_buffer_t         method      = CHULA_BUF_INIT_FAKE(":method");
+    chula_buffer_t         get         = CHULA_BUF_INIT_FAKE("GET");
+    chula_buffer_t         unknown     = CHULA_BUF_INIT_FAKE("x-unknown");
+
+    hpack_header_table_new (&table);
+    hpack_header_field_init (&field);
+
+    /* Static Table */
+    ret = hpack_header_table_find (table, &method, &get, &n, &name_only);
+    ch_assert (ret_ok == ret);
+    ch_assert (! name_only);
+
+    hpack_header_table_get (table, n, false, &field, &is_static);
+    ch_assert (is_static);
+    ch_assert_str_eq (field.value.buf, "GET");
+
+    /* Unknown name */
+    ret = hpack_header_table_find (table, &unknown, &get, &n, &name_only);
+    ch_assert (ret_not_found == ret);
+
+    /* Dynamic entries, the newest one first */
+    hpack_header_field_clean (&field);
+    chula_buffer_add_buffer (&field.name, &name);
+    chula_buffer_add_buffer (&field.value, &value);
+    hpack_header_table_add (table, &field, evicted_set);
+    hpack_header_table_add (table, &field, evicted_set);
+
+    ret = hpack_header_table_find (table, &name, &value, &n, &name_only);
+    ch_assert (ret_ok == ret);
+    ch_assert (! name_only);
+    ch_assert (n == 1);
+
+    ret = hpack_header_table_find (table, &name, &other, &n, &name_only);
+    ch_assert (ret_ok == ret);
+    ch_assert (name_only);
+
+    hpack_header_field_clean (&field);
+    hpack_header_table_get (table, n, true, &field, &is_static);
+    ch_assert (! is_static);
+    ch_assert_str_eq (field.name.buf, "custom-key");
+
+    /* Clean up */
+    hpack_header_field_mrproper (&field);
+    hpack_header_table_free (table);
+}
+END_TEST
+
 //
 //START_TEST (_add_multi_evac) {
 //END_TEST
@@ -455,6 +574,75 @@ START_TEST (field_get_len) {
 }
 END_TEST
 
+START_TEST (field_borrow) {
+    ret_t                 ret;
+    hpack_header_table_t  table;
+    hpack_header_field_t  field;
+    hpack_header_field_t  copy;
+    uint8_t              *own;
+    bool                  is_static;
+    hpack_set_t           evicted_set;
+
+    hpack_header_table_init (&table);
+    hpack_header_field_init (&field);
+    hpack_header_field_init (&copy);
+
+    chula_buffer_add_str (&field.name, "custom-key");
+    own = field.name.buf;
+
+    /* :status: 200 */
+    hpack_header_field_clean (&field);
+    ret = hpack_header_table_get_static (&table, 8, &field);
+    ch_assert (ret == ret_ok);
+    ch_assert (field.borrowed);
+    ch_assert (field.static_idx == hpack_static_status_200);
+    ch_assert_str_eq (field.name.buf, ":status");
+    ch_assert_str_eq (field.value.buf, "200");
+
+    /* The Static Table cannot be modified through the field */
+    ret = chula_buffer_add_str (&field.value, "0");
+    ch_assert (ret == ret_deny);
+    ret = chula_buffer_ensure_size (&field.name, 64);
+    ch_assert (ret == ret_deny);
+    ch_assert_str_eq (field.value.buf, "200");
+
+    /* Copies own their data and keep the tag */
+    hpack_header_field_copy (&copy, &field);
+    ch_assert (! copy.borrowed);
+    ch_assert (copy.static_idx == hpack_static_status_200);
+    ch_assert_str_eq (copy.value.buf, "200");
+
+    /* Cleaning gives the field its own buffers back */
+    hpack_header_field_clean (&field);
+    ch_assert (! field.borrowed);
+    ch_assert (field.name.buf == own);
+
+    /* Only the Static Table can be borrowed */
+    ret = hpack_header_table_get_static (&table, 0, &field);
+    ch_assert (ret == ret_not_found);
+    ret = hpack_header_table_get_static (&table, STATIC_ENTRIES + 1, &field);
+    ch_assert (ret == ret_not_found);
+
+    /* The tag does not depend on the Header Table size */
+    chula_buffer_add_str (&field.name, "custom-key");
+    hpack_header_table_add (&table, &field, evicted_set);
+    hpack_header_field_clean (&field);
+
+    ret = hpack_header_table_get (&table, 9, false, &field, &is_static);
+    ch_assert (ret == ret_ok);
+    ch_assert (! field.borrowed);
+
+    hpack_header_field_clean (&field);
+    ret = hpack_header_table_get_static (&table, 9, &field);
+    ch_assert (ret == ret_ok);
+    ch_assert (field.static_idx == hpack_static_status_200);
+
+    hpack_header_field_mrproper (&field);
+    hpack_header_field_mrproper (&copy);
+    hpack_header_table_mrproper (&table);
+}
+END_TEST
+
 
 int
 blocks (void)
@@ -469,6 +657,8 @@ blocks (void)
     check_add (s1, _add_fits);
     check_add (s1, _add_doesnt_fit);
     check_add (s1, _add_some_evacs);
+    check_add (s1, _snapshot_restore);
+    check_add (s1, _find);
     run_test (s1);
 }
 
@@ -477,6 +667,7 @@ fields (void)
 {
     Suite *s1 = suite_create("Header Fields");
     check_add (s1, field_get_len);
+    check_add (s1, field_borrow);
     run_test (s1);
 }
 
@@ -230,10 +230,52 @@ START_TEST (indexed) {
     ch_assert_str_eq (field.name.buf, ":method");
     ch_assert_str_eq (field.value.buf, "GET");
 
+    /* Emitted from the Static Table, without copying it */
+    ch_assert (field.static_idx == hpack_static_method_get);
+    ch_assert (field.borrowed);
+
+    /* The Header Table entry keeps the tag */
+    assert_header_table_n_eq (parser, 1, ":method", "GET");
+
     ret = hpack_header_parser_field (parser, &raw, consumed, &field, &consumed);
     ch_assert (ret_eof == ret);
     ch_assert (0 == consumed);
     ch_assert (hpack_header_field_is_empty (&field));
+    ch_assert (! field.borrowed);
+    ch_assert (field.static_idx == hpack_static_none);
+
+    hpack_header_field_mrproper (&field);
+    hpack_header_parser_mrproper (&parser);
+}
+END_TEST
+
+START_TEST (literal_indexed_name) {
+    ret_t                  ret;
+    chula_buffer_t         raw;
+    hpack_header_parser_t *parser;
+    hpack_header_field_t   field;
+    unsigned int           consumed = 0;
+
+    hpack_header_parser_new (&parser);
+    hpack_header_field_init (&field);
+
+    /* :method: GET, from the Static Table into the Header Table */
+    chula_buffer_fake_str (&raw, "\x82");
+    ret = hpack_header_parser_field (parser, &raw, 0, &field, &consumed);
+    ch_assert (ret == ret_ok);
+    ch_assert (field.static_idx == hpack_static_method_get);
+
+    /* A new value for the name of that Header Table entry */
+    hpack_header_field_clean (&field);
+    chula_buffer_fake_str (&raw, "\x41\x04POST");
+
+    consumed = 0;
+    ret = hpack_header_parser_field (parser, &raw, 0, &field, &consumed);
+    ch_assert (ret == ret_ok);
+    ch_assert (consumed == raw.len);
+    ch_assert_str_eq (field.name.buf, ":method");
+    ch_assert_str_eq (field.value.buf, "POST");
+    ch_assert (field.static_idx == hpack_static_none);
 
     hpack_header_field_mrproper (&field);
     hpack_header_parser_mrproper (&parser);
@@ -699,6 +741,278 @@ START_TEST (request2_full_huffman) {
 }
 END_TEST
 
+START_TEST (snapshot_restore) {
+    ret_t                  ret;
+    chula_buffer_t         raw;
+    chula_buffer_t         snapshot = CHULA_BUF_INIT;
+    hpack_header_store_t   store;
+    hpack_header_parser_t *parser;
+    hpack_header_parser_t *migrated;
+    hpack_header_field_t   field;
+    hpack_header_field_t  *emitted;
+    hpack_atoms_t          atoms;
+    bool                   is_static;
+    unsigned int           consumed = 0;
+
+    hpack_header_parser_new (&parser);
+    hpack_header_parser_new (&migrated);
+
+    /* First Request */
+    chula_buffer_fake_str (&raw, "\x82\x87\x86\x44\x8c\xf1\xe3\xc2\xe5\xf2\x3a\x6b\xa0\xab\x90\xf4\xff");
+
+    ret = hpack_header_parser_all (parser, &raw, 0, &consumed);
+    ch_assert (ret == ret_ok);
+
+    /* Move the context to a different parser */
+    ret = hpack_header_parser_snapshot (parser, &snapshot);
+    ch_assert (ret == ret_ok);
+
+    ret = hpack_header_parser_restore (migrated, &snapshot, 0, &consumed);
+    ch_assert (ret == ret_ok);
+    ch_assert (consumed == snapshot.len);
+
+    /* Restored entries are not tagged */
+    for (uint16_t n=1; n <= migrated->context.table.num_headers; n++) {
+        hpack_header_field_init (&field);
+        ret = hpack_header_table_get (&migrated->context.table, n, false, &field, &is_static);
+        ch_assert (ret == ret_ok);
+        ch_assert (! is_static);
+        ch_assert (field.static_idx == hpack_static_none);
+        hpack_header_field_mrproper (&field);
+    }
+
+    /* Second Request: it relies on the Reference Set */
+    chula_buffer_fake_str (&raw, "\x5c\x86\xa8\xeb\x10\x64\x9c\xbf");
+
+    hpack_header_store_init (&store);
+    hpack_header_parser_reg_store (migrated, &store);
+    hpack_atoms_init (&atoms);
+    hpack_header_parser_set_atoms (migrated, &atoms);
+
+    consumed = 0;
+    ret = hpack_header_parser_all (migrated, &raw, 0, &consumed);
+    ch_assert (ret == ret_ok);
+    ch_assert (consumed == raw.len);
+
+    assert_store_n_eq (migrated, 1, "cache-control", "no-cache");
+    assert_store_n_eq (migrated, 2, ":method", "GET");
+    assert_store_n_eq (migrated, 3, ":scheme", "http");
+    assert_store_n_eq (migrated, 4, ":path", "/");
+    assert_store_n_eq (migrated, 5, ":authority", "www.example.com");
+
+    /* Atoms of the restored entries come from their names */
+    ret = hpack_header_store_get_n (&store, 2, &emitted);
+    ch_assert (ret == ret_ok);
+    ch_assert (emitted->static_idx == hpack_static_none);
+    ch_assert (emitted->atom == hpack_atoms_static (&atoms, hpack_static_method_get));
+
+    ch_assert (233 == hpack_header_table_get_size (&migrated->context.table));
+
+    /* Unsupported version */
+    snapshot.buf[HPACK_SNAPSHOT_MAGIC_LEN] += 1;
+    ret = hpack_header_parser_restore (migrated, &snapshot, 0, &consumed);
+    ch_assert (ret == ret_deny);
+
+    /* Clean up */
+    chula_buffer_mrproper (&snapshot);
+    hpack_header_store_mrproper (&store);
+    hpack_header_parser_mrproper (&parser);
+    hpack_header_parser_mrproper (&migrated);
+    hpack_atoms_mrproper (&atoms);
+}
+END_TEST
+
+START_TEST (limits) {
+    ret_t                        ret;
+    chula_buffer_t               raw;
+    hpack_header_parser_t       *parser;
+    hpack_header_parser_limits_t limits;
+    hpack_header_field_t         field;
+    unsigned int                 consumed;
+
+    /* :method, :scheme, :path and :authority: 180 octets */
+    chula_buffer_t request1 = CHULA_BUF_INIT_FAKE("\x82\x87\x86\x44\x8c\xf1\xe3\xc2\xe5\xf2\x3a\x6b\xa0\xab\x90\xf4\xff");
+
+    /* Too many fields */
+    memset (&limits, 0, sizeof(limits));
+    limits.max_fields = 3;
+
+    hpack_header_parser_new (&parser);
+    hpack_header_parser_set_limits (parser, &limits);
+
+    consumed = 0;
+    ret = hpack_header_parser_all (parser, &request1, 0, &consumed);
+    ch_assert (ret == ret_deny);
+    ch_assert (parser->error == hpack_parser_error_too_many_fields);
+    hpack_header_parser_mrproper (&parser);
+
+    /* Header list size: the :authority value is rejected before decoding it */
+    memset (&limits, 0, sizeof(limits));
+    limits.max_header_list_size = 150;
+
+    hpack_header_parser_new (&parser);
+    hpack_header_parser_set_limits (parser, &limits);
+
+    consumed = 0;
+    ret = hpack_header_parser_all (parser, &request1, 0, &consumed);
+    ch_assert (ret == ret_deny);
+    ch_assert (parser->error == hpack_parser_error_header_list_size);
+    ch_assert (consumed == 3);
+    hpack_header_parser_mrproper (&parser);
+
+    /* String length: decoding stops at the limit */
+    memset (&limits, 0, sizeof(limits));
+    limits.max_string_len = 10;
+
+    hpack_header_parser_new (&parser);
+    hpack_header_parser_set_limits (parser, &limits);
+
+    consumed = 0;
+    ret = hpack_header_parser_all (parser, &request1, 0, &consumed);
+    ch_assert (ret == ret_deny);
+    ch_assert (parser->error == hpack_parser_error_string_too_long);
+
+    /* A raw string is rejected before its octets arrive */
+    chula_buffer_fake_str (&raw, "\x00\x03\x66\x6f\x6f\x7f\x80\x07\x62\x61\x72");
+
+    hpack_header_field_init (&field);
+
+    ret = hpack_header_parser_field (parser, &raw, 0, &field, &consumed);
+    ch_assert (ret == ret_deny);
+    ch_assert (parser->error == hpack_parser_error_string_too_long);
+
+    hpack_header_field_mrproper (&field);
+    hpack_header_parser_mrproper (&parser);
+
+    /* The header list size is accounted per Header Block */
+    memset (&limits, 0, sizeof(limits));
+    limits.max_header_list_size = 240;
+
+    hpack_header_parser_new (&parser);
+    hpack_header_parser_set_limits (parser, &limits);
+
+    consumed = 0;
+    ret = hpack_header_parser_all (parser, &request1, 0, &consumed);
+    ch_assert (ret == ret_ok);
+    ch_assert (parser->block_size == 180);
+
+    chula_buffer_fake_str (&raw, "\x5c\x86\xa8\xeb\x10\x64\x9c\xbf");
+
+    consumed = 0;
+    ret = hpack_header_parser_all (parser, &raw, 0, &consumed);
+    ch_assert (ret == ret_ok);
+    ch_assert (parser->block_size == 233);
+    ch_assert (parser->block_fields == 5);
+
+    hpack_header_parser_mrproper (&parser);
+}
+END_TEST
+
+static ret_t
+bomb_cb (const hpack_header_parser_counters_t *counters,
+         hpack_header_parser_counter_t         counter,
+         void                                 *data)
+{
+    UNUSED (counters);
+    UNUSED (counter);
+
+    *(int *)data += 1;
+    return ret_ok;
+}
+
+START_TEST (bomb_counters) {
+    ret_t                            ret;
+    chula_buffer_t                   raw;
+    hpack_header_parser_t           *parser;
+    hpack_header_parser_thresholds_t thresholds;
+    unsigned int                     consumed;
+    int                              calls     = 0;
+
+    /* :method, :scheme, :path and :authority: 52 decoded octets */
+    chula_buffer_t request1 = CHULA_BUF_INIT_FAKE("\x82\x87\x86\x44\x8c\xf1\xe3\xc2\xe5\xf2\x3a\x6b\xa0\xab\x90\xf4\xff");
+
+    /* Counters are kept even without thresholds */
+    hpack_header_parser_new (&parser);
+
+    consumed = 0;
+    ret = hpack_header_parser_all (parser, &request1, 0, &consumed);
+    ch_assert (ret == ret_ok);
+    ch_assert (parser->counters.wire_len == request1.len);
+    ch_assert (parser->counters.decoded_len == 52);
+    ch_assert (parser->counters.evictions == 0);
+
+    /* Shrinking the table evicts every entry */
+    chula_buffer_fake_str (&raw, "\x20");
+
+    consumed = 0;
+    ret = hpack_header_parser_all (parser, &raw, 0, &consumed);
+    ch_assert (ret == ret_ok);
+    ch_assert (parser->counters.evictions == 4);
+    ch_assert (parser->counters.size_updates == 1);
+    hpack_header_parser_mrproper (&parser);
+
+    /* Ratio: the slack lets small blocks through */
+    memset (&thresholds, 0, sizeof(thresholds));
+    thresholds.max_ratio   = 2;
+    thresholds.ratio_slack = 60;
+
+    hpack_header_parser_new (&parser);
+    hpack_header_parser_set_bomb_detection (parser, &thresholds, NULL, NULL);
+
+    consumed = 0;
+    ret = hpack_header_parser_all (parser, &request1, 0, &consumed);
+    ch_assert (ret == ret_ok);
+    hpack_header_parser_mrproper (&parser);
+
+    thresholds.ratio_slack = 40;
+
+    hpack_header_parser_new (&parser);
+    hpack_header_parser_set_bomb_detection (parser, &thresholds, NULL, NULL);
+
+    consumed = 0;
+    ret = hpack_header_parser_all (parser, &request1, 0, &consumed);
+    ch_assert (ret == ret_deny);
+    ch_assert (parser->error == hpack_parser_error_bomb);
+    hpack_header_parser_mrproper (&parser);
+
+    /* Repeated references: the callback is called once, and lets it go on */
+    memset (&thresholds, 0, sizeof(thresholds));
+    thresholds.max_repeated_refs = 2;
+    chula_buffer_fake_str (&raw, "\x82\x81\x81\x81\x81\x81");
+
+    hpack_header_parser_new (&parser);
+    hpack_header_parser_set_bomb_detection (parser, &thresholds, bomb_cb, &calls);
+
+    consumed = 0;
+    ret = hpack_header_parser_all (parser, &raw, 0, &consumed);
+    ch_assert (ret == ret_ok);
+    ch_assert (parser->counters.repeated_refs == 5);
+    ch_assert (calls == 1);
+
+    /* Without a callback the Header Block is rejected */
+    hpack_header_parser_set_bomb_detection (parser, &thresholds, NULL, NULL);
+
+    consumed = 0;
+    ret = hpack_header_parser_all (parser, &raw, 0, &consumed);
+    ch_assert (ret == ret_deny);
+    ch_assert (parser->error == hpack_parser_error_bomb);
+    hpack_header_parser_mrproper (&parser);
+
+    /* Size updates */
+    memset (&thresholds, 0, sizeof(thresholds));
+    thresholds.max_size_updates = 2;
+    chula_buffer_fake_str (&raw, "\x20\x20\x20");
+
+    hpack_header_parser_new (&parser);
+    hpack_header_parser_set_bomb_detection (parser, &thresholds, NULL, NULL);
+
+    consumed = 0;
+    ret = hpack_header_parser_all (parser, &raw, 0, &consumed);
+    ch_assert (ret == ret_deny);
+    ch_assert (consumed == 2);
+    hpack_header_parser_mrproper (&parser);
+}
+END_TEST
 
 
 int
@@ -709,6 +1023,7 @@ header_fields (void)
     check_add (s1, literal_w_index_false_len);
     check_add (s1, literal_wo_index);
     check_add (s1, indexed);
+    check_add (s1, literal_indexed_name);
     check_add (s1, indexed_big_value);
     check_add (s1, indexed_many_zeroes);
     check_add (s1, request1);
@@ -723,6 +1038,9 @@ header_full (void)
     check_add (s1, request1_full);
     check_add (s1, request1_full_huffman);
     check_add (s1, request2_full_huffman);
+    check_add (s1, snapshot_restore);
+    check_add (s1, limits);
+    check_add (s1, bomb_counters);
     run_test (s1);
 }
 
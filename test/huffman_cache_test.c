@@ -0,0 +1,254 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <libhpack/libhpack.h>
+#include <libchula-qa/libchula-qa.h>
+#include <libchula-qa/testing_macros-internal.h>
+
+#define LONG_STR  "Mozilla/5.0 (X11; Linux x86_64; rv:29.0) Gecko/20100101 Firefox/29.0"
+#define SHORT_STR "gzip"
+
+extern chula_mem_mgr_t mem_mgr;
+
+
+static void
+encode (const char *str, chula_buffer_t *encoded)
+{
+    chula_buffer_t in;
+
+    chula_buffer_fake (&in, str, strlen(str));
+    chula_buffer_init (encoded);
+    hpack_huffman_encode (&in, encoded);
+}
+
+
+START_TEST (hit_miss) {
+    ret_t                 ret;
+    hpack_huffman_cache_t cache;
+    chula_buffer_t        encoded;
+    chula_buffer_t        out     = CHULA_BUF_INIT;
+
+    hpack_huffman_cache_init (&cache);
+    encode (LONG_STR, &encoded);
+
+    for (int i=0; i<3; i++) {
+        chula_buffer_clean (&out);
+
+        ret = hpack_huffman_cache_decode (&cache, &encoded, &out, HPACK_HUFFMAN_NO_LIMIT);
+        ch_assert (ret == ret_ok);
+        ch_assert_str_eq (out.buf, LONG_STR);
+    }
+
+    ch_assert (cache.misses == 1);
+    ch_assert (cache.hits == 2);
+    ch_assert (cache.size > encoded.len + out.len);
+
+    hpack_huffman_cache_clear (&cache);
+    ch_assert (cache.size == 0);
+
+    hpack_huffman_cache_mrproper (&cache);
+    chula_buffer_mrproper (&encoded);
+    chula_buffer_mrproper (&out);
+}
+END_TEST
+
+START_TEST (short_bypass) {
+    ret_t                 ret;
+    hpack_huffman_cache_t cache;
+    chula_buffer_t        encoded;
+    chula_buffer_t        out     = CHULA_BUF_INIT;
+
+    hpack_huffman_cache_init (&cache);
+    encode (SHORT_STR, &encoded);
+    ch_assert (encoded.len < cache.min_len);
+
+    ret = hpack_huffman_cache_decode (&cache, &encoded, &out, HPACK_HUFFMAN_NO_LIMIT);
+    ch_assert (ret == ret_ok);
+    ch_assert_str_eq (out.buf, SHORT_STR);
+
+    ch_assert (cache.hits == 0);
+    ch_assert (cache.misses == 0);
+    ch_assert (cache.size == 0);
+
+    hpack_huffman_cache_mrproper (&cache);
+    chula_buffer_mrproper (&encoded);
+    chula_buffer_mrproper (&out);
+}
+END_TEST
+
+START_TEST (evict) {
+    ret_t                 ret;
+    hpack_huffman_cache_t cache;
+    chula_buffer_t        encoded1;
+    chula_buffer_t        encoded2;
+    chula_buffer_t        out      = CHULA_BUF_INIT;
+
+    hpack_huffman_cache_init (&cache);
+    encode (LONG_STR, &encoded1);
+    encode (LONG_STR "!", &encoded2);
+
+    /* Room for a single entry */
+    ret = hpack_huffman_cache_configure (&cache, 2 * sizeof(hpack_huffman_cache_entry_t), 1);
+    ch_assert (ret == ret_ok);
+
+    hpack_huffman_cache_decode (&cache, &encoded1, &out, HPACK_HUFFMAN_NO_LIMIT);
+    hpack_huffman_cache_decode (&cache, &encoded2, &out, HPACK_HUFFMAN_NO_LIMIT);
+    hpack_huffman_cache_decode (&cache, &encoded1, &out, HPACK_HUFFMAN_NO_LIMIT);
+    ch_assert (cache.misses == 3);
+    ch_assert (cache.hits == 0);
+    ch_assert (cache.size <= cache.max_size);
+
+    /* No room at all */
+    hpack_huffman_cache_configure (&cache, 0, 1);
+    ch_assert (cache.size == 0);
+
+    chula_buffer_clean (&out);
+    ret = hpack_huffman_cache_decode (&cache, &encoded1, &out, HPACK_HUFFMAN_NO_LIMIT);
+    ch_assert (ret == ret_ok);
+    ch_assert_str_eq (out.buf, LONG_STR);
+    ch_assert (cache.size == 0);
+
+    hpack_huffman_cache_mrproper (&cache);
+    chula_buffer_mrproper (&encoded1);
+    chula_buffer_mrproper (&encoded2);
+    chula_buffer_mrproper (&out);
+}
+END_TEST
+
+START_TEST (nomem) {
+    ret_t                         ret;
+    hpack_huffman_cache_t         cache;
+    chula_buffer_t                encoded;
+    chula_buffer_t                out     = CHULA_BUF_INIT;
+    chula_mem_policy_sched_fail_t policy;
+
+    hpack_huffman_cache_init (&cache);
+    encode (LONG_STR, &encoded);
+    chula_buffer_ensure_size (&out, 2 * sizeof(LONG_STR));
+
+    /* The entry cannot be allocated: the string is decoded anyway */
+    chula_mem_policy_sched_fail_init (&policy, 0, UINT32_MAX);
+    chula_mem_mgr_set_policy (&mem_mgr, MEM_POLICY(&policy));
+
+    ret = hpack_huffman_cache_decode (&cache, &encoded, &out, HPACK_HUFFMAN_NO_LIMIT);
+
+    chula_mem_mgr_reset (&mem_mgr);
+    chula_mem_policy_sched_fail_mrproper (&policy);
+
+    ch_assert (ret == ret_ok);
+    ch_assert_str_eq (out.buf, LONG_STR);
+    ch_assert (policy.counter > 0);
+    ch_assert (cache.misses == 1);
+    ch_assert (cache.size == 0);
+
+    /* It is cached once memory is back */
+    chula_buffer_clean (&out);
+    ret = hpack_huffman_cache_decode (&cache, &encoded, &out, HPACK_HUFFMAN_NO_LIMIT);
+    ch_assert (ret == ret_ok);
+    ch_assert_str_eq (out.buf, LONG_STR);
+    ch_assert (cache.misses == 2);
+    ch_assert (cache.size > 0);
+
+    hpack_huffman_cache_mrproper (&cache);
+    chula_buffer_mrproper (&encoded);
+    chula_buffer_mrproper (&out);
+}
+END_TEST
+
+START_TEST (parser) {
+    ret_t                  ret;
+    chula_buffer_t         raw;
+    hpack_header_parser_t  parser;
+    hpack_huffman_cache_t  cache;
+    hpack_header_field_t   field;
+    unsigned int           consumed;
+
+    hpack_huffman_cache_init (&cache);
+    hpack_huffman_cache_configure (&cache, HPACK_HUFFMAN_CACHE_MAX_SIZE, 1);
+
+    hpack_header_field_init (&field);
+    hpack_header_parser_init (&parser);
+    hpack_header_parser_set_huffman_cache (&parser, &cache);
+
+    /* Literal without indexing: custom-key: custom-value (Huffman) */
+    chula_buffer_fake_str (&raw, "\x00\x88\x25\xa8\x49\xe9\x5b\xa9\x7d\x7f\x89\x25\xa8\x49\xe9\x5b\xb8\xe8\xb4\xbf");
+
+    for (int i=0; i<2; i++) {
+        ret = hpack_header_parser_field (&parser, &raw, 0, &field, &consumed);
+        ch_assert (ret == ret_ok);
+        ch_assert (consumed == raw.len);
+        ch_assert_str_eq (field.name.buf, "custom-key");
+        ch_assert_str_eq (field.value.buf, "custom-value");
+    }
+
+    ch_assert (cache.misses == 2);
+    ch_assert (cache.hits == 2);
+
+    /* Never indexed: the value is not cached */
+    chula_buffer_fake_str (&raw, "\x10\x88\x25\xa8\x49\xe9\x5b\xa9\x7d\x7f\x89\x25\xa8\x49\xe9\x5b\xb8\xe8\xb4\xbf");
+
+    for (int i=0; i<2; i++) {
+        ret = hpack_header_parser_field (&parser, &raw, 0, &field, &consumed);
+        ch_assert (ret == ret_ok);
+        ch_assert (field.flags.rep == rep_never_indx);
+        ch_assert_str_eq (field.value.buf, "custom-value");
+    }
+
+    ch_assert (cache.misses == 2);
+    ch_assert (cache.hits == 4);
+
+    hpack_header_field_mrproper (&field);
+    hpack_huffman_cache_mrproper (&cache);
+}
+END_TEST
+
+
+int
+huffman_cache (void)
+{
+    Suite *s1 = suite_create("Huffman Cache");
+    check_add (s1, hit_miss);
+    check_add (s1, short_bypass);
+    check_add (s1, evict);
+    check_add (s1, nomem);
+    check_add (s1, parser);
+    run_test (s1);
+}
+
+int
+huffman_cache_tests (void)
+{
+    int ret;
+
+    ret = huffman_cache();
+    return ret;
+}
@@ -233,6 +233,34 @@ START_TEST (decode_cookie) {
     decode_test (HUFF_COOKIE_HUFF, HUFF_COOKIE_TEXT);
 }
 END_TEST
+START_TEST (decode_limit) {
+    ret_t                          ret;
+    chula_buffer_t                 A;
+    chula_buffer_t                 B       = CHULA_BUF_INIT;
+    hpack_huffman_decode_context_t context = HUFFMAN_DEC_CTX_INIT;
+
+    chula_buffer_fake (&A, HUFF_EXAMPLE_HUFF, sizeof(HUFF_EXAMPLE_HUFF)-1);
+
+    /* Exactly the decoded length */
+    context.limit = sizeof(HUFF_EXAMPLE_TEXT)-1;
+    ret = hpack_huffman_decode (&A, &B, &context);
+    ch_assert (ret == ret_ok);
+    ch_assert (context.limit == 0);
+    ch_assert_str_eq (B.buf, HUFF_EXAMPLE_TEXT);
+
+    /* One octet short */
+    chula_buffer_clean (&B);
+    context = (hpack_huffman_decode_context_t) HUFFMAN_DEC_CTX_INIT;
+    context.limit = sizeof(HUFF_EXAMPLE_TEXT)-2;
+
+    ret = hpack_huffman_decode (&A, &B, &context);
+    ch_assert (ret == ret_deny);
+    ch_assert (B.len == sizeof(HUFF_EXAMPLE_TEXT)-2);
+    ch_assert (B.size <= sizeof(HUFF_EXAMPLE_TEXT));
+
+    chula_buffer_mrproper (&B);
+}
+END_TEST
 
 /* Encode-Decode
  */
@@ -281,6 +309,7 @@ decode (void)
     check_add (s1, decode_url);
     check_add (s1, decode_gzip);
     check_add (s1, decode_cookie);
+    check_add (s1, decode_limit);
     run_test (s1);
 }
 
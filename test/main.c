@@ -31,6 +31,12 @@
  */
 
 #include <libhpack/libhpack.h>
+#include <libchula-qa/libchula-qa.h>
+
+/* Tests that fail or count allocations set their own policy, and reset it
+ * back to the system one when they are done.
+ */
+chula_mem_mgr_t mem_mgr;
 
 int header_table_tests (void);
 int integer_tests (void);
@@ -38,18 +44,36 @@ int huffman_tests (void);
 int header_tests (void);
 int bitmap_set_tests (void);
 int header_encoding_tests (void);
+int huffman_cache_tests (void);
+int header_dict_tests (void);
+int atom_tests (void);
+int validate_tests (void);
+int stats_tests (void);
+int pressure_tests (void);
+int decode_service_tests (void);
 
 int
 main (void)
 {
     int re;
 
+    chula_mem_mgr_init (&mem_mgr);
+    chula_mem_mgr_reset (&mem_mgr);
+
     re  = header_encoding_tests();
     re += integer_tests();
     re += huffman_tests();
+    re += huffman_cache_tests();
     re += bitmap_set_tests();
     re += header_table_tests();
+    re += header_dict_tests();
     re += header_tests();
+    re += atom_tests();
+    re += validate_tests();
+    re += stats_tests();
+    re += pressure_tests();
+    re += decode_service_tests();
 
+    chula_mem_mgr_mrproper (&mem_mgr);
     return re;
 }
@@ -0,0 +1,135 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <libhpack/libhpack.h>
+#include <libchula-qa/libchula-qa.h>
+#include <libchula-qa/testing_macros-internal.h>
+
+
+static void
+advertise (hpack_header_parser_t *parser,
+           uint16_t               size,
+           void                  *data)
+{
+    UNUSED(parser);
+    *(uint16_t *) data = size;
+}
+
+START_TEST (watermarks) {
+    ret_t                  ret;
+    hpack_pressure_t       pressure;
+    hpack_header_encoder_t enc[3];
+    hpack_header_parser_t *parser;
+    uint16_t               advertised = 0;
+
+    hpack_pressure_init (&pressure);
+    hpack_header_parser_new (&parser);
+
+    for (int i=0; i<3; i++) {
+        hpack_header_encoder_init (&enc[i]);
+    }
+
+    /* One of them is already small */
+    hpack_header_encoder_set_table_size (&enc[1], 128);
+
+    ret = hpack_pressure_configure (&pressure, 500, 1000, 256);
+    ch_assert (ret == ret_error);
+    ret = hpack_pressure_configure (&pressure, 1000, 500, 256);
+    ch_assert (ret == ret_ok);
+
+    hpack_pressure_add_encoder (&pressure, &enc[0]);
+    hpack_pressure_add_encoder (&pressure, &enc[1]);
+    hpack_pressure_add_decoder (&pressure, parser, advertise, &advertised);
+
+    /* Under the high watermark */
+    hpack_pressure_update (&pressure, 900);
+    ch_assert (! pressure.shrunk);
+    ch_assert (! enc[0].resize);
+    ch_assert (advertised == 0);
+
+    /* Over it */
+    hpack_pressure_update (&pressure, 1200);
+    ch_assert (pressure.shrunk);
+    ch_assert (enc[0].resize && enc[0].resize_to == 256);
+    ch_assert (enc[1].resize && enc[1].resize_to == 128);
+    ch_assert (advertised == 256);
+
+    /* Registered while under pressure */
+    hpack_pressure_add_encoder (&pressure, &enc[2]);
+    ch_assert (enc[2].resize && enc[2].resize_to == 256);
+
+    /* Between the watermarks */
+    hpack_pressure_update (&pressure, 800);
+    ch_assert (pressure.shrunk);
+
+    /* Under the low one */
+    hpack_pressure_update (&pressure, 400);
+    ch_assert (! pressure.shrunk);
+    ch_assert (pressure.shrinks == 1);
+    ch_assert (enc[0].resize_to == SETTINGS_HEADER_TABLE_SIZE);
+    ch_assert (enc[1].resize_to == 128);
+    ch_assert (enc[2].resize_to == SETTINGS_HEADER_TABLE_SIZE);
+    ch_assert (advertised == SETTINGS_HEADER_TABLE_SIZE);
+
+    ret = hpack_pressure_remove_encoder (&pressure, &enc[0]);
+    ch_assert (ret == ret_ok);
+    ret = hpack_pressure_remove_encoder (&pressure, &enc[0]);
+    ch_assert (ret == ret_not_found);
+    ret = hpack_pressure_remove_decoder (&pressure, parser);
+    ch_assert (ret == ret_ok);
+
+    for (int i=0; i<3; i++) {
+        hpack_header_encoder_mrproper (&enc[i]);
+    }
+
+    hpack_header_parser_mrproper (&parser);
+    hpack_pressure_mrproper (&pressure);
+}
+END_TEST
+
+
+int
+pressure (void)
+{
+    Suite *s1 = suite_create("Memory pressure");
+    check_add (s1, watermarks);
+    run_test (s1);
+}
+
+int
+pressure_tests (void)
+{
+    int ret;
+
+    ret = pressure();
+    return ret;
+}
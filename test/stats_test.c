@@ -0,0 +1,179 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <libhpack/libhpack.h>
+#include <libchula-qa/libchula-qa.h>
+#include <libchula-qa/testing_macros-internal.h>
+
+
+START_TEST (parser) {
+    ret_t                  ret;
+    chula_buffer_t         raw;
+    hpack_header_parser_t *parser;
+    hpack_stats_t          stats;
+    unsigned int           consumed;
+
+    hpack_stats_init (&stats);
+    hpack_header_parser_new (&parser);
+    hpack_header_parser_set_stats (parser, &stats);
+
+    /* First Request: 3 indexed, :authority with a Huffman encoded value */
+    chula_buffer_fake_str (&raw, "\x82\x87\x86\x44\x8c\xf1\xe3\xc2\xe5\xf2\x3a\x6b\xa0\xab\x90\xf4\xff");
+
+    consumed = 0;
+    ret = hpack_header_parser_all (parser, &raw, 0, &consumed);
+    ch_assert (ret == ret_ok);
+
+    ch_assert (stats.reps[rep_indexed] == 3);
+    ch_assert (stats.reps[rep_inc_indexed] == 1);
+    ch_assert (stats.strings_huffman == 1);
+    ch_assert (stats.strings_raw == 0);
+    ch_assert (stats.fields == 4);
+    ch_assert (stats.wire_len == 17);
+    ch_assert (stats.decoded_len == 52);
+
+    /* Second Request: 1 new field, 4 from the Reference Set */
+    chula_buffer_fake_str (&raw, "\x5c\x86\xa8\xeb\x10\x64\x9c\xbf");
+
+    consumed = 0;
+    ret = hpack_header_parser_all (parser, &raw, 0, &consumed);
+    ch_assert (ret == ret_ok);
+
+    ch_assert (stats.reps[rep_inc_indexed] == 2);
+    ch_assert (stats.strings_huffman == 2);
+    ch_assert (stats.fields == 9);
+    ch_assert (stats.wire_len == 25);
+    ch_assert (stats.decoded_len == 125);
+    ch_assert (stats.evictions == 0);
+
+    /* Empty the Header Table */
+    chula_buffer_fake_str (&raw, "\x20");
+
+    consumed = 0;
+    ret = hpack_header_parser_all (parser, &raw, 0, &consumed);
+    ch_assert (ret == ret_ok);
+
+    ch_assert (stats.size_updates == 1);
+    ch_assert (stats.evictions == 5);
+    ch_assert (stats.wire_len == 26);
+
+    hpack_header_parser_mrproper (&parser);
+}
+END_TEST
+
+START_TEST (encoder) {
+    ret_t                  ret;
+    hpack_header_encoder_t enc;
+    hpack_stats_t         *stats;
+    chula_buffer_t         buf   = CHULA_BUF_INIT;
+    chula_buffer_t         name  = CHULA_BUF_INIT_FAKE("name");
+    chula_buffer_t         value = CHULA_BUF_INIT_FAKE("value");
+
+    hpack_stats_new (&stats);
+    hpack_header_encoder_init (&enc);
+    hpack_header_encoder_set_stats (&enc, stats);
+
+    hpack_header_encoder_add (&enc, &name, &value);
+
+    ret = hpack_header_encoder_render (&enc, &buf);
+    ch_assert (ret == ret_ok);
+
+    ch_assert (stats->reps[rep_inc_indexed] == 1);
+    ch_assert (stats->fields == 1);
+    ch_assert (stats->strings_huffman == 2);
+    ch_assert (stats->wire_len == buf.len);
+    ch_assert (stats->decoded_len == 9);
+
+    /* The next Header Block references it */
+    ret = hpack_header_encoder_render (&enc, &buf);
+    ch_assert (ret == ret_ok);
+
+    ch_assert (stats->reps[rep_indexed] == 1);
+    ch_assert (stats->fields == 2);
+    ch_assert (stats->wire_len == buf.len);
+
+    hpack_header_encoder_mrproper (&enc);
+    chula_buffer_mrproper (&buf);
+    hpack_stats_free (stats);
+}
+END_TEST
+
+START_TEST (add_repr) {
+    hpack_stats_t  stats;
+    hpack_stats_t  total;
+    chula_buffer_t repr  = CHULA_BUF_INIT;
+
+    hpack_stats_init (&stats);
+    hpack_stats_init (&total);
+
+    stats.reps[rep_never_indx] = 2;
+    stats.fields               = 2;
+    stats.wire_len             = 30;
+
+    hpack_stats_add (&total, &stats);
+    hpack_stats_add (&total, &stats);
+
+    ch_assert (total.reps[rep_never_indx] == 4);
+    ch_assert (total.fields == 4);
+    ch_assert (total.wire_len == 60);
+
+    hpack_stats_repr (&total, &repr);
+    ch_assert (strstr ((char *)repr.buf, "fields=4 ") != NULL);
+    ch_assert (strstr ((char *)repr.buf, "never_indexed=4") != NULL);
+    ch_assert (strstr ((char *)repr.buf, "wire=60 ") != NULL);
+
+    hpack_stats_reset (&total);
+    ch_assert (total.fields == 0);
+
+    chula_buffer_mrproper (&repr);
+}
+END_TEST
+
+
+int
+stats (void)
+{
+    Suite *s1 = suite_create("Statistics");
+    check_add (s1, parser);
+    check_add (s1, encoder);
+    check_add (s1, add_repr);
+    run_test (s1);
+}
+
+int
+stats_tests (void)
+{
+    int ret;
+
+    ret = stats();
+    return ret;
+}
@@ -0,0 +1,206 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <libhpack/libhpack.h>
+#include <libchula-qa/libchula-qa.h>
+#include <libchula-qa/testing_macros-internal.h>
+
+static const hpack_validate_impl_t impls[] = {
+    hpack_validate_impl_scalar,
+    hpack_validate_impl_sse2,
+    hpack_validate_impl_avx2,
+};
+
+
+START_TEST (names) {
+    ret_t          ret;
+    uint8_t        str[80];
+    chula_buffer_t copy = CHULA_BUF_INIT;
+
+    for (unsigned int i=0; i < sizeof(impls)/sizeof(impls[0]); i++) {
+        if (hpack_validate_set_impl (impls[i]) != ret_ok)
+            continue;
+
+        ch_assert (hpack_validate_name ((const uint8_t *)":path", 5) == ret_ok);
+        ch_assert (hpack_validate_name ((const uint8_t *)"x-forwarded-for_2.0~", 20) == ret_ok);
+        ch_assert (hpack_validate_name ((const uint8_t *)"", 0) == ret_deny);
+        ch_assert (hpack_validate_name ((const uint8_t *)":", 1) == ret_deny);
+        ch_assert (hpack_validate_name ((const uint8_t *)"a:b", 3) == ret_deny);
+
+        /* A forbidden octet in every position of every block */
+        for (uint32_t len=1; len <= sizeof(str); len++) {
+            memset (str, 'a', len);
+            ch_assert (hpack_validate_name (str, len) == ret_ok);
+
+            for (uint32_t pos=0; pos < len; pos++) {
+                str[pos] = (pos & 1) ? 'A' : 0x80;
+                ch_assert (hpack_validate_name (str, len) == ret_deny);
+
+                str[pos] = '_';
+                ch_assert (hpack_validate_name (str, len) == ret_ok);
+            }
+        }
+
+        /* Copies are only committed when valid */
+        chula_buffer_clean (&copy);
+        memset (str, 'z', sizeof(str));
+
+        ret = hpack_validate_copy_name (&copy, str, sizeof(str));
+        ch_assert (ret == ret_ok);
+        ch_assert (copy.len == sizeof(str));
+        ch_assert (memcmp (copy.buf, str, sizeof(str)) == 0);
+
+        str[70] = ' ';
+        ret = hpack_validate_copy_name (&copy, str, sizeof(str));
+        ch_assert (ret == ret_deny);
+        ch_assert (copy.len == sizeof(str));
+    }
+
+    hpack_validate_set_impl (hpack_validate_impl_auto);
+    chula_buffer_mrproper (&copy);
+}
+END_TEST
+
+START_TEST (values) {
+    ret_t          ret;
+    uint8_t        str[80];
+    const uint8_t  forbidden[] = {'\0', '\r', '\n'};
+    chula_buffer_t copy        = CHULA_BUF_INIT;
+
+    for (unsigned int i=0; i < sizeof(impls)/sizeof(impls[0]); i++) {
+        if (hpack_validate_set_impl (impls[i]) != ret_ok)
+            continue;
+
+        ch_assert (hpack_validate_value ((const uint8_t *)"", 0) == ret_ok);
+
+        for (uint32_t len=1; len <= sizeof(str); len++) {
+            memset (str, 0xFF, len);
+            ch_assert (hpack_validate_value (str, len) == ret_ok);
+
+            for (uint32_t pos=0; pos < len; pos++) {
+                str[pos] = forbidden[pos % 3];
+                ch_assert (hpack_validate_value (str, len) == ret_deny);
+
+                str[pos] = 'A';
+                ch_assert (hpack_validate_value (str, len) == ret_ok);
+            }
+        }
+
+        chula_buffer_clean (&copy);
+        memset (str, ' ', sizeof(str));
+
+        ret = hpack_validate_copy_value (&copy, str, sizeof(str));
+        ch_assert (ret == ret_ok);
+        ch_assert (copy.len == sizeof(str));
+        ch_assert (memcmp (copy.buf, str, sizeof(str)) == 0);
+
+        str[sizeof(str)-1] = '\n';
+        ret = hpack_validate_copy_value (&copy, str, sizeof(str));
+        ch_assert (ret == ret_deny);
+        ch_assert (copy.len == sizeof(str));
+    }
+
+    hpack_validate_set_impl (hpack_validate_impl_auto);
+    chula_buffer_mrproper (&copy);
+}
+END_TEST
+
+START_TEST (parser) {
+    ret_t                  ret;
+    chula_buffer_t         raw;
+    hpack_header_parser_t *parser;
+    hpack_header_field_t   field;
+    unsigned int           consumed = 0;
+
+    hpack_header_parser_new (&parser);
+    hpack_header_field_init (&field);
+
+    /* Uppercase name: accepted unless validating */
+    chula_buffer_fake_str (&raw, "\x00\x03\x46\x6f\x6f\x03\x62\x61\x72");
+
+    ret = hpack_header_parser_field (parser, &raw, 0, &field, &consumed);
+    ch_assert (ret == ret_ok);
+    ch_assert_str_eq (field.name.buf, "Foo");
+
+    hpack_header_parser_set_validation (parser, true);
+
+    ret = hpack_header_parser_field (parser, &raw, 0, &field, &consumed);
+    ch_assert (ret == ret_deny);
+    ch_assert (consumed == 0);
+    ch_assert (parser->error == hpack_parser_error_invalid_name);
+
+    /* Value with a CR LF */
+    chula_buffer_fake_str (&raw, "\x00\x03\x66\x6f\x6f\x05\x62\x0d\x0a\x61\x72");
+
+    ret = hpack_header_parser_field (parser, &raw, 0, &field, &consumed);
+    ch_assert (ret == ret_deny);
+    ch_assert (parser->error == hpack_parser_error_invalid_value);
+
+    /* Indexed name (:path) with a valid value */
+    chula_buffer_fake_str (&raw, "\x04\x0c\x2f\x73\x61\x6d\x70\x6c\x65\x2f\x70\x61\x74\x68");
+
+    ret = hpack_header_parser_field (parser, &raw, 0, &field, &consumed);
+    ch_assert (ret == ret_ok);
+    ch_assert (parser->error == hpack_parser_error_none);
+    ch_assert_str_eq (field.value.buf, "/sample/path");
+
+    /* Huffman encoded value: www.example.com */
+    chula_buffer_fake_str (&raw, "\x01\x8c\xf1\xe3\xc2\xe5\xf2\x3a\x6b\xa0\xab\x90\xf4\xff");
+
+    ret = hpack_header_parser_field (parser, &raw, 0, &field, &consumed);
+    ch_assert (ret == ret_ok);
+    ch_assert_str_eq (field.value.buf, "www.example.com");
+
+    hpack_header_field_mrproper (&field);
+    hpack_header_parser_mrproper (&parser);
+}
+END_TEST
+
+
+int
+validate (void)
+{
+    Suite *s1 = suite_create("Validation");
+    check_add (s1, names);
+    check_add (s1, values);
+    check_add (s1, parser);
+    run_test (s1);
+}
+
+int
+validate_tests (void)
+{
+    int ret;
+
+    ret = validate();
+    return ret;
+}
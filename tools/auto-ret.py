@@ -23,7 +23,7 @@ def parse_file (fullpath_h, replacement_pair, func_suffix):
 		cont = f.read()
 
 	# Find functions
-	funcs = re.findall (r'ret_t\s+?[^\\#]+?\(.+?\);', cont, re.S)
+	funcs = re.findall (r'ret_t\s+?[^\\#;]+?\(.+?\);', cont, re.S)
 	if not funcs:
 		return ''
 
@@ -0,0 +1,72 @@
+#!/usr/bin/env python
+
+# Generates the seed corpora of the fuzz targets from the test vectors
+# of the test suite. Run it from the top of the source tree:
+#
+#   ./tools/fuzz-seeds.py fuzz/corpus
+
+import os
+import re
+import sys
+import codecs
+
+def c_strings (path, regex):
+    text = open(path).read()
+    for match in re.finditer (regex, text, re.S):
+        literal = ''.join (re.findall (r'"((?:[^"\\]|\\.)*)"', match.group(1)))
+        yield codecs.escape_decode(literal.encode('latin-1'))[0]
+
+def write (directory, name, data):
+    if not os.path.isdir (directory):
+        os.makedirs (directory)
+    with open (os.path.join (directory, name), 'wb') as f:
+        f.write (data)
+
+def parser_seeds (out):
+    blocks = c_strings ('test/header_test.c', r'chula_buffer_fake_str \(&raw, ("[^;]*")\);')
+    for n, block in enumerate (blocks):
+        # Plain decoding, and with validation + limits + Huffman cache
+        write (out, 'header_test_%02d' %(n), b'\x00' + block)
+        write (out, 'header_test_%02d_opts' %(n), b'\x07' + block)
+
+def huffman_seeds (out):
+    strings = c_strings ('test/huffman_test.c', r'#define HUFF_\w+_HUFF[\s\\]+((?:"[^"]*"[\s\\]*)+)')
+    for n, string in enumerate (strings):
+        write (out, 'huffman_test_%02d' %(n), string)
+
+def integer_seeds (out):
+    # Prefix length - 1, encoded integer: integer_test.c and draft section 4.1.1
+    integers = [(4, b'\x0a'), (4, b'\x1f\x9a\x0a'), (7, b'\x2a'), (6, b'\x7f\x80\x01'),
+                (7, b'\xff\xff\xff\xff\xff\x0a'), (0, b'\x01')]
+    for n, (prefix, data) in enumerate (integers):
+        write (out, 'integer_%02d' %(n), bytes(bytearray([prefix])) + data)
+
+def roundtrip_seeds (out):
+    # Draft-07 Appendix C header lists
+    lists = [
+        [(':method', 'GET'), (':scheme', 'http'), (':path', '/'), (':authority', 'www.example.com')],
+        [('cache-control', 'no-cache'), (':method', 'GET'), (':path', '/')],
+        [(':method', 'GET'), (':scheme', 'https'), (':path', '/index.html'),
+         (':authority', 'www.example.com'), ('custom-key', 'custom-value')],
+        [(':status', '302'), ('cache-control', 'private'), ('date', 'Mon, 21 Oct 2013 20:13:21 GMT'),
+         ('location', 'https://www.example.com')],
+        [('content-encoding', 'gzip'),
+         ('set-cookie', 'foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; max-age=3600; version=1')],
+    ]
+    for n, fields in enumerate (lists):
+        data = b''.join ([(name + '\0' + value + '\0').encode('latin-1') for name, value in fields])
+        write (out, 'draft_c_%02d' %(n), data)
+
+def main():
+    if len(sys.argv) != 2:
+        print ("Usage: %s output-directory" % (sys.argv[0]))
+        raise SystemExit(1)
+
+    out = sys.argv[1]
+    parser_seeds    (os.path.join (out, 'parser'))
+    huffman_seeds   (os.path.join (out, 'huffman'))
+    integer_seeds   (os.path.join (out, 'integer'))
+    roundtrip_seeds (os.path.join (out, 'roundtrip'))
+
+if __name__ == "__main__":
+    main()
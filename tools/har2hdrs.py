@@ -0,0 +1,55 @@
+#!/usr/bin/env python
+
+# Converts HTTP Archive (HAR) files into the corpus format of hpack-replay:
+# a "name: value" header field per line and an empty line after each
+# header list. Requests and responses are written in their HAR order.
+
+import sys
+import json
+
+try:
+    from urlparse import urlparse
+except ImportError:
+    from urllib.parse import urlparse
+
+SKIP = ('connection', 'keep-alive', 'proxy-connection', 'transfer-encoding', 'upgrade', 'host')
+
+def fields (headers):
+    for h in headers:
+        name = h['name'].lower()
+        if name.startswith(':') or name in SKIP:
+            continue
+        yield name, h['value']
+
+def request (req):
+    url = urlparse (req['url'])
+    path = url.path or '/'
+    if url.query:
+        path += '?' + url.query
+
+    lines = [(':method', req['method']), (':scheme', url.scheme),
+             (':authority', url.netloc), (':path', path)]
+    return lines + list(fields (req['headers']))
+
+def response (res):
+    return [(':status', str(res['status']))] + list(fields (res['headers']))
+
+def convert (f_in, f_out):
+    har = json.load (f_in)
+    for entry in har['log']['entries']:
+        for header_list in (request (entry['request']), response (entry['response'])):
+            for name, value in header_list:
+                f_out.write ('%s: %s\n' % (name, value.replace('\n', ' ')))
+            f_out.write ('\n')
+
+def main():
+    if len(sys.argv) < 2:
+        print ("Usage: %s file.har [...] > corpus.hdrs" % (sys.argv[0]))
+        raise SystemExit(1)
+
+    for path in sys.argv[1:]:
+        with open (path) as f:
+            convert (f, sys.stdout)
+
+if __name__ == "__main__":
+    main()